@@ -0,0 +1,104 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_ALIGNEDALLOCATOR_H
+#define QL_IO_ALIGNEDALLOCATOR_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include "BufferPool.h"
+#include "MemoryBudget.h"
+
+namespace qlbase {
+
+/// A std::allocator returning ALIGN bytes aligned memory (a cache line by
+/// default), so the buffers of a std::vector can be read with aligned SIMD
+/// loads. The buffers are taken from the default BufferPool and given back
+/// to it when released, and charged to a MemoryBudget (the global one by
+/// default) for the whole buffer taken from the pool.
+template<class T, size_t ALIGN = 64>
+struct AlignedAllocator {
+
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template<class U>
+	struct rebind {
+		typedef AlignedAllocator<U, ALIGN> other;
+	};
+
+	// a moved vector keeps its buffer and the budget charged for it
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+	BufferPool* pool;
+	MemoryBudget* budget;
+
+	AlignedAllocator(MemoryBudget* budget = 0) : pool(&BufferPool::getDefault()), budget(budget ? budget : &MemoryBudget::getGlobal()) {}
+
+	template<class U>
+	AlignedAllocator(const AlignedAllocator<U, ALIGN>& other) : pool(other.pool), budget(other.budget) {}
+
+	/// \throw qlbase::IOException if the budget is exceeded.
+	T* allocate(size_t n) {
+		size_t bytes = getBytes(n);
+		if(!budget->tryCharge(bytes)) {
+			// the buffers cached by the pool are charged too
+			pool->trim();
+			budget->charge(bytes);
+		}
+		void* p = 0;
+		try {
+			if(ALIGN <= BufferPool::ALIGNMENT)
+				p = pool->allocate(n * sizeof(T));
+			else if(posix_memalign(&p, ALIGN, n * sizeof(T)))
+				throw std::bad_alloc();
+		}
+		catch(...) {
+			budget->release(bytes);
+			throw;
+		}
+		return (T*) p;
+	}
+
+	void deallocate(T* p, size_t n) {
+		if(ALIGN <= BufferPool::ALIGNMENT)
+			pool->release(p, n * sizeof(T));
+		else
+			free(p);
+		budget->release(getBytes(n));
+	}
+
+	/// Get the bytes allocated for n values, as charged to the budget.
+	size_t getBytes(size_t n) const {
+		return ALIGN <= BufferPool::ALIGNMENT ? pool->getBufferSize(n * sizeof(T)) : n * sizeof(T);
+	}
+};
+
+template<class T, class U, size_t ALIGN>
+bool operator==(const AlignedAllocator<T, ALIGN>& a, const AlignedAllocator<U, ALIGN>& b) { return a.pool == b.pool && a.budget == b.budget; }
+
+template<class T, class U, size_t ALIGN>
+bool operator!=(const AlignedAllocator<T, ALIGN>& a, const AlignedAllocator<U, ALIGN>& b) { return !(a == b); }
+
+}
+
+#endif
@@ -0,0 +1,222 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_ARRAYVIEW_H
+#define QL_IO_ARRAYVIEW_H
+
+#include <stdint.h>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+#include "File.h"
+
+namespace qlbase {
+
+/// A non-owning view of an N-dimensional array: a pointer, the size of each
+/// axis and the distance in elements between two consecutive values of each
+/// axis. Axes are in FITS order, axis 0 (NAXIS1) is the fastest one, so
+/// value (x, y) of a contiguous image is data[x + y * sizes[0]].
+///
+/// Crops, planes and transpositions are new views of the same values, no
+/// value is copied. The views are invalid when the array is destroyed or
+/// reallocated.
+///
+/// \code
+/// Image<float> image = file.readImage32f();
+/// ArrayView<float> cube = image.view();
+/// ArrayView<float> plane = cube.plane(2, 10);          // z = 10
+/// ArrayView<float> box = plane.crop(0, 100, 199).crop(1, 50, 99);
+/// Image<double> profile = reduceSum<double>(box, 1);   // sum along y
+/// \endcode
+///
+/// Invalid axes or ranges throw qlbase::IOException.
+template<class T>
+class ArrayView {
+
+public:
+
+	enum { MAXDIMS = 8 };
+
+	ArrayView() : ptr(0), ndim(0) {}
+
+	/// A view of contiguous values.
+	ArrayView(T* data, const std::vector<int64_t>& sizes) : ptr(data), ndim(sizes.size()) {
+		if(sizes.size() > MAXDIMS)
+			throw IOException("Error in ArrayView: too many dimensions", 0);
+		int64_t stride = 1;
+		for(int d=0; d<ndim; d++) {
+			shape[d] = sizes[d];
+			strides[d] = stride;
+			stride *= sizes[d];
+		}
+	}
+
+	ArrayView(T* data, int ndim, const int64_t* shape, const int64_t* strides) : ptr(data), ndim(ndim) {
+		if(ndim < 0 || ndim > MAXDIMS)
+			throw IOException("Error in ArrayView: too many dimensions", 0);
+		for(int d=0; d<ndim; d++) {
+			this->shape[d] = shape[d];
+			this->strides[d] = strides[d];
+		}
+	}
+
+	/// A read only view of the same values.
+	operator ArrayView<const T>() const { return ArrayView<const T>(ptr, ndim, shape, strides); }
+
+	int getDim() const { return ndim; }
+
+	int64_t getSize(int axis) const { return shape[axis]; }
+
+	/// Get the distance in elements between two values along axis.
+	int64_t getStride(int axis) const { return strides[axis]; }
+
+	/// Get the number of values.
+	int64_t count() const {
+		int64_t n = ndim ? 1 : 0;
+		for(int d=0; d<ndim; d++)
+			n *= shape[d];
+		return n;
+	}
+
+	/// Get the first value.
+	T* data() const { return ptr; }
+
+	T& operator()(int64_t x) const { return ptr[x * strides[0]]; }
+	T& operator()(int64_t x, int64_t y) const { return ptr[x * strides[0] + y * strides[1]]; }
+	T& operator()(int64_t x, int64_t y, int64_t z) const { return ptr[x * strides[0] + y * strides[1] + z * strides[2]]; }
+
+	/// Get a value from getDim() indexes.
+	T& at(const int64_t* index) const {
+		int64_t offset = 0;
+		for(int d=0; d<ndim; d++)
+			offset += index[d] * strides[d];
+		return ptr[offset];
+	}
+
+	/// Check if the values are contiguous in FITS order, as in an Image.
+	bool isContiguous() const {
+		int64_t stride = 1;
+		for(int d=0; d<ndim; d++) {
+			if(shape[d] != 1 && strides[d] != stride)
+				return false;
+			stride *= shape[d];
+		}
+		return true;
+	}
+
+	/// Get the values first to last of an axis, every step values.
+	ArrayView crop(int axis, int64_t first, int64_t last, int64_t step = 1) const {
+		check(axis);
+		if(first < 0 || last < first || last >= shape[axis] || step < 1)
+			throw IOException("Error in ArrayView::crop() invalid range", 0);
+
+		ArrayView view(*this);
+		view.ptr += first * strides[axis];
+		view.shape[axis] = (last - first) / step + 1;
+		view.strides[axis] *= step;
+		return view;
+	}
+
+	/// Get the values with index on an axis, without that axis (e.g. a
+	/// plane of a cube, or a row of an image). The view must have at least
+	/// 2 axes.
+	ArrayView plane(int axis, int64_t index) const {
+		check(axis);
+		if(index < 0 || index >= shape[axis] || ndim < 2)
+			throw IOException("Error in ArrayView::plane() invalid index", 0);
+
+		ArrayView view(*this);
+		view.ptr += index * strides[axis];
+		view.ndim--;
+		for(int d=axis; d<view.ndim; d++) {
+			view.shape[d] = shape[d+1];
+			view.strides[d] = strides[d+1];
+		}
+		return view;
+	}
+
+	/// Swap two axes.
+	ArrayView transpose(int a, int b) const {
+		check(a);
+		check(b);
+		ArrayView view(*this);
+		view.shape[a] = shape[b];
+		view.shape[b] = shape[a];
+		view.strides[a] = strides[b];
+		view.strides[b] = strides[a];
+		return view;
+	}
+
+	/// Reverse the axes.
+	ArrayView transpose() const {
+		ArrayView view(*this);
+		for(int d=0; d<ndim; d++) {
+			view.shape[d] = shape[ndim-1-d];
+			view.strides[d] = strides[ndim-1-d];
+		}
+		return view;
+	}
+
+	/// Call f on each value, axis 0 in the inner loop.
+	template<class F>
+	void forEach(F f) const {
+		if(count() == 0)
+			return;
+
+		int64_t index[MAXDIMS] = {0};
+		T* row = ptr;
+		while(true) {
+			T* p = row;
+			for(int64_t x=0; x<shape[0]; x++, p += strides[0])
+				f(*p);
+
+			// next row, carrying to the outer axes
+			int d = 1;
+			for(; d<ndim; d++) {
+				row += strides[d];
+				if(++index[d] < shape[d])
+					break;
+				row -= shape[d] * strides[d];
+				index[d] = 0;
+			}
+			if(d == ndim)
+				return;
+		}
+	}
+
+	/// Copy the values to a contiguous buffer of count() values.
+	void copyTo(typename std::remove_const<T>::type* out) const {
+		if(isContiguous()) {
+			std::copy(ptr, ptr + count(), out);
+			return;
+		}
+		forEach([&out](T& v) { *out++ = v; });
+	}
+
+private:
+
+	T* ptr;
+	int ndim;
+	int64_t shape[MAXDIMS];
+	int64_t strides[MAXDIMS];
+
+	void check(int axis) const {
+		if(axis < 0 || axis >= ndim)
+			throw IOException("Error in ArrayView: invalid axis", 0);
+	}
+};
+
+}
+
+#endif
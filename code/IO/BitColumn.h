@@ -0,0 +1,172 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_BITCOLUMN_H
+#define QL_IO_BITCOLUMN_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace qlbase {
+
+/// The rows of a bit (fits type for es. 16X) or logical (16L) column as
+/// packed bits. Each row takes getWords() 64 bit words, bit j of a row is
+/// bit j % 64 of its word j / 64. Rows of up to 64 flags are one word, so
+/// flag masks are tested on a whole row at once.
+///
+/// \code
+/// BitColumn flags;
+/// file.readBits(4, frow, lrow, flags);
+/// std::vector<long> rows;
+/// flags.select(SATURATED | PILEUP, rows);
+/// \endcode
+class BitColumn {
+
+public:
+
+	BitColumn() : nrows(0), nbits(0), nwords(0) {}
+
+	BitColumn(long nrows, int nbits) : nrows(0), nbits(0), nwords(0) {
+		resize(nrows, nbits);
+	}
+
+	/// Set the number of rows and of bits of each row, all the bits 0.
+	void resize(long nrows, int nbits) {
+		this->nrows = nrows;
+		this->nbits = nbits;
+		nwords = (nbits + 63) / 64;
+		words.assign(nrows * nwords, 0);
+	}
+
+	/// Get the number of rows.
+	long size() const { return nrows; }
+
+	/// Get the number of bits of each row.
+	int getBits() const { return nbits; }
+
+	/// Get the number of words of each row.
+	int getWords() const { return nwords; }
+
+	bool test(long row, int bit) const {
+		return (words[row * nwords + (bit >> 6)] >> (bit & 63)) & 1;
+	}
+
+	void set(long row, int bit, bool value = true) {
+		uint64_t& w = words[row * nwords + (bit >> 6)];
+		if(value)
+			w |= (uint64_t) 1 << (bit & 63);
+		else
+			w &= ~((uint64_t) 1 << (bit & 63));
+	}
+
+	/// Get the bits 64*w to 64*w+63 of a row.
+	uint64_t word(long row, int w = 0) const { return words[row * nwords + w]; }
+
+	/// Get the number of bits set in all the rows.
+	long count() const {
+		long n = 0;
+		for(unsigned long i=0; i<words.size(); i++)
+			n += __builtin_popcountll(words[i]);
+		return n;
+	}
+
+	/// Get the number of rows with a bit set.
+	long count(int bit) const {
+		long n = 0;
+		const uint64_t* w = data() + (bit >> 6);
+		for(long row=0; row<nrows; row++, w += nwords)
+			n += (*w >> (bit & 63)) & 1;
+		return n;
+	}
+
+	/// Append the rows with all the bits of mask set, or with any of them
+	/// if all is false. mask is on the first 64 bits of the rows.
+	/// \return The number of rows appended.
+	long select(uint64_t mask, std::vector<long>& rows, bool all = true) const {
+		long n = 0;
+		const uint64_t* w = data();
+		for(long row=0; row<nrows; row++, w += nwords) {
+			uint64_t hit = *w & mask;
+			if(all ? hit == mask : hit != 0) {
+				rows.push_back(row);
+				n++;
+			}
+		}
+		return n;
+	}
+
+	/// Set the rows from the FITS bytes of a bit column, (getBits() + 7) / 8
+	/// bytes each with the first bit in the most significant one.
+	void setFitsBytes(const uint8_t* bytes) {
+		int nbytes = (nbits + 7) / 8;
+		for(long row=0; row<nrows; row++, bytes += nbytes) {
+			uint64_t* w = &words[row * nwords];
+			for(int i=0; i<nwords; i++)
+				w[i] = 0;
+			for(int b=0; b<nbytes; b++)
+				w[b >> 3] |= (uint64_t) reverse(bytes[b]) << ((b & 7) * 8);
+			if(nbits % 64)
+				w[nwords - 1] &= ((uint64_t) 1 << (nbits % 64)) - 1;
+		}
+	}
+
+	/// Get the rows as FITS bytes of a bit column.
+	void getFitsBytes(uint8_t* bytes) const {
+		int nbytes = (nbits + 7) / 8;
+		for(long row=0; row<nrows; row++, bytes += nbytes) {
+			const uint64_t* w = &words[row * nwords];
+			for(int b=0; b<nbytes; b++)
+				bytes[b] = reverse(w[b >> 3] >> ((b & 7) * 8));
+		}
+	}
+
+	/// Set the rows from the cfitsio logicals, getBits() for each row.
+	void setLogicals(const char* values) {
+		for(long row=0; row<nrows; row++, values += nbits) {
+			uint64_t* w = &words[row * nwords];
+			for(int i=0; i<nwords; i++)
+				w[i] = 0;
+			for(int j=0; j<nbits; j++)
+				w[j >> 6] |= (uint64_t) (values[j] != 0) << (j & 63);
+		}
+	}
+
+	/// Get the rows as cfitsio logicals.
+	void getLogicals(char* values) const {
+		for(long row=0; row<nrows; row++)
+			for(int j=0; j<nbits; j++)
+				*values++ = test(row, j);
+	}
+
+	const uint64_t* data() const { return words.empty() ? 0 : &words[0]; }
+	uint64_t* data() { return words.empty() ? 0 : &words[0]; }
+
+private:
+
+	std::vector<uint64_t> words;
+	long nrows;
+	int nbits;
+	int nwords;
+
+	static uint8_t reverse(uint8_t b) {
+		b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
+		b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
+		b = (b & 0xAA) >> 1 | (b & 0x55) << 1;
+		return b;
+	}
+};
+
+}
+
+#endif
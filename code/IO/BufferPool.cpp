@@ -0,0 +1,329 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <new>
+#include "BufferPool.h"
+
+namespace qlbase {
+
+/// The released buffers of a pool kept by a thread.
+struct BufferPool::ThreadCache {
+	/// 0 after the pool is destroyed.
+	std::atomic<BufferPool*> pool;
+	std::vector<void*> lists[NCLASSES];
+};
+
+/// The caches of a thread, given back to their pools when the thread exits.
+struct BufferPool::ThreadCaches {
+	std::vector<ThreadCache*> caches;
+	~ThreadCaches();
+};
+
+thread_local BufferPool::ThreadCaches BufferPool::threadCaches;
+
+static std::atomic<BufferPool*> defaultPool(0);
+
+// Guards the pools lists of caches against the threads exiting. Never
+// destroyed, threads may exit after the static destructors.
+static std::mutex& registryMutex() {
+	static std::mutex* mutex = new std::mutex;
+	return *mutex;
+}
+
+static int getSizeClass(size_t size) {
+	if(size <= BufferPool::ALIGNMENT)
+		return 0;
+	return 64 - __builtin_clzll(size - 1) - 6;
+}
+
+static void* systemAllocate(size_t size) {
+	void* buffer = 0;
+	if(posix_memalign(&buffer, BufferPool::ALIGNMENT, size))
+		throw std::bad_alloc();
+	return buffer;
+}
+
+BufferPool::ThreadCaches::~ThreadCaches() {
+	std::lock_guard<std::mutex> registry(registryMutex());
+	for(unsigned int i=0; i<caches.size(); i++) {
+		ThreadCache* cache = caches[i];
+		BufferPool* pool = cache->pool.load();
+		if(pool) {
+			std::lock_guard<std::mutex> lock(pool->mutex);
+			for(int c=0; c<NCLASSES; c++)
+				pool->share(c, cache->lists[c], cache->lists[c].size());
+			pool->caches.erase(std::find(pool->caches.begin(), pool->caches.end(), cache));
+		}
+		delete cache;
+	}
+}
+
+BufferPool::BufferPool(size_t threadCacheBytes, size_t sharedCacheBytes, MemoryBudget* budget)
+	: threadCacheBytes(threadCacheBytes), sharedCacheBytes(sharedCacheBytes),
+	  budget(budget ? budget : &MemoryBudget::getGlobal()), hits(0), misses(0), bytesOutstanding(0), highWater(0), bytesCached(0) {
+}
+
+BufferPool::~BufferPool() {
+	std::lock_guard<std::mutex> registry(registryMutex());
+
+	// the caches stay in their threads lists until the threads exit
+	for(unsigned int i=0; i<caches.size(); i++) {
+		for(int c=0; c<NCLASSES; c++)
+			freeBuffers(c, caches[i]->lists[c]);
+		caches[i]->pool.store(0);
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	for(int c=0; c<NCLASSES; c++)
+		freeBuffers(c, shared[c]);
+
+	BufferPool* self = this;
+	defaultPool.compare_exchange_strong(self, 0);
+}
+
+BufferPool& BufferPool::getDefault() {
+	BufferPool* pool = defaultPool.load();
+	if(pool)
+		return *pool;
+
+	// never destroyed, the images may be released by static destructors
+	static BufferPool* initial = new BufferPool;
+	return *initial;
+}
+
+void BufferPool::setDefault(BufferPool* pool) {
+	defaultPool.store(pool);
+}
+
+size_t BufferPool::getBufferSize(size_t size) const {
+	int c = getSizeClass(size);
+	return isCached(c) ? (size_t) ALIGNMENT << c : size;
+}
+
+void* BufferPool::allocate(size_t size) {
+	int c = getSizeClass(size);
+	if(!isCached(c)) {
+		void* buffer = systemAllocate(size);
+		misses++;
+		addOutstanding(size);
+		return buffer;
+	}
+
+	int64_t classSize = (int64_t) ALIGNMENT << c;
+	std::vector<void*>& list = getThreadCache()->lists[c];
+	if(list.empty()) {
+		// refill half of the thread cache at once
+		std::lock_guard<std::mutex> lock(mutex);
+		std::vector<void*>& from = shared[c];
+		size_t n = std::min(from.size(), (size_t) (getLimit(c) + 1) / 2);
+		list.insert(list.end(), from.end() - n, from.end());
+		from.resize(from.size() - n);
+	}
+
+	void* buffer;
+	if(!list.empty()) {
+		buffer = list.back();
+		list.pop_back();
+		hits++;
+		bytesCached -= classSize;
+		budget->release(classSize);
+	}
+	else {
+		buffer = systemAllocate(classSize);
+		misses++;
+	}
+	addOutstanding(classSize);
+	return buffer;
+}
+
+void BufferPool::release(void* buffer, size_t size) {
+	if(!buffer)
+		return;
+
+	int c = getSizeClass(size);
+	if(!isCached(c)) {
+		free(buffer);
+		addOutstanding(-(int64_t) size);
+		return;
+	}
+
+	int64_t classSize = (int64_t) ALIGNMENT << c;
+	addOutstanding(-classSize);
+
+	// under pressure the buffer is freed instead
+	if(!budget->tryCharge(classSize)) {
+		free(buffer);
+		return;
+	}
+
+	std::vector<void*>& list = getThreadCache()->lists[c];
+	list.push_back(buffer);
+	bytesCached += classSize;
+
+	// a full thread cache gives half of its buffers to the other threads
+	int limit = getLimit(c);
+	if((int) list.size() > limit) {
+		std::lock_guard<std::mutex> lock(mutex);
+		share(c, list, list.size() - limit / 2);
+	}
+}
+
+BufferPool::Stats BufferPool::getStats() const {
+	Stats stats;
+	stats.hits = hits.load();
+	stats.misses = misses.load();
+	stats.bytesOutstanding = bytesOutstanding.load();
+	stats.highWater = highWater.load();
+	stats.bytesCached = bytesCached.load();
+	return stats;
+}
+
+void BufferPool::trim() {
+	ThreadCache* cache = findThreadCache();
+	if(cache)
+		for(int c=0; c<NCLASSES; c++)
+			freeBuffers(c, cache->lists[c]);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	for(int c=0; c<NCLASSES; c++)
+		freeBuffers(c, shared[c]);
+}
+
+BufferPool::ThreadCache* BufferPool::findThreadCache() {
+	std::vector<ThreadCache*>& list = threadCaches.caches;
+	for(unsigned int i=0; i<list.size(); i++)
+		if(list[i]->pool.load(std::memory_order_relaxed) == this)
+			return list[i];
+	return 0;
+}
+
+BufferPool::ThreadCache* BufferPool::getThreadCache() {
+	ThreadCache* found = findThreadCache();
+	if(found)
+		return found;
+
+	std::vector<ThreadCache*>& list = threadCaches.caches;
+	std::lock_guard<std::mutex> registry(registryMutex());
+
+	// drop the caches of the destroyed pools
+	for(unsigned int i=0; i<list.size(); ) {
+		if(list[i]->pool.load()) {
+			i++;
+			continue;
+		}
+		delete list[i];
+		list.erase(list.begin() + i);
+	}
+
+	ThreadCache* cache = new ThreadCache;
+	cache->pool.store(this);
+	caches.push_back(cache);
+	list.push_back(cache);
+	return cache;
+}
+
+bool BufferPool::isCached(int sizeClass) const {
+	return sizeClass < NCLASSES && ((size_t) ALIGNMENT << sizeClass) <= threadCacheBytes;
+}
+
+// Called with the mutex locked. The buffers over the shared cache bytes
+// are freed.
+void BufferPool::share(int sizeClass, std::vector<void*>& list, size_t n) {
+	size_t classSize = (size_t) ALIGNMENT << sizeClass;
+	size_t max = sharedCacheBytes / classSize;
+	for(size_t i=list.size()-n; i<list.size(); i++) {
+		if(shared[sizeClass].size() < max) {
+			shared[sizeClass].push_back(list[i]);
+			continue;
+		}
+		free(list[i]);
+		bytesCached -= classSize;
+		budget->release(classSize);
+	}
+	list.resize(list.size() - n);
+}
+
+// Called with the mutex locked, or by the thread of the list.
+void BufferPool::freeBuffers(int sizeClass, std::vector<void*>& list) {
+	int64_t bytes = (int64_t) list.size() * ((int64_t) ALIGNMENT << sizeClass);
+	for(unsigned int i=0; i<list.size(); i++)
+		free(list[i]);
+	list.clear();
+	bytesCached -= bytes;
+	budget->release(bytes);
+}
+
+int BufferPool::getLimit(int sizeClass) const {
+	size_t n = threadCacheBytes / ((size_t) ALIGNMENT << sizeClass);
+	return std::max((size_t) 1, std::min(n, (size_t) 64));
+}
+
+void BufferPool::addOutstanding(int64_t bytes) {
+	int64_t now = bytesOutstanding.fetch_add(bytes) + bytes;
+	int64_t high = highWater.load();
+	while(now > high && !highWater.compare_exchange_weak(high, now))
+		;
+}
+
+Arena::Arena(size_t blockSize, BufferPool& pool)
+	: pool(pool), blockSize(blockSize), next(0), left(0), bytes(0) {
+}
+
+Arena::~Arena() {
+	reset();
+}
+
+void* Arena::allocate(size_t size) {
+	size = size ? (size + 15) & ~(size_t) 15 : 16;
+	if(size <= left) {
+		void* p = next;
+		next += size;
+		left -= size;
+		return p;
+	}
+
+	Block block;
+	block.size = size > blockSize / 2 ? size : blockSize;
+	blocks.reserve(blocks.size() + 1);
+	block.buffer = pool.allocate(block.size);
+	blocks.push_back(block);
+	bytes += block.size;
+
+	// big allocations keep the current block
+	if(block.size != blockSize)
+		return block.buffer;
+
+	next = (char*) block.buffer + size;
+	left = blockSize - size;
+	return block.buffer;
+}
+
+char* Arena::copy(const std::string& s) {
+	char* p = (char*) allocate(s.size() + 1);
+	std::memcpy(p, s.c_str(), s.size() + 1);
+	return p;
+}
+
+void Arena::reset() {
+	for(unsigned int i=0; i<blocks.size(); i++)
+		pool.release(blocks[i].buffer, blocks[i].size);
+	blocks.clear();
+	next = 0;
+	left = 0;
+	bytes = 0;
+}
+
+}
@@ -0,0 +1,187 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_BUFFERPOOL_H
+#define QL_IO_BUFFERPOOL_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include "MemoryBudget.h"
+
+namespace qlbase {
+
+/// A pool of 64 bytes aligned buffers, in power of two size classes from
+/// 64 bytes to the thread cache bytes. Released buffers are kept in a cache
+/// of the releasing thread, taken back without locks by the next
+/// allocations of that class, and moved to a shared cache when the thread
+/// cache is full or the thread exits. The shared cache keeps at most
+/// sharedCacheBytes of each class, the other buffers are freed. Bigger
+/// buffers are allocated and freed each time.
+///
+/// The cached buffers are charged to a MemoryBudget, the global one by
+/// default. A buffer released when the budget is exceeded is freed.
+///
+/// Image pixels (AlignedAllocator) and the temporary buffers of the file
+/// classes (Arena) come from the default pool, replaced with setDefault().
+///
+/// \code
+/// BufferPool::Stats stats = BufferPool::getDefault().getStats();
+/// std::cout << stats.hits << " " << stats.misses << " " << stats.highWater << std::endl;
+/// \endcode
+///
+/// A pool must outlive its buffers and must not be destroyed while used by
+/// other threads.
+class BufferPool {
+
+public:
+
+	enum { ALIGNMENT = 64, NCLASSES = 21 };
+
+	struct Stats {
+		/// Allocations from the caches.
+		long hits;
+		/// Allocations from the system.
+		long misses;
+		/// Bytes in buffers not released, now and at most.
+		int64_t bytesOutstanding;
+		int64_t highWater;
+		/// Bytes in released buffers kept in the caches.
+		int64_t bytesCached;
+	};
+
+	/// \param[in] threadCacheBytes The bytes of each size class kept by
+	/// each thread, also the biggest buffer cached.
+	/// \param[in] sharedCacheBytes The bytes of each size class kept for
+	/// all the threads.
+	/// \param[in] budget The budget charged for the cached buffers, 0 for
+	/// the global one.
+	BufferPool(size_t threadCacheBytes = 4 << 20, size_t sharedCacheBytes = 16 << 20, MemoryBudget* budget = 0);
+
+	~BufferPool();
+
+	/// Get the pool used by the library.
+	static BufferPool& getDefault();
+
+	/// Set the pool used by the library, 0 for the initial one. The
+	/// buffers allocated before go back to their own pool.
+	static void setDefault(BufferPool* pool);
+
+	/// Get the bytes of the buffer allocated for size bytes, its size
+	/// class or size if not cached.
+	size_t getBufferSize(size_t size) const;
+
+	/// Get an aligned buffer of at least size bytes.
+	void* allocate(size_t size);
+
+	/// Give back a buffer, with the size it was allocated with.
+	void release(void* buffer, size_t size);
+
+	Stats getStats() const;
+
+	/// Free the buffers of the shared cache and of the calling thread
+	/// cache.
+	void trim();
+
+private:
+
+	struct ThreadCache;
+	struct ThreadCaches;
+
+	std::mutex mutex;
+	std::vector<void*> shared[NCLASSES];
+	std::vector<ThreadCache*> caches;
+	size_t threadCacheBytes;
+	size_t sharedCacheBytes;
+	MemoryBudget* budget;
+
+	std::atomic<long> hits;
+	std::atomic<long> misses;
+	std::atomic<int64_t> bytesOutstanding;
+	std::atomic<int64_t> highWater;
+	std::atomic<int64_t> bytesCached;
+
+	static thread_local ThreadCaches threadCaches;
+
+	BufferPool(const BufferPool&);
+	BufferPool& operator=(const BufferPool&);
+
+	ThreadCache* findThreadCache();
+	ThreadCache* getThreadCache();
+	bool isCached(int sizeClass) const;
+	int getLimit(int sizeClass) const;
+	void share(int sizeClass, std::vector<void*>& list, size_t n);
+	void freeBuffers(int sizeClass, std::vector<void*>& list);
+	void addOutstanding(int64_t bytes);
+};
+
+/// A scratch allocator for the temporary buffers of one call. Blocks are
+/// taken from a BufferPool and all the allocations are given back at once
+/// by reset() or by the destructor, so a call does not free each buffer.
+///
+/// \code
+/// Arena arena;
+/// char** names = arena.allocate<char*>(nfields);
+/// for(int i=0; i<nfields; i++)
+///     names[i] = arena.copy(fields[i].name);
+/// \endcode
+class Arena {
+
+public:
+
+	/// \param[in] blockSize The bytes taken from the pool at once, bigger
+	/// allocations get a block of their own.
+	Arena(size_t blockSize = 64 << 10, BufferPool& pool = BufferPool::getDefault());
+
+	~Arena();
+
+	/// Get size bytes aligned to 16.
+	void* allocate(size_t size);
+
+	template<class T>
+	T* allocate(size_t n) { return (T*) allocate(n * sizeof(T)); }
+
+	/// Get a null terminated copy of a string.
+	char* copy(const std::string& s);
+
+	/// Give back all the allocations.
+	void reset();
+
+	/// Get the bytes taken from the pool.
+	size_t getBytes() const { return bytes; }
+
+private:
+
+	struct Block {
+		void* buffer;
+		size_t size;
+	};
+
+	BufferPool& pool;
+	std::vector<Block> blocks;
+	size_t blockSize;
+	char* next;
+	size_t left;
+	size_t bytes;
+
+	Arena(const Arena&);
+	Arena& operator=(const Arena&);
+};
+
+}
+
+#endif
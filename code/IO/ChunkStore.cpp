@@ -0,0 +1,160 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "ChunkStore.h"
+#include "File.h"
+
+namespace qlbase {
+
+ChunkStore::ChunkStore(MemoryBudget& budget, const std::string& scratchDir)
+	: budget(budget), scratchDir(scratchDir), scratchFd(-1), scratchSize(0), tick(0), memoryBytes(0), spilledBytes(0) {
+}
+
+ChunkStore::~ChunkStore() {
+	for(unsigned int i=0; i<chunks.size(); i++)
+		if(chunks[i].data)
+			remove(i);
+	if(scratchFd >= 0)
+		close(scratchFd);
+}
+
+int ChunkStore::add(size_t size) {
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t mapSize = size ? (size + page - 1) / page * page : page;
+
+	// make room spilling the coldest chunks, or refuse the chunk
+	while(!budget.tryCharge(mapSize)) {
+		if(scratchDir.empty() || spill(mapSize) == 0) {
+			budget.charge(mapSize);
+			break;
+		}
+	}
+
+	void* data = mmap(0, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+	if(data == MAP_FAILED) {
+		budget.release(mapSize);
+		throw IOException("Error in ChunkStore::add() cannot map the chunk memory", errno);
+	}
+
+	Chunk chunk;
+	chunk.data = (char*) data;
+	chunk.size = size;
+	chunk.mapSize = mapSize;
+	chunk.spilled = false;
+	chunk.lastUse = ++tick;
+	chunks.push_back(chunk);
+	memoryBytes += mapSize;
+	return chunks.size() - 1;
+}
+
+int ChunkStore::add(const void* data, size_t size) {
+	int chunk = add(size);
+	std::memcpy(chunks[chunk].data, data, size);
+	return chunk;
+}
+
+void* ChunkStore::get(int chunk) {
+	_check(chunk, "get");
+	chunks[chunk].lastUse = ++tick;
+	return chunks[chunk].data;
+}
+
+size_t ChunkStore::getSize(int chunk) const {
+	_check(chunk, "getSize");
+	return chunks[chunk].size;
+}
+
+bool ChunkStore::isSpilled(int chunk) const {
+	_check(chunk, "isSpilled");
+	return chunks[chunk].spilled;
+}
+
+void ChunkStore::remove(int chunk) {
+	_check(chunk, "remove");
+	Chunk& c = chunks[chunk];
+	munmap(c.data, c.mapSize);
+	if(c.spilled) {
+		spilledBytes -= c.mapSize;
+	}
+	else {
+		budget.release(c.mapSize);
+		memoryBytes -= c.mapSize;
+	}
+	c.data = 0;
+}
+
+int64_t ChunkStore::spill(int64_t bytes) {
+	if(scratchDir.empty())
+		return 0;
+
+	int64_t released = 0;
+	while(released < bytes) {
+		Chunk* coldest = 0;
+		for(unsigned int i=0; i<chunks.size(); i++)
+			if(chunks[i].data && !chunks[i].spilled && (!coldest || chunks[i].lastUse < coldest->lastUse))
+				coldest = &chunks[i];
+		if(!coldest)
+			break;
+
+		_spill(*coldest);
+		released += coldest->mapSize;
+	}
+	return released;
+}
+
+void ChunkStore::_check(int chunk, const char* method) const {
+	if(chunk < 0 || chunk >= (int) chunks.size() || !chunks[chunk].data)
+		throw IOException(std::string("Error in ChunkStore::") + method + "() invalid chunk", 0);
+}
+
+// The chunk pages are written to the end of the scratch file, then the
+// file pages are mapped over the anonymous ones.
+void ChunkStore::_spill(Chunk& chunk) {
+	if(scratchFd < 0) {
+		std::string path = scratchDir + "/qlbase-spill-XXXXXX";
+		std::vector<char> name(path.begin(), path.end());
+		name.push_back(0);
+		scratchFd = mkstemp(&name[0]);
+		if(scratchFd < 0)
+			throw IOException("Error in ChunkStore::spill() cannot create a scratch file in " + scratchDir, errno);
+		unlink(&name[0]);
+	}
+
+	size_t written = 0;
+	while(written < chunk.mapSize) {
+		ssize_t n = pwrite(scratchFd, chunk.data + written, chunk.mapSize - written, scratchSize + written);
+		if(n < 0 && errno == EINTR)
+			continue;
+		if(n <= 0)
+			throw IOException("Error in ChunkStore::spill() cannot write the scratch file in " + scratchDir, errno);
+		written += n;
+	}
+
+	void* data = mmap(chunk.data, chunk.mapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, scratchFd, scratchSize);
+	if(data == MAP_FAILED)
+		throw IOException("Error in ChunkStore::spill() cannot map the scratch file", errno);
+
+	scratchSize += chunk.mapSize;
+	chunk.spilled = true;
+	budget.release(chunk.mapSize);
+	memoryBytes -= chunk.mapSize;
+	spilledBytes += chunk.mapSize;
+}
+
+}
@@ -0,0 +1,116 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_CHUNKSTORE_H
+#define QL_IO_CHUNKSTORE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "MemoryBudget.h"
+
+namespace qlbase {
+
+/// Column chunks of large in-memory tables, charged to a MemoryBudget. The
+/// readers don't use it, it holds the chunks the callers read into it.
+/// When a new chunk exceeds the budget the least recently used chunks are
+/// spilled: written to a scratch file and mapped back from it at the same
+/// address, so their pointers stay valid and the kernel pages them in on
+/// access. Spilled chunks are no longer charged. Without a scratch
+/// directory, or with nothing left to spill, the chunk is refused with a
+/// qlbase::IOException.
+///
+/// \code
+/// MemoryBudget budget("events", 1LL << 30, &MemoryBudget::getGlobal());
+/// ChunkStore store(budget, "/scratch");
+/// for(long frow=0; frow<nrows; frow+=chunkRows) {
+///     long lrow = std::min(frow + chunkRows, nrows) - 1;
+///     int chunk = store.add((lrow - frow + 1) * sizeof(float));
+///     file.read(2, frow, lrow, (float*) store.get(chunk));
+///     chunks.push_back(chunk);
+/// }
+/// \endcode
+///
+/// The scratch file is removed when created, its space is reclaimed when
+/// the store is destroyed. A ChunkStore is not thread safe.
+class ChunkStore {
+
+public:
+
+	/// \param[in] budget The budget charged for the chunks in memory.
+	/// \param[in] scratchDir The directory of the scratch file, empty to
+	/// refuse the chunks over the budget.
+	ChunkStore(MemoryBudget& budget = MemoryBudget::getGlobal(), const std::string& scratchDir = "");
+
+	~ChunkStore();
+
+	/// Add a chunk of size bytes set to 0.
+	/// \return The chunk number.
+	int add(size_t size);
+
+	/// Add a copy of size bytes.
+	int add(const void* data, size_t size);
+
+	/// Get the bytes of a chunk, marking it as recently used. The pointer is
+	/// valid until remove().
+	void* get(int chunk);
+
+	size_t getSize(int chunk) const;
+
+	bool isSpilled(int chunk) const;
+
+	/// Remove a chunk, releasing its memory.
+	void remove(int chunk);
+
+	/// Spill the least recently used chunks until at least bytes are
+	/// released, e.g. when the budget pressure is high.
+	/// \return The bytes released.
+	int64_t spill(int64_t bytes);
+
+	/// Get the bytes of the chunks in memory, as charged to the budget.
+	int64_t getMemoryBytes() const { return memoryBytes; }
+
+	/// Get the bytes of the spilled chunks.
+	int64_t getSpilledBytes() const { return spilledBytes; }
+
+private:
+
+	struct Chunk {
+		char* data;
+		size_t size;
+		/// The mapped bytes, whole pages.
+		size_t mapSize;
+		bool spilled;
+		uint64_t lastUse;
+	};
+
+	MemoryBudget& budget;
+	std::string scratchDir;
+	std::vector<Chunk> chunks;
+	int scratchFd;
+	int64_t scratchSize;
+	uint64_t tick;
+	int64_t memoryBytes;
+	int64_t spilledBytes;
+
+	ChunkStore(const ChunkStore&);
+	ChunkStore& operator=(const ChunkStore&);
+
+	void _check(int chunk, const char* method) const;
+	void _spill(Chunk& chunk);
+};
+
+}
+
+#endif
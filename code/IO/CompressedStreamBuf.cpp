@@ -0,0 +1,485 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "CompressedStreamBuf.h"
+#include <cstring>
+#include <algorithm>
+#include <zlib.h>
+#ifdef QL_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace qlbase {
+
+// deflate maximum back reference distance
+#define WINSIZE 32768U
+#define CHUNKSIZE 65536U
+
+CompressedStreamBuf::Format CompressedStreamBuf::detect(const std::string& filename) {
+	unsigned char magic[4] = {0, 0, 0, 0};
+
+	FILE* in = fopen(filename.c_str(), "rb");
+	if(!in)
+		return PLAIN;
+	size_t n = fread(magic, 1, 4, in);
+	fclose(in);
+
+	if(n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+		return GZIP;
+	if(n == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd)
+		return ZSTD;
+
+	return PLAIN;
+}
+
+CompressedStreamBuf::CompressedStreamBuf(const std::string& filename, Format format, size_t blockSize,
+                                         int maxBlocks, uint64_t span)
+	: filename(filename), format(format), blockSize(blockSize), span(span), current(0), position(0),
+	  stopping(false), finished(false) {
+
+	if(maxBlocks < 1 || blockSize == 0)
+		throw IOException("Error in CompressedStreamBuf::CompressedStreamBuf() ", 0);
+
+	// one more block for the consumer
+	blocks.resize(maxBlocks+1);
+	for(unsigned int i=0; i<blocks.size(); i++)
+	{
+		blocks[i].data.resize(blockSize);
+		empty.push_back(&blocks[i]);
+	}
+
+	setg(0, 0, 0);
+	start(0);
+}
+
+CompressedStreamBuf::~CompressedStreamBuf() {
+	stop();
+}
+
+int CompressedStreamBuf::getCheckpointNum() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return checkpoints.size();
+}
+
+CompressedStreamBuf::int_type CompressedStreamBuf::underflow() {
+	if(gptr() < egptr())
+		return traits_type::to_int_type(*gptr());
+
+	// the wanted position: the end of the current block or a seek target
+	uint64_t want = position + (gptr() - eback());
+
+	std::unique_lock<std::mutex> lock(mutex);
+	while(true) {
+		if(current) {
+			empty.push_back(current);
+			current = 0;
+			setg(0, 0, 0);
+			cond.notify_all();
+		}
+		position = want;
+
+		while(filled.empty() && !finished)
+			cond.wait(lock);
+
+		if(filled.empty()) {
+			if(!error.empty())
+				throw IOException("Error in CompressedStreamBuf::underflow() " + error, 0);
+			return traits_type::eof();
+		}
+
+		current = filled.front();
+		filled.pop_front();
+
+		// skip the blocks before a forward seek target
+		if(current->offset + current->size <= want)
+			continue;
+
+		char* base = &current->data[0];
+		uint64_t skip = want > current->offset ? want - current->offset : 0;
+		setg(base, base + skip, base + current->size);
+		position = current->offset;
+
+		return traits_type::to_int_type(*gptr());
+	}
+}
+
+CompressedStreamBuf::pos_type CompressedStreamBuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+	if(dir == std::ios_base::cur)
+		return seekpos(pos_type(position + (gptr() - eback()) + off), which);
+	if(dir == std::ios_base::beg)
+		return seekpos(pos_type(off), which);
+
+	// the uncompressed size is unknown
+	return pos_type(off_type(-1));
+}
+
+CompressedStreamBuf::pos_type CompressedStreamBuf::seekpos(pos_type pos, std::ios_base::openmode which) {
+	if(!(which & std::ios_base::in) || off_type(pos) < 0)
+		return pos_type(off_type(-1));
+
+	uint64_t target = off_type(pos);
+	uint64_t cur = position + (gptr() - eback());
+
+	// inside the current block
+	if(current && target >= current->offset && target <= current->offset + current->size) {
+		setg(eback(), eback() + (target - current->offset), egptr());
+		return pos;
+	}
+
+	// a short forward jump is cheaper decompressing than restarting
+	if(target >= cur && target - cur <= span) {
+		std::lock_guard<std::mutex> lock(mutex);
+		release();
+		position = target;
+		return pos;
+	}
+
+	stop();
+	position = target;
+	start(target);
+
+	return pos;
+}
+
+void CompressedStreamBuf::start(uint64_t target) {
+	// the last checkpoint before the target, -1 is the beginning of the file
+	int checkpoint = -1;
+	for(unsigned int i=0; i<checkpoints.size() && checkpoints[i].out <= target; i++)
+		checkpoint = i;
+
+	stopping = false;
+	finished = false;
+	error.clear();
+	worker = std::thread(&CompressedStreamBuf::run, this, checkpoint, target);
+}
+
+void CompressedStreamBuf::stop() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		cond.notify_all();
+	}
+	if(worker.joinable())
+		worker.join();
+
+	release();
+	while(!filled.empty())
+	{
+		empty.push_back(filled.front());
+		filled.pop_front();
+	}
+}
+
+void CompressedStreamBuf::release() {
+	if(current) {
+		empty.push_back(current);
+		current = 0;
+		cond.notify_all();
+	}
+	setg(0, 0, 0);
+}
+
+void CompressedStreamBuf::run(int checkpoint, uint64_t target) {
+	FILE* in = fopen(filename.c_str(), "rb");
+	if(!in)
+		fail("cannot open " + filename);
+	else {
+		if(format == GZIP)
+			inflateGzip(in, checkpoint, target);
+		else
+			decompressZstd(in, checkpoint, target);
+		fclose(in);
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	finished = true;
+	cond.notify_all();
+}
+
+void CompressedStreamBuf::inflateGzip(FILE* in, int checkpoint, uint64_t target) {
+	std::vector<unsigned char> input(CHUNKSIZE);
+	std::vector<unsigned char> ring(WINSIZE, 0);
+	size_t ringPos = 0;
+
+	z_stream strm;
+	memset(&strm, 0, sizeof(strm));
+
+	uint64_t totin = 0, totout = 0;
+	bool raw = false;
+	bool inMember = false;
+
+	if(checkpoint < 0) {
+		// 47: detect the gzip or zlib header, 32K window
+		if(inflateInit2(&strm, 47) != Z_OK) {
+			fail("inflateInit2 failed");
+			return;
+		}
+	}
+	else {
+		std::unique_lock<std::mutex> lock(mutex);
+		Checkpoint cp = checkpoints[checkpoint];
+		lock.unlock();
+
+		raw = true;
+		inMember = true;
+		totin = cp.in;
+		totout = cp.out;
+		memcpy(&ring[0], &cp.window[0], WINSIZE);
+
+		int ret = inflateInit2(&strm, -15);
+		if(ret == Z_OK && fseeko(in, cp.in - (cp.bits ? 1 : 0), SEEK_SET) != 0)
+			ret = Z_ERRNO;
+		if(ret == Z_OK && cp.bits) {
+			int ch = getc(in);
+			ret = ch == EOF ? Z_DATA_ERROR : inflatePrime(&strm, cp.bits, ch >> (8 - cp.bits));
+		}
+		if(ret == Z_OK)
+			ret = inflateSetDictionary(&strm, &cp.window[0], WINSIZE);
+		if(ret != Z_OK) {
+			inflateEnd(&strm);
+			fail("cannot restart from checkpoint");
+			return;
+		}
+	}
+
+	Block* block = 0;
+	while(true) {
+		if(strm.avail_in == 0) {
+			strm.avail_in = fread(&input[0], 1, CHUNKSIZE, in);
+			strm.next_in = &input[0];
+			if(ferror(in)) {
+				fail("read error");
+				break;
+			}
+			if(strm.avail_in == 0) {
+				if(inMember)
+					fail("unexpected end of compressed data");
+				break;
+			}
+		}
+
+		if(!block) {
+			block = acquire();
+			if(!block)
+				break;
+			block->offset = totout;
+			block->size = 0;
+		}
+
+		strm.next_out = (Bytef*) &block->data[block->size];
+		strm.avail_out = blockSize - block->size;
+		unsigned int availIn = strm.avail_in;
+		unsigned int availOut = strm.avail_out;
+
+		int ret = inflate(&strm, Z_BLOCK);
+		if(ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR) {
+			fail(strm.msg ? strm.msg : "corrupted compressed data");
+			break;
+		}
+
+		size_t nout = availOut - strm.avail_out;
+		totin += availIn - strm.avail_in;
+		totout += nout;
+		inMember = true;
+
+		// keep the last 32K of output, the dictionary of the next checkpoint
+		const unsigned char* out = (const unsigned char*) &block->data[block->size];
+		if(nout >= WINSIZE) {
+			memcpy(&ring[0], out + nout - WINSIZE, WINSIZE);
+			ringPos = 0;
+		}
+		else {
+			size_t first = std::min<size_t>(nout, WINSIZE - ringPos);
+			memcpy(&ring[ringPos], out, first);
+			memcpy(&ring[0], out + first, nout - first);
+			ringPos = (ringPos + nout) % WINSIZE;
+		}
+		block->size += nout;
+
+		if(ret == Z_STREAM_END) {
+			// concatenated members: skip the trailer left by raw mode and
+			// restart with header detection.
+			for(int skip = raw ? 8 : 0; skip > 0; ) {
+				if(strm.avail_in == 0) {
+					strm.avail_in = fread(&input[0], 1, CHUNKSIZE, in);
+					strm.next_in = &input[0];
+					if(strm.avail_in == 0)
+						break;
+				}
+				unsigned int n = std::min<unsigned int>(skip, strm.avail_in);
+				strm.next_in += n;
+				strm.avail_in -= n;
+				totin += n;
+				skip -= n;
+			}
+			inflateReset2(&strm, 47);
+			raw = false;
+			inMember = false;
+		}
+		else if((strm.data_type & 128) && !(strm.data_type & 64) && checkpointDue(totout))
+			addCheckpoint(totout, totin, strm.data_type & 7, &ring[0], ringPos);
+
+		if(block->size == blockSize) {
+			if(!deliver(block, target))
+				break;
+			block = 0;
+		}
+	}
+
+	if(block && (block->size == 0 || !deliver(block, target))) {
+		std::lock_guard<std::mutex> lock(mutex);
+		empty.push_back(block);
+	}
+
+	inflateEnd(&strm);
+}
+
+void CompressedStreamBuf::decompressZstd(FILE* in, int checkpoint, uint64_t target) {
+#ifdef QL_HAVE_ZSTD
+	std::vector<unsigned char> input(ZSTD_DStreamInSize());
+
+	uint64_t totin = 0, totout = 0;
+	if(checkpoint >= 0) {
+		std::unique_lock<std::mutex> lock(mutex);
+		totin = checkpoints[checkpoint].in;
+		totout = checkpoints[checkpoint].out;
+		lock.unlock();
+
+		// checkpoints are frame boundaries, no state to restore
+		if(fseeko(in, totin, SEEK_SET) != 0) {
+			fail("cannot restart from checkpoint");
+			return;
+		}
+	}
+
+	ZSTD_DCtx* dctx = ZSTD_createDCtx();
+	ZSTD_inBuffer inbuff = { &input[0], 0, 0 };
+	bool inFrame = false;
+
+	Block* block = 0;
+	while(true) {
+		if(inbuff.pos == inbuff.size) {
+			inbuff.size = fread(&input[0], 1, input.size(), in);
+			inbuff.pos = 0;
+			if(ferror(in)) {
+				fail("read error");
+				break;
+			}
+			if(inbuff.size == 0) {
+				if(inFrame)
+					fail("unexpected end of compressed data");
+				break;
+			}
+		}
+
+		if(!block) {
+			block = acquire();
+			if(!block)
+				break;
+			block->offset = totout;
+			block->size = 0;
+		}
+
+		ZSTD_outBuffer outbuff = { &block->data[0], blockSize, block->size };
+		size_t inpos = inbuff.pos;
+		size_t ret = ZSTD_decompressStream(dctx, &outbuff, &inbuff);
+		if(ZSTD_isError(ret)) {
+			fail(ZSTD_getErrorName(ret));
+			break;
+		}
+
+		totin += inbuff.pos - inpos;
+		totout += outbuff.pos - block->size;
+		block->size = outbuff.pos;
+		inFrame = ret != 0;
+
+		if(!inFrame && checkpointDue(totout))
+			addCheckpoint(totout, totin, 0, 0, 0);
+
+		if(block->size == blockSize) {
+			if(!deliver(block, target))
+				break;
+			block = 0;
+		}
+	}
+
+	if(block && (block->size == 0 || !deliver(block, target))) {
+		std::lock_guard<std::mutex> lock(mutex);
+		empty.push_back(block);
+	}
+
+	ZSTD_freeDCtx(dctx);
+#else
+	fail("zstd support not available");
+#endif
+}
+
+CompressedStreamBuf::Block* CompressedStreamBuf::acquire() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while(empty.empty() && !stopping)
+		cond.wait(lock);
+
+	if(stopping)
+		return 0;
+
+	Block* block = empty.back();
+	empty.pop_back();
+	return block;
+}
+
+bool CompressedStreamBuf::deliver(Block* block, uint64_t target) {
+	// blocks before the seek target are reused without waking the reader
+	if(block->offset + block->size <= target) {
+		std::lock_guard<std::mutex> lock(mutex);
+		empty.push_back(block);
+		return !stopping;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if(stopping) {
+		empty.push_back(block);
+		return false;
+	}
+	filled.push_back(block);
+	cond.notify_all();
+	return true;
+}
+
+void CompressedStreamBuf::fail(const std::string& msg) {
+	std::lock_guard<std::mutex> lock(mutex);
+	error = msg;
+}
+
+bool CompressedStreamBuf::checkpointDue(uint64_t out) {
+	std::lock_guard<std::mutex> lock(mutex);
+	return out >= (checkpoints.empty() ? span : checkpoints.back().out + span);
+}
+
+void CompressedStreamBuf::addCheckpoint(uint64_t out, uint64_t in, int bits, const unsigned char* ring, size_t ringPos) {
+	Checkpoint cp;
+	cp.out = out;
+	cp.in = in;
+	cp.bits = bits;
+	if(ring) {
+		// unroll the ring, oldest byte first
+		cp.window.resize(WINSIZE);
+		memcpy(&cp.window[0], ring + ringPos, WINSIZE - ringPos);
+		memcpy(&cp.window[WINSIZE - ringPos], ring, ringPos);
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	checkpoints.push_back(cp);
+}
+
+}
@@ -0,0 +1,124 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_COMPRESSEDSTREAMBUF_H
+#define QL_IO_COMPRESSEDSTREAMBUF_H
+
+#include <stdint.h>
+#include <cstdio>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "File.h"
+
+namespace qlbase {
+
+/// A read-only stream buffer over a gzip (or zstd) compressed file.
+/// The file is decompressed by a background thread into a bounded set of
+/// blocks, so decompression overlaps with parsing. While decompressing,
+/// restart checkpoints are recorded every span bytes of output (at deflate
+/// block boundaries for gzip, at frame boundaries for zstd). Seeking restarts
+/// from the nearest checkpoint instead of the beginning of the file.
+class CompressedStreamBuf : public std::streambuf {
+
+public:
+
+	enum Format {
+		PLAIN = 0,
+		GZIP,
+		ZSTD
+	};
+
+	/// Detect the compression format from the file magic number.
+	static Format detect(const std::string& filename);
+
+	/// \param[in] filename The compressed file.
+	/// \param[in] format GZIP or ZSTD.
+	/// \param[in] blockSize Size of each decompressed block.
+	/// \param[in] maxBlocks Maximum number of blocks decompressed ahead.
+	/// \param[in] span Minimum distance between two checkpoints (uncompressed bytes).
+	CompressedStreamBuf(const std::string& filename, Format format, size_t blockSize = 1 << 20,
+	                    int maxBlocks = 4, uint64_t span = 1 << 22);
+
+	virtual ~CompressedStreamBuf();
+
+	/// Get the number of restart checkpoints recorded so far.
+	int getCheckpointNum();
+
+protected:
+
+	virtual int_type underflow();
+	virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which);
+	virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which);
+
+private:
+
+	struct Block {
+		std::vector<char> data;
+		size_t size;
+		uint64_t offset;
+	};
+
+	struct Checkpoint {
+		uint64_t out;
+		uint64_t in;
+		int bits;
+		std::vector<unsigned char> window;
+	};
+
+	std::string filename;
+	Format format;
+	size_t blockSize;
+	uint64_t span;
+
+	std::vector<Block> blocks;
+	std::deque<Block*> filled;
+	std::vector<Block*> empty;
+
+	/// The block under reading and the uncompressed offset of eback().
+	Block* current;
+	uint64_t position;
+
+	std::vector<Checkpoint> checkpoints;
+
+	std::thread worker;
+	std::mutex mutex;
+	std::condition_variable cond;
+	bool stopping;
+	bool finished;
+	std::string error;
+
+	void start(uint64_t target);
+	void stop();
+	void release();
+
+	void run(int checkpoint, uint64_t target);
+	void inflateGzip(FILE* in, int checkpoint, uint64_t target);
+	void decompressZstd(FILE* in, int checkpoint, uint64_t target);
+
+	Block* acquire();
+	bool deliver(Block* block, uint64_t target);
+	void fail(const std::string& msg);
+
+	bool checkpointDue(uint64_t out);
+	void addCheckpoint(uint64_t out, uint64_t in, int bits, const unsigned char* ring, size_t ringPos);
+};
+
+}
+
+#endif
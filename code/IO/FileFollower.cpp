@@ -0,0 +1,100 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "FileFollower.h"
+#include "mac_clock_gettime.h"
+#include <unistd.h>
+#include <poll.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+namespace qlbase {
+
+FileFollower::FileFollower(InputFile& file, int pollms) : file(file), pollms(pollms), notifyfd(-1), watchfd(-1) {
+	if(!file.isOpened())
+		throw IOException("Error in FileFollower::FileFollower() ", 0);
+
+	nextRow = file.getNRows();
+
+#ifdef __linux__
+	notifyfd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(notifyfd >= 0) {
+		watchfd = inotify_add_watch(notifyfd, file.getFileName().c_str(), IN_MODIFY | IN_CLOSE_WRITE);
+		if(watchfd < 0) {
+			::close(notifyfd);
+			notifyfd = -1;
+		}
+	}
+#endif
+}
+
+FileFollower::~FileFollower() {
+	if(notifyfd >= 0)
+		::close(notifyfd);
+}
+
+bool FileFollower::poll(long& frow, long& lrow) {
+	file.refresh();
+
+	long nrows = file.getNRows();
+	if(nrows <= nextRow)
+		return false;
+
+	frow = nextRow;
+	lrow = nrows - 1;
+	nextRow = nrows;
+
+	return true;
+}
+
+bool FileFollower::wait(long& frow, long& lrow, int timeoutms) {
+	long start = gettimensec();
+
+	while(true) {
+		if(poll(frow, lrow))
+			return true;
+
+		int waitms = pollms;
+		if(timeoutms >= 0) {
+			int elapsed = (gettimensec() - start) / 1000000L;
+			if(elapsed >= timeoutms)
+				return false;
+			if(timeoutms - elapsed < waitms)
+				waitms = timeoutms - elapsed;
+		}
+
+		sleep(waitms);
+	}
+}
+
+void FileFollower::sleep(int ms) {
+	if(notifyfd < 0) {
+		usleep(ms * 1000);
+		return;
+	}
+
+	// wake up on the first modification, pollms is only an upper bound
+	// because some writers (e.g. NFS clients) don't generate events.
+	struct pollfd pfd;
+	pfd.fd = notifyfd;
+	pfd.events = POLLIN;
+	if(::poll(&pfd, 1, ms) > 0) {
+		char events[4096];
+		while(read(notifyfd, events, sizeof(events)) > 0)
+			;
+	}
+}
+
+}
@@ -0,0 +1,66 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_FILEFOLLOWER_H
+#define QL_IO_FILEFOLLOWER_H
+
+#include "InputFile.h"
+
+namespace qlbase {
+
+/// Follow an InputFile that keeps growing on disk (tail -f like).
+/// The follower remembers the rows already delivered and returns only the
+/// rows appended after them. On linux the file is watched through inotify,
+/// elsewhere (or when the watch can't be set) it is polled.
+class FileFollower {
+
+public:
+
+	/// \param[in] file An opened file, positioned on the block to follow.
+	/// \param[in] pollms Polling interval in milliseconds.
+	FileFollower(InputFile& file, int pollms = 100);
+
+	~FileFollower();
+
+	/// Check once for new rows.
+	/// \param[out] frow First new row (starting from 0).
+	/// \param[out] lrow Last new row (starting from 0).
+	/// \return true if new rows are available.
+	bool poll(long& frow, long& lrow);
+
+	/// Wait for new rows.
+	/// \param[out] frow First new row (starting from 0).
+	/// \param[out] lrow Last new row (starting from 0).
+	/// \param[in] timeoutms Maximum waiting time in milliseconds, -1 to wait forever.
+	/// \return true if new rows are available, false on timeout.
+	bool wait(long& frow, long& lrow, int timeoutms = -1);
+
+	/// Get the first row not delivered yet.
+	long getNextRow() { return nextRow; }
+
+private:
+
+	InputFile& file;
+	long nextRow;
+	int pollms;
+
+	int notifyfd;
+	int watchfd;
+
+	void sleep(int ms);
+};
+
+}
+
+#endif
@@ -0,0 +1,85 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_FITSTRAITS_H
+#define QL_IO_FITSTRAITS_H
+
+#include <stdint.h>
+#include <fitsio.h>
+#include "OutputFile.h"
+
+namespace qlbase {
+
+/// The cfitsio datatype code of a C++ type, and its column type. Only
+/// defined for the supported types, so the other ones fail to compile.
+template<class T>
+struct FitsTraits;
+
+template<>
+struct FitsTraits<uint8_t> {
+	static constexpr int datatype = TBYTE;
+	static constexpr fieldType type = UNSIGNED_INT8;
+};
+
+template<>
+struct FitsTraits<int16_t> {
+	static constexpr int datatype = TSHORT;
+	static constexpr fieldType type = INT16;
+};
+
+/// No column type of its own, see OutputFileFITS::setUnsigned().
+template<>
+struct FitsTraits<uint16_t> {
+	static constexpr int datatype = TUSHORT;
+};
+
+template<>
+struct FitsTraits<int32_t> {
+	static constexpr int datatype = TINT;
+	static constexpr fieldType type = INT32;
+};
+
+/// No column type of its own, see OutputFileFITS::setUnsigned().
+template<>
+struct FitsTraits<uint32_t> {
+	static constexpr int datatype = TUINT;
+};
+
+template<>
+struct FitsTraits<int64_t> {
+	static constexpr int datatype = TLONGLONG;
+	static constexpr fieldType type = INT64;
+};
+
+/// No column type of its own, see OutputFileFITS::setUnsigned().
+template<>
+struct FitsTraits<uint64_t> {
+	static constexpr int datatype = TULONGLONG;
+};
+
+template<>
+struct FitsTraits<float> {
+	static constexpr int datatype = TFLOAT;
+	static constexpr fieldType type = FLOAT;
+};
+
+template<>
+struct FitsTraits<double> {
+	static constexpr int datatype = TDOUBLE;
+	static constexpr fieldType type = DOUBLE;
+};
+
+}
+
+#endif
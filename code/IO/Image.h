@@ -0,0 +1,143 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_IMAGE_H
+#define QL_IO_IMAGE_H
+
+#include <stdint.h>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include "AlignedAllocator.h"
+#include "ArrayView.h"
+
+namespace qlbase {
+
+/// A multidimensional image, the pixels in FITS order (axis 0 is the
+/// fastest) in a 64 bytes aligned buffer.
+template<class T>
+struct Image {
+	typedef std::vector<T, AlignedAllocator<T> > Pixels;
+
+	Pixels data;
+	int32_t dim;
+	std::vector<int64_t> sizes;
+
+	/// \param[in] budget The budget charged for the pixels, 0 for the global
+	/// one.
+	explicit Image(MemoryBudget* budget = 0) : data(AlignedAllocator<T>(budget)), dim(0) {}
+
+	/// Get a view of the pixels, for crops and planes without copies.
+	ArrayView<T> view() { return ArrayView<T>(data.empty() ? 0 : &data[0], sizes); }
+	ArrayView<const T> view() const { return ArrayView<const T>(data.empty() ? 0 : &data[0], sizes); }
+
+	/// Set the sizes and allocate the pixels, e.g. for a copy of a view.
+	void resize(const std::vector<int64_t>& sizes) {
+		this->sizes = sizes;
+		dim = sizes.size();
+		int64_t n = sizes.empty() ? 0 : 1;
+		for(unsigned int d=0; d<sizes.size(); d++)
+			n *= sizes[d];
+		data.resize(n);
+	}
+};
+
+/// Copy the values of a view into a new contiguous image.
+template<class T>
+Image<typename std::remove_const<T>::type> copyImage(const ArrayView<T>& view) {
+	std::vector<int64_t> sizes(view.getDim());
+	for(int d=0; d<view.getDim(); d++)
+		sizes[d] = view.getSize(d);
+
+	Image<typename std::remove_const<T>::type> image;
+	image.resize(sizes);
+	if(!image.data.empty())
+		view.copyTo(&image.data[0]);
+	return image;
+}
+
+/// Reduce the values of a view along an axis with op(accumulator, value),
+/// each accumulator starting from init. The image has the sizes of the view
+/// without the axis.
+template<class R, class T, class Op>
+Image<R> reduce(const ArrayView<T>& view, int axis, R init, Op op) {
+	if(axis < 0 || axis >= view.getDim() || view.getDim() < 2)
+		throw IOException("Error in reduce() invalid axis", 0);
+
+	std::vector<int64_t> sizes;
+	for(int d=0; d<view.getDim(); d++)
+		if(d != axis)
+			sizes.push_back(view.getSize(d));
+
+	Image<R> image;
+	image.resize(sizes);
+	image.data.assign(image.data.size(), init);
+	if(image.data.empty())
+		return image;
+
+	// the output is walked along with the input, not moving on the axis
+	ArrayView<R> out = image.view();
+	int64_t outStrides[ArrayView<T>::MAXDIMS];
+	for(int d=0, o=0; d<view.getDim(); d++)
+		outStrides[d] = d == axis ? 0 : out.getStride(o++);
+
+	int64_t index[ArrayView<T>::MAXDIMS] = {0};
+	const int ndim = view.getDim();
+	T* row = view.data();
+	R* outRow = out.data();
+	while(true) {
+		T* p = row;
+		R* q = outRow;
+		for(int64_t x=0; x<view.getSize(0); x++, p += view.getStride(0), q += outStrides[0])
+			*q = op(*q, *p);
+
+		int d = 1;
+		for(; d<ndim; d++) {
+			row += view.getStride(d);
+			outRow += outStrides[d];
+			if(++index[d] < view.getSize(d))
+				break;
+			row -= view.getSize(d) * view.getStride(d);
+			outRow -= view.getSize(d) * outStrides[d];
+			index[d] = 0;
+		}
+		if(d == ndim)
+			return image;
+	}
+}
+
+/// Sum the values along an axis, e.g. reduceSum<double>(cube, 2) for the
+/// sum of the planes.
+template<class R, class T>
+Image<R> reduceSum(const ArrayView<T>& view, int axis) {
+	return reduce(view, axis, (R) 0, [](R a, T v) { return a + (R) v; });
+}
+
+/// Get the maximum along an axis.
+template<class T>
+Image<typename std::remove_const<T>::type> reduceMax(const ArrayView<T>& view, int axis) {
+	typedef typename std::remove_const<T>::type V;
+	return reduce(view, axis, std::numeric_limits<V>::lowest(), [](V a, V v) { return v > a ? v : a; });
+}
+
+/// Get the minimum along an axis.
+template<class T>
+Image<typename std::remove_const<T>::type> reduceMin(const ArrayView<T>& view, int axis) {
+	typedef typename std::remove_const<T>::type V;
+	return reduce(view, axis, std::numeric_limits<V>::max(), [](V a, V v) { return v < a ? v : a; });
+}
+
+}
+
+#endif
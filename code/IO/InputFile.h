@@ -20,26 +20,29 @@
 #include <stdint.h>
 #include <vector>
 #include "File.h"
+#include "Image.h"
 
 namespace qlbase {
 
-template<class T>
-struct Image {
-	std::vector<T> data;
-	int32_t dim;
-	std::vector<int64_t> sizes;
-};
-
 /// An abstraction for reading from a generic file divided into blocks.
 /// Each block could be a table or an image.
 class InputFile : public File {
 
 	public:
 
-		InputFile() {}
+		InputFile() : memoryBudget(0) {}
 
 		virtual ~InputFile() {}
 
+		/// Set the budget charged for the images read and for the copies
+		/// the reader keeps in memory (e.g. the uncompressed tables of
+		/// InputFileFITS), 0 for the global one. The column vectors are
+		/// owned by the caller and not charged. The budget must outlive the
+		/// images and the file.
+		void setMemoryBudget(MemoryBudget* budget) { memoryBudget = budget; }
+
+		MemoryBudget* getMemoryBudget() const { return memoryBudget; }
+
 		/// Get the number of headers present in the file.
 		/// \return The number of headers.
 		virtual int getHeadersNum() = 0;
@@ -58,6 +61,11 @@ class InputFile : public File {
 		/// Get column number from the name.
 		virtual int getColNum(const std::string& columnName) = 0;
 
+		/// Look for rows appended to the current block since open() or the
+		/// last refresh(), updating the number of rows.
+		/// \return The number of new rows.
+		virtual long refresh() = 0;
+
 		/// Read a column of byte.
 		/// \param[in] ncol Column number (starting from 0).
 		/// \param[in] frow First row (starting from 0).
@@ -77,6 +85,12 @@ class InputFile : public File {
 		/// Read a column of 64 bit integers.
 		virtual std::vector<int64_t> read64i(int ncol, long frow, long lrow) = 0;
 
+		/// Read a column of 32 bit unsigned integers.
+		virtual std::vector<uint32_t> read32u(int ncol, long frow, long lrow) = 0;
+
+		/// Read a column of 64 bit unsigned integers.
+		virtual std::vector<uint64_t> read64u(int ncol, long frow, long lrow) = 0;
+
 		/// Read a column of float.
 		virtual std::vector<float> read32f(int ncol, long frow, long lrow) = 0;
 
@@ -122,6 +136,10 @@ class InputFile : public File {
 
 		/// Read a multidimensional image of double.
 		virtual Image<double> readImage64f() = 0;
+
+	protected:
+
+		MemoryBudget* memoryBudget;
 };
 
 }
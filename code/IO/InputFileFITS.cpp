@@ -15,16 +15,22 @@
 
 #include "Definitions.h"
 #include "InputFileFITS.h"
+#include "BufferPool.h"
 #include <cstring>
+#include <sstream>
+#include <algorithm>
+#include <sys/stat.h>
 
 namespace qlbase {
 
 #define ERRMSGSIZ 81
 
-InputFileFITS::InputFileFITS() : opened(false), infptr(0) {
+InputFileFITS::InputFileFITS() : opened(false), fileSize(-1), fileMTime(-1), memBuffer(0), memSize(0), filefptr(0), tablefptr(0),
+	tableBudget(0), tableBytes(0), infptr(0) {
 }
 
 InputFileFITS::~InputFileFITS() {
+	closeTable();
 }
 
 void InputFileFITS::throwException(const char *msg, int status) {
@@ -45,17 +51,71 @@ void InputFileFITS::throwException(const char *msg, int status) {
 void InputFileFITS::open(const std::string &filename) {
 	File::open(filename);
 	int status = 0;
-	fits_open_data(&infptr, filename.c_str(), READONLY, &status);
+	fits_open_data(&filefptr, filename.c_str(), READONLY, &status);
+	infptr = filefptr;
 
 	if (status)
 		throwException("Error in InputFileFITS::open() ", status);
 
 	opened = true;
+
+	try {
+		uncompressTable();
+	}
+	catch(IOException& e) {
+		int closeStatus = 0;
+		fits_close_file(filefptr, &closeStatus);
+		opened = false;
+		throw;
+	}
+
+	statFile(fileSize, fileMTime);
+}
+
+void InputFileFITS::openMemory(const void* buffer, size_t size) {
+	File::open("");
+	int status = 0;
+
+	// cfitsio reads the buffer in place, without a realloc function it is
+	// never written
+	memBuffer = const_cast<void*>(buffer);
+	memSize = size;
+	fits_open_memfile(&filefptr, "memory.fits", READONLY, &memBuffer, &memSize, 0, 0, &status);
+	infptr = filefptr;
+
+	if (status)
+		throwException("Error in InputFileFITS::openMemory() ", status);
+
+	opened = true;
+
+	// like fits_open_data, skip an empty primary HDU
+	int naxis = 0, nhdus = 0;
+	fits_get_img_dim(filefptr, &naxis, &status);
+	fits_get_num_hdus(filefptr, &nhdus, &status);
+	if (!status && naxis == 0 && nhdus > 1)
+		fits_movabs_hdu(filefptr, 2, 0, &status);
+
+	if (status)
+		throwException("Error in InputFileFITS::openMemory() ", status);
+
+	try {
+		uncompressTable();
+	}
+	catch(IOException& e) {
+		int closeStatus = 0;
+		fits_close_file(filefptr, &closeStatus);
+		opened = false;
+		throw;
+	}
+
+	fileSize = -1;
+	fileMTime = -1;
 }
 
 void InputFileFITS::close() {
 	int status = 0;
-	fits_close_file(infptr, &status);
+	closeTable();
+	fits_close_file(filefptr, &status);
 
 	if (status)
 		throwException("Error in InputFileFITS::close() ", status);
@@ -69,7 +129,7 @@ int InputFileFITS::getHeadersNum() {
 	if(!isOpened())
 		throwException("Error in InputFileFITS::getHeadersNum() ", status);
 
-	fits_get_num_hdus(infptr, &num, &status);
+	fits_get_num_hdus(filefptr, &num, &status);
 
 	if (status)
 		throwException("Error in InputFileFITS::getHeadersNum() ", status);
@@ -83,10 +143,69 @@ void InputFileFITS::moveToHeader(int number) {
 	if(!isOpened())
 		throwException("Error in InputFileFITS::moveToHeader() ", status);
 
-	fits_movabs_hdu(infptr, number+1, 0, &status);
+	closeTable();
+	fits_movabs_hdu(filefptr, number+1, 0, &status);
 
 	if (status)
 		throwException("Error in InputFileFITS::moveToHeader() ", status);
+
+	uncompressTable();
+}
+
+void InputFileFITS::uncompressTable() {
+	int status = 0;
+	int ztable = 0;
+
+	fits_read_key(filefptr, TLOGICAL, "ZTABLE", &ztable, 0, &status);
+	if (status == KEY_NO_EXIST || !ztable)
+		return;
+
+	// the rows and the heap of the copy are charged before making it
+	LONGLONG rowBytes = 0, nrows = 0, heapBytes = 0;
+	status = 0;
+	fits_read_key(filefptr, TLONGLONG, "ZNAXIS1", &rowBytes, 0, &status);
+	fits_read_key(filefptr, TLONGLONG, "ZNAXIS2", &nrows, 0, &status);
+	if (status)
+		throwException("Error in InputFileFITS::uncompressTable() ", status);
+	fits_read_key(filefptr, TLONGLONG, "ZPCOUNT", &heapBytes, 0, &status);
+	status = 0;
+
+	MemoryBudget* budget = memoryBudget ? memoryBudget : &MemoryBudget::getGlobal();
+	int64_t bytes = rowBytes * nrows + heapBytes;
+	budget->charge(bytes);
+
+	// an empty primary HDU, then the uncompressed table
+	fitsfile* memfptr;
+	fits_create_file(&memfptr, "mem://", &status);
+	fits_create_img(memfptr, BYTE_IMG, 0, 0, &status);
+	fits_uncompress_table(filefptr, memfptr, &status);
+	fits_movabs_hdu(memfptr, 2, 0, &status);
+
+	if (status)
+	{
+		int closeStatus = 0;
+		fits_close_file(memfptr, &closeStatus);
+		budget->release(bytes);
+		throwException("Error in InputFileFITS::uncompressTable() ", status);
+	}
+
+	tablefptr = memfptr;
+	tableBudget = budget;
+	tableBytes = bytes;
+	infptr = tablefptr;
+}
+
+void InputFileFITS::closeTable() {
+	if(!tablefptr)
+		return;
+
+	int status = 0;
+	fits_close_file(tablefptr, &status);
+	tablefptr = 0;
+	infptr = filefptr;
+	tableBudget->release(tableBytes);
+	tableBudget = 0;
+	tableBytes = 0;
 }
 
 int InputFileFITS::getNCols() {
@@ -133,6 +252,109 @@ int InputFileFITS::getColNum(const std::string& columnName) {
 	return colnum-1;
 }
 
+field InputFileFITS::getField(int ncol) {
+	int status = 0;
+	if(!isOpened())
+		throwException("Error in InputFileFITS::getField() ", status);
+
+	int typecode;
+	long repeat, width;
+	fits_get_coltype(infptr, ncol+1, &typecode, &repeat, &width, &status);
+
+	char keyname[FLEN_KEYWORD], value[FLEN_VALUE] = "";
+	fits_make_keyn("TTYPE", ncol+1, keyname, &status);
+	fits_read_key(infptr, TSTRING, keyname, value, 0, &status);
+	if(status)
+		throwException("Error in InputFileFITS::getField() ", status);
+
+	field f;
+	f.name = value;
+	f.vsize = typecode < 0 ? 0 : repeat;
+	switch(typecode < 0 ? -typecode : typecode)
+	{
+		case TBYTE: f.type = UNSIGNED_INT8; break;
+		case TSHORT: f.type = INT16; break;
+		case TINT:
+		case TLONG: f.type = INT32; break;
+		case TLONGLONG: f.type = INT64; break;
+		case TFLOAT: f.type = FLOAT; break;
+		case TDOUBLE: f.type = DOUBLE; break;
+		case TSTRING: f.type = STRING; break;
+		case TBIT: f.type = BIT; break;
+		case TLOGICAL: f.type = LOGICAL; break;
+		default:
+			throw IOException("Error in InputFileFITS::getField() unsupported column type", 0);
+	}
+
+	// the unit is optional
+	value[0] = 0;
+	fits_make_keyn("TUNIT", ncol+1, keyname, &status);
+	fits_read_key(infptr, TSTRING, keyname, value, 0, &status);
+	f.unit = status ? "" : value;
+	return f;
+}
+
+long InputFileFITS::refresh() {
+	int status = 0;
+
+	if(!isOpened())
+		throwException("Error in InputFileFITS::refresh() ", status);
+
+	int64_t size, mtime;
+	if(!statFile(size, mtime) || (size == fileSize && mtime == fileMTime))
+		return 0;
+
+	int hdunum, hdutype;
+	fits_get_hdu_num(filefptr, &hdunum);
+	fits_get_hdu_type(filefptr, &hdutype, &status);
+	if (status)
+		throwException("Error in InputFileFITS::refresh() ", status);
+
+	long before = 0;
+	if(hdutype != IMAGE_HDU)
+		before = getNRows();
+
+	// cfitsio caches the header and the file size, so reopen to see the
+	// new rows. This costs a header parse, not a data read.
+	closeTable();
+	fits_close_file(filefptr, &status);
+	fits_open_file(&filefptr, _filename.c_str(), READONLY, &status);
+	infptr = filefptr;
+	if (status) {
+		opened = false;
+		throwException("Error in InputFileFITS::refresh() ", status);
+	}
+
+	fits_movabs_hdu(filefptr, hdunum, 0, &status);
+	if (status)
+		throwException("Error in InputFileFITS::refresh() ", status);
+
+	uncompressTable();
+
+	fileSize = size;
+	fileMTime = mtime;
+
+	if(hdutype == IMAGE_HDU)
+		return 0;
+
+	long after = getNRows();
+	return after > before ? after - before : 0;
+}
+
+bool InputFileFITS::statFile(int64_t& size, int64_t& mtime) {
+	struct stat st;
+	if(stat(_filename.c_str(), &st) != 0)
+		return false;
+
+	size = st.st_size;
+#ifdef __MACH__
+	mtime = (int64_t) st.st_mtimespec.tv_sec * 1000000000LL + st.st_mtimespec.tv_nsec;
+#else
+	mtime = (int64_t) st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+#endif
+	return true;
+}
+
 int InputFileFITS::getKeywordNum() {
 	int status = 0, nkeys;
 
@@ -192,6 +414,18 @@ std::vector<int64_t> InputFileFITS::read64i(int ncol, long frow, long lrow) {
 	return buff;
 }
 
+std::vector<uint32_t> InputFileFITS::read32u(int ncol, long frow, long lrow) {
+	std::vector<uint32_t> buff;
+	_read(ncol, buff, TUINT, frow, lrow);
+	return buff;
+}
+
+std::vector<uint64_t> InputFileFITS::read64u(int ncol, long frow, long lrow) {
+	std::vector<uint64_t> buff;
+	_read(ncol, buff, TULONGLONG, frow, lrow);
+	return buff;
+}
+
 std::vector<float> InputFileFITS::read32f(int ncol, long frow, long lrow) {
 	std::vector<float> buff;
 	_read(ncol, buff, TFLOAT, frow, lrow);
@@ -248,76 +482,415 @@ std::vector< std::vector<double> > InputFileFITS::read64fv(int ncol, long frow,
 
 std::vector< std::vector<char> > InputFileFITS::readString(int ncol, long frow, long lrow, int vsize)
 {
-	std::vector< std::vector<char> > buff;
+	StringColumn column;
+	readString(ncol, frow, lrow, column);
+
+	// vsize bytes of each row, the terminator included if it fits
+	size_t size = std::min<size_t>(vsize, column.getWidth() + 1);
+	std::vector< std::vector<char> > buff(column.size(), std::vector<char>(vsize, 0));
+	for(long i=0; i<column.size(); i++)
+		memcpy(&buff[i][0], column[i], size);
 
+	return buff;
+}
+
+void InputFileFITS::readString(int ncol, long frow, long lrow, StringColumn& column)
+{
 	int status = 0;
 	if(!isOpened())
 		throwException("Error in InputFileFITS::readString() ", status);
 
+	long nelem = lrow - frow + 1;
+	int typecode;
+	long repeat, width;
+	fits_get_coltype(infptr, ncol+1, &typecode, &repeat, &width, &status);
+	if(status)
+		throwException("Error in InputFileFITS::readString() ", status);
+	if(typecode != TSTRING || nelem < 1)
+		throw IOException("Error in InputFileFITS::readString() not a string column", 0);
+
+	// cfitsio writes each string with its terminator in the rows of the
+	// buffer
+	column.resize(nelem, repeat);
+	Arena arena(0);
+	char** rows = arena.allocate<char*>(nelem);
+	for(long i=0; i<nelem; i++)
+		rows[i] = column[i];
+
 	int anynull;
-	long nelem = (lrow - frow + 1);
-	long null = 0;
+	char nulval[] = "";
+	fits_read_col(infptr, TSTRING, ncol+1, frow+1, 1, nelem, nulval, rows, &anynull, &status);
 
-	char** buffptrs = new char*[nelem];
-	for(unsigned int i=0; i<nelem; i++)
-		buffptrs[i] = new char[vsize];
+	if(status)
+		throwException("Error in InputFileFITS::readString() ", status);
+}
 
-	fits_read_col(infptr, TSTRING, ncol+1, frow+1, 1, nelem, &null,  buffptrs, &anynull, &status);
+void InputFileFITS::readVar(int ncol, long frow, long lrow, VarColumn<uint8_t>& column)
+{
+	_readVar(ncol, frow, lrow, column, TBYTE, TBYTE);
+}
 
-	buff.resize(nelem);
-	for(unsigned int i=0; i<nelem; i++)
+void InputFileFITS::readVar(int ncol, long frow, long lrow, VarColumn<int16_t>& column)
+{
+	_readVar(ncol, frow, lrow, column, TSHORT, TSHORT);
+}
+
+void InputFileFITS::readVar(int ncol, long frow, long lrow, VarColumn<int32_t>& column)
+{
+	_readVar(ncol, frow, lrow, column, TINT, TLONG);
+}
+
+void InputFileFITS::readVar(int ncol, long frow, long lrow, VarColumn<int64_t>& column)
+{
+	_readVar(ncol, frow, lrow, column, TLONGLONG, TLONGLONG);
+}
+
+void InputFileFITS::readVar(int ncol, long frow, long lrow, VarColumn<float>& column)
+{
+	_readVar(ncol, frow, lrow, column, TFLOAT, TFLOAT);
+}
+
+void InputFileFITS::readVar(int ncol, long frow, long lrow, VarColumn<double>& column)
+{
+	_readVar(ncol, frow, lrow, column, TDOUBLE, TDOUBLE);
+}
+
+// Check the column type and get its number of bits or logicals.
+int InputFileFITS::_getBitColumn(int ncol, int type, long frow, long lrow, const char* method)
+{
+	int status = 0;
+	if(!isOpened() || lrow < frow)
+		throwException(method, status);
+
+	int typecode;
+	long repeat, width;
+	fits_get_coltype(infptr, ncol+1, &typecode, &repeat, &width, &status);
+	if(status)
+		throwException(method, status);
+	if(typecode != type)
+		throw IOException(std::string(method) + (type == TBIT ? "not a bit column" : "not a logical column"), 0);
+
+	return repeat;
+}
+
+// cfitsio reads the bits as packed bytes when asked for TBYTE
+void InputFileFITS::readBits(int ncol, long frow, long lrow, BitColumn& column)
+{
+	int nbits = _getBitColumn(ncol, TBIT, frow, lrow, "Error in InputFileFITS::readBits() ");
+	long nrows = lrow - frow + 1;
+	long nbytes = (nbits + 7) / 8;
+	bitBytes.resize(nrows * nbytes);
+
+	int status = 0;
+	int anynull;
+	uint8_t nulval = 0;
+	fits_read_col(infptr, TBYTE, ncol+1, frow+1, 1, nrows * nbytes, &nulval, &bitBytes[0], &anynull, &status);
+	if(status)
+		throwException("Error in InputFileFITS::readBits() ", status);
+
+	column.resize(nrows, nbits);
+	column.setFitsBytes((const uint8_t*) &bitBytes[0]);
+}
+
+void InputFileFITS::readLogical(int ncol, long frow, long lrow, BitColumn& column)
+{
+	int nvalues = _getBitColumn(ncol, TLOGICAL, frow, lrow, "Error in InputFileFITS::readLogical() ");
+	long nrows = lrow - frow + 1;
+	bitBytes.resize(nrows * nvalues);
+
+	int status = 0;
+	int anynull;
+	char nulval = 0;
+	fits_read_col(infptr, TLOGICAL, ncol+1, frow+1, 1, nrows * nvalues, &nulval, &bitBytes[0], &anynull, &status);
+	if(status)
+		throwException("Error in InputFileFITS::readLogical() ", status);
+
+	column.resize(nrows, nvalues);
+	column.setLogicals(&bitBytes[0]);
+}
+
+// FITS values are big endian
+template<size_t N>
+static void swapBytes(char* buff, size_t nelem) {
+	for(size_t i=0; i<nelem; i++, buff += N)
+		std::reverse(buff, buff + N);
+}
+
+// type is the cfitsio type of T, typecode the column type code that has
+// the same representation of T (e.g. TLONG for 'J' columns).
+template<class T>
+void InputFileFITS::_readVar(int ncol, long frow, long lrow, VarColumn<T>& column, int type, int typecode)
+{
+	int status = 0;
+	if(!isOpened() || lrow < frow)
+		throwException("Error in InputFileFITS::readVar() ", status);
+
+	int coltype;
+	LONGLONG repeat, width;
+	fits_get_coltypell(infptr, ncol+1, &coltype, &repeat, &width, &status);
+	if(status)
+		throwException("Error in InputFileFITS::readVar() ", status);
+	if(coltype >= 0)
+		throw IOException("Error in InputFileFITS::readVar() not a variable length column", 0);
+
+	long nrows = lrow - frow + 1;
+	std::vector<LONGLONG> lengths(nrows), heapOffsets(nrows);
+	fits_read_descriptsll(infptr, ncol+1, frow+1, nrows, &lengths[0], &heapOffsets[0], &status);
+	if(status)
+		throwException("Error in InputFileFITS::readVar() ", status);
+
+	std::vector<int64_t>& offsets = column.getOffsets();
+	offsets.resize(nrows + 1);
+	offsets[0] = 0;
+	for(long i=0; i<nrows; i++)
+		offsets[i+1] = offsets[i] + lengths[i];
+	std::vector<T>& values = column.getValues();
+	values.resize(offsets[nrows]);
+
+	// scaled columns are converted by cfitsio
+	double scale = 1., zero = 0.;
+	std::ostringstream tscal, tzero;
+	tscal << "TSCAL" << ncol+1;
+	tzero << "TZERO" << ncol+1;
+	fits_read_key(infptr, TDOUBLE, tscal.str().c_str(), &scale, NULL, &status);
+	if(status == KEY_NO_EXIST)
+		status = 0;
+	fits_read_key(infptr, TDOUBLE, tzero.str().c_str(), &zero, NULL, &status);
+	if(status == KEY_NO_EXIST)
+		status = 0;
+
+	if(-coltype != typecode || scale != 1. || zero != 0.)
 	{
-		buff[i].resize(vsize);
-		memcpy(&buff[i][0], buffptrs[i], vsize);
-		delete buffptrs[i];
+		int anynull;
+		T nulval = 0;
+		for(long i=0; i<nrows && !status; i++)
+			if(lengths[i] > 0)
+				fits_read_col(infptr, type, ncol+1, frow+i+1, 1, lengths[i], &nulval, &values[offsets[i]], &anynull, &status);
+
+		if(status)
+			throwException("Error in InputFileFITS::readVar() ", status);
+		return;
+	}
+
+	// the heap follows the rows, unless THEAP says otherwise
+	LONGLONG headstart, datastart, dataend, heapstart, naxis1, naxis2;
+	fits_get_hduaddrll(infptr, &headstart, &datastart, &dataend, &status);
+	fits_read_key(infptr, TLONGLONG, "NAXIS1", &naxis1, NULL, &status);
+	fits_read_key(infptr, TLONGLONG, "NAXIS2", &naxis2, NULL, &status);
+	fits_read_key(infptr, TLONGLONG, "THEAP", &heapstart, NULL, &status);
+	if(status == KEY_NO_EXIST)
+	{
+		status = 0;
+		heapstart = naxis1 * naxis2;
+	}
+	if(status)
+		throwException("Error in InputFileFITS::readVar() ", status);
+
+	// one read for each run of rows stored one after the other in the heap
+	for(long row=0; row<nrows && !status; )
+	{
+		long end = row + 1;
+		while(end < nrows && heapOffsets[end] == heapOffsets[end-1] + lengths[end-1] * (LONGLONG) sizeof(T))
+			end++;
+
+		LONGLONG nelem = offsets[end] - offsets[row];
+		if(nelem > 0)
+		{
+			ffmbyt(infptr, datastart + heapstart + heapOffsets[row], 0 /* REPORT_EOF */, &status);
+			ffgbyt(infptr, nelem * sizeof(T), &values[offsets[row]], &status);
+		}
+		row = end;
 	}
+	if(status)
+		throwException("Error in InputFileFITS::readVar() ", status);
 
-	delete[] buffptrs;
+	if(sizeof(T) > 1 && !hostBigEndian() && !values.empty())
+		swapBytes<sizeof(T)>((char*) &values[0], values.size());
+}
+
+void InputFileFITS::getScaling(int ncol, double& scale, double& zero)
+{
+	int status = 0;
+	if(!isOpened())
+		throwException("Error in InputFileFITS::getScaling() ", status);
+
+	std::ostringstream tscal, tzero;
+	tscal << "TSCAL" << ncol+1;
+	tzero << "TZERO" << ncol+1;
+	scale = 1.;
+	zero = 0.;
+	fits_read_key(infptr, TDOUBLE, tscal.str().c_str(), &scale, NULL, &status);
+	if(status == KEY_NO_EXIST)
+		status = 0;
+	fits_read_key(infptr, TDOUBLE, tzero.str().c_str(), &zero, NULL, &status);
+	if(status == KEY_NO_EXIST)
+		status = 0;
 
 	if(status)
-		throwException("Error in InputFileFITS::readString() ", status);
+		throwException("Error in InputFileFITS::getScaling() ", status);
+}
 
-	return buff;
+void InputFileFITS::getImageScaling(double& scale, double& zero)
+{
+	int status = 0;
+	if(!isOpened())
+		throwException("Error in InputFileFITS::getImageScaling() ", status);
+
+	scale = 1.;
+	zero = 0.;
+	fits_read_key(infptr, TDOUBLE, "BSCALE", &scale, NULL, &status);
+	if(status == KEY_NO_EXIST)
+		status = 0;
+	fits_read_key(infptr, TDOUBLE, "BZERO", &zero, NULL, &status);
+	if(status == KEY_NO_EXIST)
+		status = 0;
+
+	if(status)
+		throwException("Error in InputFileFITS::getImageScaling() ", status);
+}
+
+void InputFileFITS::readScaled(int ncol, long frow, long lrow, float* buff, int vsize)
+{
+	_readScaled(ncol, frow, lrow, buff, vsize);
+}
+
+void InputFileFITS::readScaled(int ncol, long frow, long lrow, double* buff, int vsize)
+{
+	_readScaled(ncol, frow, lrow, buff, vsize);
+}
+
+// a loop without branches, vectorized by the compiler
+template<class S, class D>
+static void scaleValues(const S* src, D* dst, long n, D scale, D zero) {
+	for(long i=0; i<n; i++)
+		dst[i] = (D) src[i] * scale + zero;
+}
+
+template<class S, class D>
+static void readScaledAs(InputFileFITS& file, std::vector<char>& raw, int ncol, long frow, long lrow, D* buff, int vsize, double scale, double zero) {
+	long n = (lrow - frow + 1) * vsize;
+	raw.resize(n * sizeof(S));
+	file.readRaw(ncol, frow, lrow, (S*) &raw[0], vsize);
+	scaleValues((const S*) &raw[0], buff, n, (D) scale, (D) zero);
+}
+
+template<class D>
+void InputFileFITS::_readScaled(int ncol, long frow, long lrow, D* buff, int vsize)
+{
+	int status = 0;
+	if(!isOpened() || lrow < frow || vsize < 1)
+		throwException("Error in InputFileFITS::readScaled() ", status);
+
+	int typecode;
+	long repeat, width;
+	fits_get_coltype(infptr, ncol+1, &typecode, &repeat, &width, &status);
+	if(status)
+		throwException("Error in InputFileFITS::readScaled() ", status);
+
+	double scale, zero;
+	getScaling(ncol, scale, zero);
+
+	switch(typecode)
+	{
+		case TBYTE:
+			readScaledAs<uint8_t>(*this, rawValues, ncol, frow, lrow, buff, vsize, scale, zero);
+			break;
+		case TSHORT:
+			readScaledAs<int16_t>(*this, rawValues, ncol, frow, lrow, buff, vsize, scale, zero);
+			break;
+		case TLONG:
+			readScaledAs<int32_t>(*this, rawValues, ncol, frow, lrow, buff, vsize, scale, zero);
+			break;
+		case TLONGLONG:
+			readScaledAs<int64_t>(*this, rawValues, ncol, frow, lrow, buff, vsize, scale, zero);
+			break;
+		default:
+			// floating point columns, cfitsio scales them
+			read(ncol, frow, lrow, buff, vsize);
+			break;
+	}
+}
+
+void InputFileFITS::readImageRaw(Image<uint8_t>& image)
+{
+	_readImageRaw(image, TBYTE);
+}
+
+void InputFileFITS::readImageRaw(Image<int16_t>& image)
+{
+	_readImageRaw(image, TSHORT);
+}
+
+void InputFileFITS::readImageRaw(Image<int32_t>& image)
+{
+	_readImageRaw(image, TINT);
+}
+
+void InputFileFITS::readImageRaw(Image<int64_t>& image)
+{
+	_readImageRaw(image, TLONGLONG);
+}
+
+template<class T>
+void InputFileFITS::_readImageRaw(Image<T>& image, int type)
+{
+	double scale, zero;
+	getImageScaling(scale, zero);
+
+	int status = 0;
+	fits_set_bscale(infptr, 1., 0., &status);
+	if(status)
+		throwException("Error in InputFileFITS::readImageRaw() ", status);
+	try {
+		_readImage(image, type);
+	}
+	catch(IOException& e) {
+		fits_set_bscale(infptr, scale, zero, &status);
+		throw;
+	}
+	fits_set_bscale(infptr, scale, zero, &status);
+	if(status)
+		throwException("Error in InputFileFITS::readImageRaw() ", status);
 }
 
 Image<uint8_t> InputFileFITS::readImageu8i()
 {
-	Image<uint8_t> buff;
+	Image<uint8_t> buff(memoryBudget);
 	_readImage(buff, TBYTE);
 	return buff;
 }
 
 Image<int16_t> InputFileFITS::readImage16i()
 {
-	Image<int16_t> buff;
+	Image<int16_t> buff(memoryBudget);
 	_readImage(buff, TSHORT);
 	return buff;
 }
 
 Image<int32_t> InputFileFITS::readImage32if()
 {
-	Image<int32_t> buff;
+	Image<int32_t> buff(memoryBudget);
 	_readImage(buff, TINT);
 	return buff;
 }
 
 Image<int64_t> InputFileFITS::readImage64i()
 {
-	Image<int64_t> buff;
+	Image<int64_t> buff(memoryBudget);
 	_readImage(buff, TLONG);
 	return buff;
 }
 
 Image<float> InputFileFITS::readImage32f()
 {
-	Image<float> buff;
+	Image<float> buff(memoryBudget);
 	_readImage(buff, TFLOAT);
 	return buff;
 }
 
 Image<double> InputFileFITS::readImage64f()
 {
-	Image<double> buff;
+	Image<double> buff(memoryBudget);
 	_readImage(buff, TDOUBLE);
 	return buff;
 }
@@ -350,7 +923,8 @@ void InputFileFITS::_readv(int ncol, std::vector< std::vector<T> >& buff, int ty
 	long nelem = (lrow - frow + 1);
 	long null = 0;
 
-	T* buffptr = new T[nelem*vsize];
+	Arena arena(0);
+	T* buffptr = arena.allocate<T>(nelem*vsize);
 	fits_read_col(infptr, type, ncol+1, frow+1, 1, nelem*vsize, &null,  buffptr, &anynull, &status);
 
 	// conversion from row pointers to std::vector< std::vector<T> >
@@ -361,14 +935,152 @@ void InputFileFITS::_readv(int ncol, std::vector< std::vector<T> >& buff, int ty
 	for(unsigned int row = 0; row < nelem; row++)
 		memcpy(&buff[row][0], &buffptr[row*vsize], vsize*sizeof(T));
 
-	delete[] buffptr;
-
 	if(status)
 		throwException("Error in InputFileFITS::_readv() ", status);
 }
 
 template<class T>
-void InputFileFITS::_readImage(Image<T>& buff, int type)
+void InputFileFITS::_readNull(int ncol, T* buff, long nelem, int type, long frow, ValidityBitmap& validity) {
+	int status = 0;
+	if(!isOpened())
+		throwException("Error in InputFileFITS::_readNull() ", status);
+
+	// cfitsio flags the undefined values while converting them
+	int anynull = 0;
+	nullFlags.resize(nelem);
+	fits_read_colnull(infptr, type, ncol+1, frow+1, 1, nelem, buff, &nullFlags[0], &anynull, &status);
+
+	if(status)
+		throwException("Error in InputFileFITS::_readNull() ", status);
+
+	if(anynull)
+		validity.setNulls(&nullFlags[0], nelem);
+	else
+		validity.resize(nelem, true);
+}
+
+template<class T>
+std::vector<T> InputFileFITS::_readNull(int ncol, int type, long frow, long lrow, ValidityBitmap& validity) {
+	long nelem = lrow - frow + 1;
+	if(nelem < 1)
+		throwException("Error in InputFileFITS::_readNull() ", 0);
+
+	std::vector<T> buff(nelem);
+	_readNull(ncol, &buff[0], nelem, type, frow, validity);
+	return buff;
+}
+
+template<class T>
+std::vector< std::vector<T> > InputFileFITS::_readNullv(int ncol, int type, long frow, long lrow, int vsize, ValidityBitmap& validity) {
+	long nrows = lrow - frow + 1;
+	if(nrows < 1 || vsize < 1)
+		throwException("Error in InputFileFITS::_readNullv() ", 0);
+
+	std::vector<T> values(nrows * vsize);
+	_readNull(ncol, &values[0], nrows * vsize, type, frow, validity);
+
+	std::vector< std::vector<T> > buff(nrows);
+	for(long row=0; row<nrows; row++)
+		buff[row].assign(values.begin() + row * vsize, values.begin() + (row + 1) * vsize);
+	return buff;
+}
+
+std::vector<uint8_t> InputFileFITS::readu8i(int ncol, long frow, long lrow, ValidityBitmap& validity) {
+	return _readNull<uint8_t>(ncol, TBYTE, frow, lrow, validity);
+}
+
+std::vector<int16_t> InputFileFITS::read16i(int ncol, long frow, long lrow, ValidityBitmap& validity) {
+	return _readNull<int16_t>(ncol, TSHORT, frow, lrow, validity);
+}
+
+std::vector<uint16_t> InputFileFITS::read16u(int ncol, long frow, long lrow, ValidityBitmap& validity) {
+	return _readNull<uint16_t>(ncol, TUSHORT, frow, lrow, validity);
+}
+
+std::vector<int32_t> InputFileFITS::read32i(int ncol, long frow, long lrow, ValidityBitmap& validity) {
+	return _readNull<int32_t>(ncol, TINT, frow, lrow, validity);
+}
+
+std::vector<int64_t> InputFileFITS::read64i(int ncol, long frow, long lrow, ValidityBitmap& validity) {
+	return _readNull<int64_t>(ncol, TLONG, frow, lrow, validity);
+}
+
+std::vector<float> InputFileFITS::read32f(int ncol, long frow, long lrow, ValidityBitmap& validity) {
+	return _readNull<float>(ncol, TFLOAT, frow, lrow, validity);
+}
+
+std::vector<double> InputFileFITS::read64f(int ncol, long frow, long lrow, ValidityBitmap& validity) {
+	return _readNull<double>(ncol, TDOUBLE, frow, lrow, validity);
+}
+
+std::vector< std::vector<uint8_t> > InputFileFITS::readu8iv(int ncol, long frow, long lrow, int vsize, ValidityBitmap& validity) {
+	return _readNullv<uint8_t>(ncol, TBYTE, frow, lrow, vsize, validity);
+}
+
+std::vector< std::vector<int16_t> > InputFileFITS::read16iv(int ncol, long frow, long lrow, int vsize, ValidityBitmap& validity) {
+	return _readNullv<int16_t>(ncol, TSHORT, frow, lrow, vsize, validity);
+}
+
+std::vector< std::vector<int32_t> > InputFileFITS::read32iv(int ncol, long frow, long lrow, int vsize, ValidityBitmap& validity) {
+	return _readNullv<int32_t>(ncol, TINT, frow, lrow, vsize, validity);
+}
+
+std::vector< std::vector<int64_t> > InputFileFITS::read64iv(int ncol, long frow, long lrow, int vsize, ValidityBitmap& validity) {
+	return _readNullv<int64_t>(ncol, TLONG, frow, lrow, vsize, validity);
+}
+
+std::vector< std::vector<float> > InputFileFITS::read32fv(int ncol, long frow, long lrow, int vsize, ValidityBitmap& validity) {
+	return _readNullv<float>(ncol, TFLOAT, frow, lrow, vsize, validity);
+}
+
+std::vector< std::vector<double> > InputFileFITS::read64fv(int ncol, long frow, long lrow, int vsize, ValidityBitmap& validity) {
+	return _readNullv<double>(ncol, TDOUBLE, frow, lrow, vsize, validity);
+}
+
+Image<uint8_t> InputFileFITS::readImageu8i(ValidityBitmap& validity)
+{
+	Image<uint8_t> buff(memoryBudget);
+	_readImage(buff, TBYTE, &validity);
+	return buff;
+}
+
+Image<int16_t> InputFileFITS::readImage16i(ValidityBitmap& validity)
+{
+	Image<int16_t> buff(memoryBudget);
+	_readImage(buff, TSHORT, &validity);
+	return buff;
+}
+
+Image<int32_t> InputFileFITS::readImage32if(ValidityBitmap& validity)
+{
+	Image<int32_t> buff(memoryBudget);
+	_readImage(buff, TINT, &validity);
+	return buff;
+}
+
+Image<int64_t> InputFileFITS::readImage64i(ValidityBitmap& validity)
+{
+	Image<int64_t> buff(memoryBudget);
+	_readImage(buff, TLONG, &validity);
+	return buff;
+}
+
+Image<float> InputFileFITS::readImage32f(ValidityBitmap& validity)
+{
+	Image<float> buff(memoryBudget);
+	_readImage(buff, TFLOAT, &validity);
+	return buff;
+}
+
+Image<double> InputFileFITS::readImage64f(ValidityBitmap& validity)
+{
+	Image<double> buff(memoryBudget);
+	_readImage(buff, TDOUBLE, &validity);
+	return buff;
+}
+
+template<class T>
+void InputFileFITS::_readImage(Image<T>& buff, int type, ValidityBitmap* validity)
 {
 	int status = 0;
 	if(!isOpened())
@@ -379,7 +1091,7 @@ void InputFileFITS::_readImage(Image<T>& buff, int type)
 	const int MAXDIM = 12;
 	long naxes[MAXDIM];
 	fits_get_img_param(infptr, MAXDIM,  &bitpix, &naxis, naxes, &status);
-	if(!isOpened())
+	if(status)
 		throwException("Error in InputFileFITS::_readImage() ", status);
 
 
@@ -395,10 +1107,25 @@ void InputFileFITS::_readImage(Image<T>& buff, int type)
 	int anynul;
 
 	buff.data.resize(nelements);
-	fits_read_pix(infptr, type, fpixel, nelements, &nulval, &buff.data[0], &anynul, &status);
-	if(!isOpened())
+	if(validity)
+	{
+		anynul = 0;
+		nullFlags.resize(nelements);
+		fits_read_pixnull(infptr, type, fpixel, nelements, &buff.data[0], &nullFlags[0], &anynul, &status);
+	}
+	else
+		fits_read_pix(infptr, type, fpixel, nelements, &nulval, &buff.data[0], &anynul, &status);
+	if(status)
 		throwException("Error in InputFileFITS::_readImage() ", status);
 
+	if(validity)
+	{
+		if(anynul)
+			validity->setNulls(&nullFlags[0], nelements);
+		else
+			validity->resize(nelements, true);
+	}
+
 	buff.dim = naxis;
 
 	buff.sizes.resize(0);
@@ -19,10 +19,19 @@
 #include <stdint.h>
 #include <fitsio.h>
 #include "InputFile.h"
+#include "StringColumn.h"
+#include "ValidityBitmap.h"
+#include "VarColumn.h"
+#include "BitColumn.h"
+#include "FitsTraits.h"
 
 namespace qlbase {
 
 /// FITS file reader (cfitsio wrapping class).
+/// Tile-compressed tables (the FITS tiled table convention) are uncompressed
+/// in memory when moving to them, and read as the other tables. The copy is
+/// charged to the memory budget (see setMemoryBudget()) until moving to
+/// another header.
 /// All methods except isOpened() throw qlbase::IOException on errors.
 class InputFileFITS : public InputFile {
 
@@ -35,6 +44,12 @@ class InputFileFITS : public InputFile {
 		/// Open a fits file.
 		virtual void open(const std::string &filename);
 
+		/// Open a fits file from memory, read in place. The buffer must
+		/// stay valid until close().
+		/// \param[in] buffer The FITS bytes.
+		/// \param[in] size The buffer size.
+		void openMemory(const void* buffer, size_t size);
+
 		/// Close a fits file.
 		virtual void close();
 		virtual bool isOpened() { return opened; }
@@ -55,6 +70,16 @@ class InputFileFITS : public InputFile {
 		/// Get column number from the name.
 		virtual int getColNum(const std::string& columnName);
 
+		/// Get the name, type, vsize and unit of a column, as given to
+		/// OutputFileFITS::createTable(). Variable length array columns have
+		/// vsize 0, string columns the width.
+		field getField(int ncol);
+
+		/// Check if the file changed on disk and return the number of rows
+		/// appended to the current table (NAXIS2 increase). When the file is
+		/// unchanged this costs a stat() call. Memory files never change.
+		virtual long refresh();
+
 		/// Read a column of bytes (fits type 1B).
 		/// \param[in] ncol Column number (starting from 0).
 		/// \param[in] frow First row (starting from 0).
@@ -74,6 +99,14 @@ class InputFileFITS : public InputFile {
 		/// Read a column of 64 bit integers (fits type 1K).
 		virtual std::vector<int64_t> read64i(int ncol, long frow, long lrow);
 
+		/// Read a column of 32 bit unsigned integers (fits type 1J with
+		/// TZERO = 2147483648).
+		virtual std::vector<uint32_t> read32u(int ncol, long frow, long lrow);
+
+		/// Read a column of 64 bit unsigned integers (fits type 1K with
+		/// TZERO = 9223372036854775808).
+		virtual std::vector<uint64_t> read64u(int ncol, long frow, long lrow);
+
 		/// Read a column of float (fits type 1E).
 		virtual std::vector<float> read32f(int ncol, long frow, long lrow);
 
@@ -110,8 +143,87 @@ class InputFileFITS : public InputFile {
 		virtual std::vector< std::vector<double> > read64fv(int ncol, long frow, long lrow, int vsize);
 
 		/// Read a column of strings (fits type for es. 20A).
+		/// \param[in] vsize The bytes of each row, the terminator included.
 		virtual std::vector< std::vector<char> > readString(int ncol, long frow, long lrow, int vsize);
 
+		/// Read a column into caller memory, the cfitsio type of T is
+		/// resolved at compile time (see FitsTraits).
+		/// \param[out] buff (lrow-frow+1)*vsize values, row after row.
+		template<class T>
+		void read(int ncol, long frow, long lrow, T* buff, int vsize = 1);
+
+		/// Get the TSCALn and TZEROn of a column, 1 and 0 when missing.
+		/// The reads return scale * stored + zero.
+		void getScaling(int ncol, double& scale, double& zero);
+
+		/// Get the BSCALE and BZERO of the current image, 1 and 0 when
+		/// missing.
+		void getImageScaling(double& scale, double& zero);
+
+		/// Read the stored values of a column, without TSCALn and TZEROn
+		/// (see getScaling()). T is the column type for a plain copy, e.g.
+		/// to write them to a table with the same scaling.
+		template<class T>
+		void readRaw(int ncol, long frow, long lrow, T* buff, int vsize = 1);
+
+		/// Read the physical values of a scaled integer column: the stored
+		/// values are read, then scaled in one multiply-add loop.
+		/// \param[out] buff (lrow-frow+1)*vsize values, row after row.
+		void readScaled(int ncol, long frow, long lrow, float* buff, int vsize = 1);
+		void readScaled(int ncol, long frow, long lrow, double* buff, int vsize = 1);
+
+		/// Read the stored pixels of the current image, without BSCALE and
+		/// BZERO (see getImageScaling()).
+		void readImageRaw(Image<uint8_t>& image);
+		void readImageRaw(Image<int16_t>& image);
+		void readImageRaw(Image<int32_t>& image);
+		void readImageRaw(Image<int64_t>& image);
+
+		/// Read a column of strings in one buffer, without allocations for
+		/// each row. The width is the column one, the buffer is reused.
+		/// \param[out] column The strings.
+		void readString(int ncol, long frow, long lrow, StringColumn& column);
+
+		/// Read a variable length array column (fits type for es. 1PJ or
+		/// 1QJ). When the column has the requested type the values of
+		/// consecutive rows are read from the heap at once, otherwise they
+		/// are converted row by row.
+		/// \param[out] column The rows frow to lrow, the buffers are reused.
+		void readVar(int ncol, long frow, long lrow, VarColumn<uint8_t>& column);
+		void readVar(int ncol, long frow, long lrow, VarColumn<int16_t>& column);
+		void readVar(int ncol, long frow, long lrow, VarColumn<int32_t>& column);
+		void readVar(int ncol, long frow, long lrow, VarColumn<int64_t>& column);
+		void readVar(int ncol, long frow, long lrow, VarColumn<float>& column);
+		void readVar(int ncol, long frow, long lrow, VarColumn<double>& column);
+
+		/// Read a column of bits (fits type for es. 16X) as packed words.
+		/// \param[out] column The rows frow to lrow, the buffer is reused.
+		void readBits(int ncol, long frow, long lrow, BitColumn& column);
+
+		/// Read a column of logicals (fits type for es. 16L) as packed
+		/// words, undefined values are false.
+		void readLogical(int ncol, long frow, long lrow, BitColumn& column);
+
+		/// Read a column with its undefined values (TNULL, or NaN for the
+		/// float columns) in the same pass. Undefined values are 0.
+		/// \param[out] validity A bit for each value, 0 if undefined.
+		std::vector<uint8_t> readu8i(int ncol, long frow, long lrow, ValidityBitmap& validity);
+		std::vector<int16_t> read16i(int ncol, long frow, long lrow, ValidityBitmap& validity);
+		std::vector<uint16_t> read16u(int ncol, long frow, long lrow, ValidityBitmap& validity);
+		std::vector<int32_t> read32i(int ncol, long frow, long lrow, ValidityBitmap& validity);
+		std::vector<int64_t> read64i(int ncol, long frow, long lrow, ValidityBitmap& validity);
+		std::vector<float> read32f(int ncol, long frow, long lrow, ValidityBitmap& validity);
+		std::vector<double> read64f(int ncol, long frow, long lrow, ValidityBitmap& validity);
+
+		/// Read a vector column with its undefined values, the bit of value
+		/// j of row i is (i - frow) * vsize + j.
+		std::vector< std::vector<uint8_t> > readu8iv(int ncol, long frow, long lrow, int vsize, ValidityBitmap& validity);
+		std::vector< std::vector<int16_t> > read16iv(int ncol, long frow, long lrow, int vsize, ValidityBitmap& validity);
+		std::vector< std::vector<int32_t> > read32iv(int ncol, long frow, long lrow, int vsize, ValidityBitmap& validity);
+		std::vector< std::vector<int64_t> > read64iv(int ncol, long frow, long lrow, int vsize, ValidityBitmap& validity);
+		std::vector< std::vector<float> > read32fv(int ncol, long frow, long lrow, int vsize, ValidityBitmap& validity);
+		std::vector< std::vector<double> > read64fv(int ncol, long frow, long lrow, int vsize, ValidityBitmap& validity);
+
 		/// Read a multidimensional image of bytes.
 		/// \return The Image structure holding the image data, dimensions and its sizes.
 		virtual Image<uint8_t> readImageu8i();
@@ -131,6 +243,15 @@ class InputFileFITS : public InputFile {
 		/// Read a multidimensional image of 64bit double.
 		virtual Image<double> readImage64f();
 
+		/// Read an image with its undefined pixels (BLANK, or NaN for the
+		/// float images), a bit for each pixel.
+		Image<uint8_t> readImageu8i(ValidityBitmap& validity);
+		Image<int16_t> readImage16i(ValidityBitmap& validity);
+		Image<int32_t> readImage32if(ValidityBitmap& validity);
+		Image<int64_t> readImage64i(ValidityBitmap& validity);
+		Image<float> readImage32f(ValidityBitmap& validity);
+		Image<double> readImage64f(ValidityBitmap& validity);
+
 		/// Return the internal file descriptor
 		virtual const fitsfile* GetFilePointer()
 		{
@@ -141,8 +262,30 @@ class InputFileFITS : public InputFile {
 
 	bool opened;
 
+	/// Size and modification time (ns) of the file at the last check.
+	int64_t fileSize;
+	int64_t fileMTime;
+
 	void throwException(const char *msg, int status);
 
+	bool statFile(int64_t& size, int64_t& mtime);
+
+	/// The memory file buffer, read only.
+	void* memBuffer;
+	size_t memSize;
+
+	/// The file, and the uncompressed copy of the current compressed table
+	/// (0 if none). infptr points to the one being read.
+	fitsfile *filefptr;
+	fitsfile *tablefptr;
+
+	/// The budget charged for the uncompressed copy, and the bytes charged.
+	MemoryBudget* tableBudget;
+	int64_t tableBytes;
+
+	void uncompressTable();
+	void closeTable();
+
 	template<class T>
 	void _read(int ncol, std::vector<T>& buff, int type, long frow, long lrow);
 
@@ -150,13 +293,81 @@ class InputFileFITS : public InputFile {
 	void _readv(int ncol, std::vector< std::vector<T> >& buff, int type, long frow, long lrow, int vsize);
 
 	template<class T>
-	void _readImage(Image<T>& buff, int type);
+	void _readVar(int ncol, long frow, long lrow, VarColumn<T>& column, int type, int typecode);
+
+	template<class T>
+	void _readImage(Image<T>& buff, int type, ValidityBitmap* validity = 0);
+
+	/// The null flags of the reads with a validity bitmap, reused.
+	std::vector<char> nullFlags;
+
+	/// The FITS bytes of the bit and logical reads, reused.
+	std::vector<char> bitBytes;
+
+	/// The stored values of the scaled reads, reused.
+	std::vector<char> rawValues;
+
+	template<class D>
+	void _readScaled(int ncol, long frow, long lrow, D* buff, int vsize);
+
+	template<class T>
+	void _readImageRaw(Image<T>& image, int type);
+
+	int _getBitColumn(int ncol, int type, long frow, long lrow, const char* method);
+
+	template<class T>
+	void _readNull(int ncol, T* buff, long nelem, int type, long frow, ValidityBitmap& validity);
+
+	template<class T>
+	std::vector<T> _readNull(int ncol, int type, long frow, long lrow, ValidityBitmap& validity);
+
+	template<class T>
+	std::vector< std::vector<T> > _readNullv(int ncol, int type, long frow, long lrow, int vsize, ValidityBitmap& validity);
 
 	protected:
 
 	fitsfile *infptr;
 };
 
+template<class T>
+void InputFileFITS::readRaw(int ncol, long frow, long lrow, T* buff, int vsize) {
+	int status = 0;
+	if(!isOpened())
+		throwException("Error in InputFileFITS::readRaw() ", status);
+
+	double scale, zero;
+	getScaling(ncol, scale, zero);
+
+	// cfitsio scales with the values set, the keywords are unchanged
+	fits_set_tscale(infptr, ncol+1, 1., 0., &status);
+	if(status)
+		throwException("Error in InputFileFITS::readRaw() ", status);
+	try {
+		read(ncol, frow, lrow, buff, vsize);
+	}
+	catch(IOException& e) {
+		fits_set_tscale(infptr, ncol+1, scale, zero, &status);
+		throw;
+	}
+	fits_set_tscale(infptr, ncol+1, scale, zero, &status);
+	if(status)
+		throwException("Error in InputFileFITS::readRaw() ", status);
+}
+
+template<class T>
+void InputFileFITS::read(int ncol, long frow, long lrow, T* buff, int vsize) {
+	int status = 0;
+	if(!isOpened() || lrow < frow)
+		throwException("Error in InputFileFITS::read() ", status);
+
+	int anynull;
+	T nulval = 0;
+	fits_read_col(infptr, FitsTraits<T>::datatype, ncol+1, frow+1, 1, (lrow - frow + 1) * vsize, &nulval, buff, &anynull, &status);
+
+	if(status)
+		throwException("Error in InputFileFITS::read() ", status);
+}
+
 }
 
 #endif
@@ -0,0 +1,249 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <algorithm>
+#include <strings.h>
+#include "InputFileSHM.h"
+
+namespace qlbase {
+
+InputFileSHM::InputFileSHM() : nrows(0) {
+}
+
+InputFileSHM::~InputFileSHM() {
+}
+
+void InputFileSHM::open(const std::string &name) {
+	if(ring.isAttached())
+		throw IOException("Error in InputFileSHM::open() already opened", 0);
+
+	File::open(name);
+	ring.attach(name);
+	nrows = ring.getCommitted();
+}
+
+void InputFileSHM::close() {
+	ring.detach();
+	nrows = 0;
+}
+
+void InputFileSHM::moveToHeader(int number) {
+	if(!isOpened() || number != 0)
+		throw IOException("Error in InputFileSHM::moveToHeader() ", 0);
+}
+
+int InputFileSHM::getNCols() {
+	if(!isOpened())
+		throw IOException("Error in InputFileSHM::getNCols() ", 0);
+
+	return ring.getFields().size();
+}
+
+long InputFileSHM::getNRows() {
+	if(!isOpened())
+		throw IOException("Error in InputFileSHM::getNRows() ", 0);
+
+	return nrows;
+}
+
+int InputFileSHM::getColNum(const std::string& columnName) {
+	if(!isOpened())
+		throw IOException("Error in InputFileSHM::getColNum() ", 0);
+
+	const std::vector<field>& fields = ring.getFields();
+	for(unsigned int i=0; i<fields.size(); i++)
+		if(strcasecmp(fields[i].name.c_str(), columnName.c_str()) == 0)
+			return i;
+
+	throw IOException("Error in InputFileSHM::getColNum() no column " + columnName, 0);
+}
+
+long InputFileSHM::refresh() {
+	if(!isOpened())
+		throw IOException("Error in InputFileSHM::refresh() ", 0);
+
+	long before = nrows;
+	nrows = ring.getCommitted();
+	return nrows - before;
+}
+
+long InputFileSHM::getFirstRow() {
+	if(!isOpened())
+		throw IOException("Error in InputFileSHM::getFirstRow() ", 0);
+
+	return ring.getFirstRow();
+}
+
+bool InputFileSHM::isWriterClosed() {
+	if(!isOpened())
+		throw IOException("Error in InputFileSHM::isWriterClosed() ", 0);
+
+	return ring.isClosed();
+}
+
+void InputFileSHM::check(int ncol, long frow, long lrow, int vsize) {
+	if(!isOpened())
+		throw IOException("Error in InputFileSHM::read() ", 0);
+	if(ncol < 0 || ncol >= (int) ring.getFields().size() || ring.getFields()[ncol].vsize != vsize)
+		throw IOException("Error in InputFileSHM::read() invalid column", 0);
+	if(frow < 0 || lrow < frow || lrow >= nrows)
+		throw IOException("Error in InputFileSHM::read() invalid rows", 0);
+	if(frow < ring.getFirstRow())
+		throw IOException("Error in InputFileSHM::read() rows overwritten by the writer", 0);
+}
+
+const void* InputFileSHM::getData(int ncol, long frow, long lrow, long& nrows) {
+	if(!isOpened() || ncol < 0 || ncol >= (int) ring.getFields().size())
+		throw IOException("Error in InputFileSHM::getData() ", 0);
+
+	check(ncol, frow, lrow, ring.getFields()[ncol].vsize);
+
+	long capacity = ring.getCapacity();
+	nrows = std::min(lrow - frow + 1, capacity - frow % capacity);
+	return ring.getSlot(ncol, frow);
+}
+
+// Copy and convert the values, then check that the writer didn't reach the
+// rows meanwhile.
+template<class T>
+void InputFileSHM::_read(int ncol, T* buff, long frow, long lrow, int vsize) {
+	check(ncol, frow, lrow, vsize);
+
+	fieldType type = ring.getFields()[ncol].type;
+	long capacity = ring.getCapacity();
+	long row = frow;
+	while(row <= lrow) {
+		long n = std::min(lrow - row + 1, capacity - row % capacity);
+		const char* src = ring.getSlot(ncol, row);
+		T* dst = buff + (row - frow) * vsize;
+
+		loadAs(type, dst, src, n * vsize);
+		row += n;
+	}
+
+	if(frow < ring.getFirstRow())
+		throw IOException("Error in InputFileSHM::read() rows overwritten by the writer", 0);
+}
+
+template<class T>
+std::vector<T> InputFileSHM::_read(int ncol, long frow, long lrow) {
+	std::vector<T> buff(lrow >= frow ? lrow - frow + 1 : 0);
+	_read(ncol, buff.data(), frow, lrow, 1);
+	return buff;
+}
+
+template<class T>
+std::vector< std::vector<T> > InputFileSHM::_readv(int ncol, long frow, long lrow, int vsize) {
+	long n = lrow >= frow ? lrow - frow + 1 : 0;
+	std::vector<T> values(n * vsize);
+	_read(ncol, values.data(), frow, lrow, vsize);
+
+	std::vector< std::vector<T> > buff(n);
+	for(long i=0; i<n; i++)
+		buff[i].assign(values.begin() + i * vsize, values.begin() + (i + 1) * vsize);
+	return buff;
+}
+
+std::vector<uint8_t> InputFileSHM::readu8i(int ncol, long frow, long lrow) {
+	return _read<uint8_t>(ncol, frow, lrow);
+}
+
+std::vector<int16_t> InputFileSHM::read16i(int ncol, long frow, long lrow) {
+	return _read<int16_t>(ncol, frow, lrow);
+}
+
+std::vector<uint16_t> InputFileSHM::read16u(int ncol, long frow, long lrow) {
+	return _read<uint16_t>(ncol, frow, lrow);
+}
+
+std::vector<int32_t> InputFileSHM::read32i(int ncol, long frow, long lrow) {
+	return _read<int32_t>(ncol, frow, lrow);
+}
+
+std::vector<int64_t> InputFileSHM::read64i(int ncol, long frow, long lrow) {
+	return _read<int64_t>(ncol, frow, lrow);
+}
+
+std::vector<uint32_t> InputFileSHM::read32u(int ncol, long frow, long lrow) {
+	return _read<uint32_t>(ncol, frow, lrow);
+}
+
+std::vector<uint64_t> InputFileSHM::read64u(int ncol, long frow, long lrow) {
+	return _read<uint64_t>(ncol, frow, lrow);
+}
+
+std::vector<float> InputFileSHM::read32f(int ncol, long frow, long lrow) {
+	return _read<float>(ncol, frow, lrow);
+}
+
+std::vector<double> InputFileSHM::read64f(int ncol, long frow, long lrow) {
+	return _read<double>(ncol, frow, lrow);
+}
+
+std::vector< std::vector<uint8_t> > InputFileSHM::readu8iv(int ncol, long frow, long lrow, int vsize) {
+	return _readv<uint8_t>(ncol, frow, lrow, vsize);
+}
+
+std::vector< std::vector<int16_t> > InputFileSHM::read16iv(int ncol, long frow, long lrow, int vsize) {
+	return _readv<int16_t>(ncol, frow, lrow, vsize);
+}
+
+std::vector< std::vector<int32_t> > InputFileSHM::read32iv(int ncol, long frow, long lrow, int vsize) {
+	return _readv<int32_t>(ncol, frow, lrow, vsize);
+}
+
+std::vector< std::vector<int64_t> > InputFileSHM::read64iv(int ncol, long frow, long lrow, int vsize) {
+	return _readv<int64_t>(ncol, frow, lrow, vsize);
+}
+
+std::vector< std::vector<float> > InputFileSHM::read32fv(int ncol, long frow, long lrow, int vsize) {
+	return _readv<float>(ncol, frow, lrow, vsize);
+}
+
+std::vector< std::vector<double> > InputFileSHM::read64fv(int ncol, long frow, long lrow, int vsize) {
+	return _readv<double>(ncol, frow, lrow, vsize);
+}
+
+std::vector< std::vector<char> > InputFileSHM::readString(int ncol, long frow, long lrow, int vsize) {
+	if(isOpened() && ncol >= 0 && ncol < (int) ring.getFields().size() && ring.getFields()[ncol].type != STRING)
+		throw IOException("Error in InputFileSHM::readString() not a string column", 0);
+
+	return _readv<char>(ncol, frow, lrow, vsize);
+}
+
+Image<uint8_t> InputFileSHM::readImageu8i() {
+	throw IOException("Error in InputFileSHM::readImageu8i() images are not supported", 0);
+}
+
+Image<int16_t> InputFileSHM::readImage16i() {
+	throw IOException("Error in InputFileSHM::readImage16i() images are not supported", 0);
+}
+
+Image<int32_t> InputFileSHM::readImage32if() {
+	throw IOException("Error in InputFileSHM::readImage32if() images are not supported", 0);
+}
+
+Image<int64_t> InputFileSHM::readImage64i() {
+	throw IOException("Error in InputFileSHM::readImage64i() images are not supported", 0);
+}
+
+Image<float> InputFileSHM::readImage32f() {
+	throw IOException("Error in InputFileSHM::readImage32f() images are not supported", 0);
+}
+
+Image<double> InputFileSHM::readImage64f() {
+	throw IOException("Error in InputFileSHM::readImage64f() images are not supported", 0);
+}
+
+}
@@ -0,0 +1,120 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_INPUTFILESHM_H
+#define QL_IO_INPUTFILESHM_H
+
+#include <stdint.h>
+#include "InputFile.h"
+#include "SharedRing.h"
+
+namespace qlbase {
+
+/// Read a table published by an OutputFileSHM through shared memory.
+/// The file has one header, the table. refresh() sees the rows published
+/// since the last call with an atomic load, so a FileFollower on this file
+/// costs no system calls. Only the last capacity rows can be read: reading
+/// older rows, or rows overwritten while being copied, throws an
+/// IOException. Rows can also be used in place with getData().
+/// Images are not supported.
+/// All methods except isOpened() throw qlbase::IOException on errors.
+class InputFileSHM : public InputFile {
+
+	public:
+
+		InputFileSHM();
+
+		virtual ~InputFileSHM();
+
+		/// Map the segment of a writer, the table must be created.
+		virtual void open(const std::string &name);
+
+		virtual void close();
+		virtual bool isOpened() { return ring.isAttached(); }
+
+		virtual int getHeadersNum() { return 1; }
+		virtual void moveToHeader(int number);
+
+		virtual int getNCols();
+
+		/// Get the number of rows published at the last refresh().
+		virtual long getNRows();
+
+		virtual int getColNum(const std::string& columnName);
+
+		virtual long refresh();
+
+		/// Get the first row that can still be read.
+		long getFirstRow();
+
+		/// Check if the writer has closed the table.
+		bool isWriterClosed();
+
+		/// Get the values of a column in place, in the column type: the rows
+		/// from frow up to lrow or to the end of the ring.
+		/// \param[out] nrows The number of rows available at the address.
+		/// \return The address of the first value.
+		const void* getData(int ncol, long frow, long lrow, long& nrows);
+
+		/// Check if the writer may have overwritten row frow, after using the
+		/// values got with getData().
+		bool isAvailable(long frow) { return frow >= getFirstRow(); }
+
+		virtual std::vector<uint8_t> readu8i(int ncol, long frow, long lrow);
+		virtual std::vector<int16_t> read16i(int ncol, long frow, long lrow);
+		virtual std::vector<uint16_t> read16u(int ncol, long frow, long lrow);
+		virtual std::vector<int32_t> read32i(int ncol, long frow, long lrow);
+		virtual std::vector<int64_t> read64i(int ncol, long frow, long lrow);
+		virtual std::vector<uint32_t> read32u(int ncol, long frow, long lrow);
+		virtual std::vector<uint64_t> read64u(int ncol, long frow, long lrow);
+		virtual std::vector<float> read32f(int ncol, long frow, long lrow);
+		virtual std::vector<double> read64f(int ncol, long frow, long lrow);
+
+		virtual std::vector< std::vector<uint8_t> > readu8iv(int ncol, long frow, long lrow, int vsize);
+		virtual std::vector< std::vector<int16_t> > read16iv(int ncol, long frow, long lrow, int vsize);
+		virtual std::vector< std::vector<int32_t> > read32iv(int ncol, long frow, long lrow, int vsize);
+		virtual std::vector< std::vector<int64_t> > read64iv(int ncol, long frow, long lrow, int vsize);
+		virtual std::vector< std::vector<float> > read32fv(int ncol, long frow, long lrow, int vsize);
+		virtual std::vector< std::vector<double> > read64fv(int ncol, long frow, long lrow, int vsize);
+		virtual std::vector< std::vector<char> > readString(int ncol, long frow, long lrow, int vsize);
+
+		virtual Image<uint8_t> readImageu8i();
+		virtual Image<int16_t> readImage16i();
+		virtual Image<int32_t> readImage32if();
+		virtual Image<int64_t> readImage64i();
+		virtual Image<float> readImage32f();
+		virtual Image<double> readImage64f();
+
+	private:
+
+	SharedRing ring;
+
+	/// Rows published at the last refresh().
+	long nrows;
+
+	void check(int ncol, long frow, long lrow, int vsize);
+
+	template<class T>
+	void _read(int ncol, T* buff, long frow, long lrow, int vsize);
+
+	template<class T>
+	std::vector<T> _read(int ncol, long frow, long lrow);
+
+	template<class T>
+	std::vector< std::vector<T> > _readv(int ncol, long frow, long lrow, int vsize);
+};
+
+}
+
+#endif
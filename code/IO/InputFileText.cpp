@@ -16,6 +16,14 @@
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <thread>
 #include "Definitions.h"
 #include "InputFileText.h"
 
@@ -31,13 +39,12 @@ void InputFileText::readData(std::vector<T> &buff, int ncol, long frow, long lro
 	int buff_sz = lrow - frow + 1;
 	int buff_off = 0;
 
-	fileStream.clear();
-	fileStream.seekg(0, std::ios::beg);
+	pointTo(frow);
 
 	buff.resize(buff_sz);
 	for(int i = frow; i < lrow+1; i++) {
 		std::string line;
-		if(getline(fileStream, line)) {
+		if(readLine(line)) {
 			int first = 0;
 			int last  = 0;
 			int colCounter = 0;
@@ -57,11 +64,13 @@ void InputFileText::readData(std::vector<T> &buff, int ncol, long frow, long lro
 	}
 }
 
-InputFileText::InputFileText(const std::string &separator) : opened(false), nrows(0), ncols(0) {
+InputFileText::InputFileText(const std::string &separator) : opened(false), compressedBuffer(0), fileStream(0),
+                                                             sidecar(false), ncols(0), nrows(0) {
 	this->separator = separator;
 }
 
 InputFileText::~InputFileText() {
+	delete compressedBuffer;
 }
 
 void InputFileText::open(const std::string &filename) {
@@ -70,41 +79,191 @@ void InputFileText::open(const std::string &filename) {
 	fileStream.clear();
 
 	// Try to open new file
-	fileStream.open(filename.c_str());
-    if(!fileStream.is_open())
-		throw IOException("Error in InputFileText::Open()", 0);
+	CompressedStreamBuf::Format format = CompressedStreamBuf::detect(filename);
+	if(format == CompressedStreamBuf::PLAIN) {
+		plainBuffer.open(filename.c_str(), std::ios::in);
+		if(!plainBuffer.is_open())
+			throw IOException("Error in InputFileText::Open()", 0);
+		fileStream.rdbuf(&plainBuffer);
+	}
+	else {
+		compressedBuffer = new CompressedStreamBuf(filename, format);
+		fileStream.rdbuf(compressedBuffer);
+	}
 	opened = true;
 
-	// Read first line
-	std::string line;
-	if(!getline(fileStream,line)) {
+	// The file status is taken before the scan, a file growing meanwhile
+	// invalidates the sidecar.
+	uint64_t fileSize;
+	int64_t fileMTime;
+	bool statOk = TextIndex::stat(filename, fileSize, fileMTime);
+
+	if(sidecar && index.load(filename, separator)) {
+		nrows = index.size();
+		ncols = index.ncols;
+		return;
+	}
+
+	// Count rows
+	if(scan(0) == 0) {
 		close();
 		throw IOException("Error in InputFileText::Open()", 0);
-	} else
-		nrows++;
+	}
 
-	// Count cols
+	// Count cols from the first row
+	std::string line;
+	pointTo(0);
+	readLine(line);
 	int first = 0;
 	int last  = 0;
 	while(findField(line,first,last,last))
 		ncols++;
 
-	// Count rows
-	while(getline(fileStream,line))
-		if(line.size())
-			nrows++;
+	index.ncols = ncols;
+	inferTypes();
+
+	if(sidecar && statOk)
+		index.save(filename, separator, fileSize, fileMTime);
 }
 
 void InputFileText::close() {
     if(!opened)
 		throw IOException("Error in InputFileText::Close()", 0);
 
+	fileStream.rdbuf(0);
+	plainBuffer.close();
+	delete compressedBuffer;
+	compressedBuffer = 0;
+
 	nrows    = 0;
 	ncols    = 0;
+	index.clear();
 
 	opened = false;
 }
 
+long InputFileText::refresh() {
+	if(!isOpened())
+		throw IOException("Error in InputFileText::refresh() ", 0);
+
+	if(compressedBuffer)
+		return 0;
+
+	long before = nrows;
+
+	// The unterminated last line counted by open() is scanned again, it may
+	// have grown. The lines appended after are counted when terminated, the
+	// writer may be in the middle of one.
+	bool openLine = index.openLine;
+	if(openLine) {
+		index.pop_back();
+		nrows--;
+	}
+	scan(index.scanEnd, openLine);
+
+	return nrows > before ? nrows - before : 0;
+}
+
+long InputFileText::scan(uint64_t from, bool countOpenLine) {
+	const std::streamsize BLOCKSIZE = 1 << 16;
+	std::vector<char> block(BLOCKSIZE);
+
+	fileStream.clear();
+	fileStream.seekg(from, std::ios::beg);
+
+	long found = 0;
+	uint64_t lineStart = from;
+	uint64_t pos = from;
+	std::streamsize n;
+	while((n = fileStream.read(&block[0], BLOCKSIZE).gcount()) > 0) {
+		const char* p = &block[0];
+		const char* end = p + n;
+		const char* nl;
+		while((nl = (const char*) memchr(p, '\n', end - p)) != 0) {
+			uint64_t nlPos = pos + (nl - &block[0]);
+			// empty lines are not rows
+			if(nlPos > lineStart) {
+				index.push_back(lineStart);
+				found++;
+			}
+			lineStart = nlPos + 1;
+			p = nl + 1;
+		}
+		pos += n;
+	}
+
+	index.scanEnd = lineStart;
+	index.openLine = countOpenLine && pos > lineStart;
+	if(index.openLine) {
+		index.push_back(lineStart);
+		found++;
+	}
+
+	if(fileStream.bad())
+		throw IOException("Error in InputFileText::scan() ", 0);
+
+	fileStream.clear();
+	nrows += found;
+
+	return found;
+}
+
+void InputFileText::pointTo(long row) {
+	if(row < 0 || row >= nrows)
+		throw IOException("Error in InputFileText::pointTo() ", 0);
+
+	fileStream.clear();
+	fileStream.seekg(index[row], std::ios::beg);
+}
+
+fieldType InputFileText::getColType(int ncol) {
+	if(!isOpened() || ncol < 0 || ncol >= ncols)
+		throw IOException("Error in InputFileText::getColType() ", 0);
+
+	return index.types[ncol];
+}
+
+// true if the conversion used all the token, but trailing spaces.
+static bool converted(const char* token, const char* end) {
+	if(end == token)
+		return false;
+	while(isspace(*end))
+		end++;
+	return *end == '\0';
+}
+
+void InputFileText::inferTypes() {
+	const long SAMPLEROWS = 1000;
+
+	index.types.assign(ncols, INT64);
+
+	pointTo(0);
+	std::string line;
+	for(long row = 0; row < nrows && row < SAMPLEROWS && readLine(line); row++) {
+		int first = 0;
+		int last  = 0;
+		for(int col = 0; col < ncols && findField(line,first,last,last); col++) {
+			if(index.types[col] == STRING)
+				continue;
+
+			std::string token(line, first, last-first);
+			char* end;
+			strtoll(token.c_str(), &end, 10);
+			if(converted(token.c_str(), end))
+				continue;
+			strtod(token.c_str(), &end);
+			index.types[col] = converted(token.c_str(), end) ? DOUBLE : STRING;
+		}
+	}
+}
+
+bool InputFileText::readLine(std::string& line) {
+	while(getline(fileStream, line))
+		if(line.size())
+			return true;
+	return false;
+}
+
 bool InputFileText::findField(std::string& line, int& first, int& last, int pos) {
 
 	if(line.length()==0)
@@ -123,17 +282,12 @@ bool InputFileText::findField(std::string& line, int& first, int& last, int pos)
 }
 
 bool InputFileText::reopen() {
-	if(fileStream) {
-		if(!fileStream.good()) {
-			close();
-			fileStream.open(_filename.c_str());
-		}
-		else {
-			fileStream.seekg(0);
-		}
-		return true;
-	}
-	return false;
+	if(!opened)
+		return false;
+
+	fileStream.clear();
+	fileStream.seekg(0);
+	return fileStream.good();
 }
 
 bool InputFileText::test(int ncol, long frow, long& lrow) {
@@ -156,13 +310,12 @@ std::vector<uint8_t> InputFileText::readu8i(int ncol, long frow, long lrow) {
 	int buff_sz = lrow - frow + 1;
 	int buff_off = 0;
 
-	fileStream.clear();
-	fileStream.seekg(0, std::ios::beg);
+	pointTo(frow);
 
 	buff.resize(buff_sz);
 	for(int i = frow; i < lrow+1; i++) {
 		std::string line;
-		if(getline(fileStream, line)) {
+		if(readLine(line)) {
 			int first = 0;
 			int last  = 0;
 			int colCounter = 0;
@@ -211,6 +364,18 @@ std::vector<int64_t> InputFileText::read64i(int ncol, long frow, long lrow) {
 	return buff;
 }
 
+std::vector<uint32_t> InputFileText::read32u(int ncol, long frow, long lrow) {
+	std::vector<uint32_t> buff;
+	readData(buff, ncol, frow, lrow);
+	return buff;
+}
+
+std::vector<uint64_t> InputFileText::read64u(int ncol, long frow, long lrow) {
+	std::vector<uint64_t> buff;
+	readData(buff, ncol, frow, lrow);
+	return buff;
+}
+
 std::vector<float> InputFileText::read32f(int ncol, long frow, long lrow) {
 	std::vector<float> buff;
 	readData(buff, ncol, frow, lrow);
@@ -223,6 +388,231 @@ std::vector<double> InputFileText::read64f(int ncol, long frow, long lrow) {
 	return buff;
 }
 
+// Number conversions for the image parsing, true if all the token is used.
+// Integers written as floating point numbers are truncated, like in the FITS
+// image conversions. Values out of the range of T throw, as cfitsio does.
+static void throwOverflow() {
+	throw IOException("Error in InputFileText::readImage(): value out of the pixel type range", 0);
+}
+
+static inline bool convert(const char* token, const char* tokenEnd, float& value) {
+	char* end;
+	errno = 0;
+	value = strtof(token, &end);
+	if(end != tokenEnd)
+		return false;
+	if(errno == ERANGE && std::fabs(value) == HUGE_VALF)
+		throwOverflow();
+	return true;
+}
+
+static inline bool convert(const char* token, const char* tokenEnd, double& value) {
+	char* end;
+	errno = 0;
+	value = strtod(token, &end);
+	if(end != tokenEnd)
+		return false;
+	if(errno == ERANGE && std::fabs(value) == HUGE_VAL)
+		throwOverflow();
+	return true;
+}
+
+template<class T>
+static inline bool convert(const char* token, const char* tokenEnd, T& value) {
+	char* end;
+	errno = 0;
+	long long n = strtoll(token, &end, 10);
+	if(end == tokenEnd) {
+		if(errno == ERANGE || n < (long long) std::numeric_limits<T>::min() || n > (long long) std::numeric_limits<T>::max())
+			throwOverflow();
+		value = (T) n;
+		return true;
+	}
+
+	double d = strtod(token, &end);
+	if(end != tokenEnd || d != d)
+		return false;
+	if(d <= (double) std::numeric_limits<T>::min() - 1 || d >= (double) std::numeric_limits<T>::max() + 1)
+		throwOverflow();
+	value = (T) d;
+	return true;
+}
+
+template<class T>
+void InputFileText::parseImageRows(std::istream& stream, T* data, char* gaps, long frow, long lrow) {
+	// read all the block, up to the next block first row or the end of file
+	std::vector<char> block;
+	stream.clear();
+	stream.seekg(index[frow], std::ios::beg);
+	if(lrow+1 < nrows) {
+		block.resize(index[lrow+1] - index[frow]);
+		if(stream.read(&block[0], block.size()).gcount() != (std::streamsize) block.size())
+			throw IOException("Error in InputFileText::parseImageRows() ", 0);
+	}
+	else {
+		const std::streamsize BLOCKSIZE = 1 << 16;
+		std::streamsize n;
+		do {
+			size_t size = block.size();
+			block.resize(size + BLOCKSIZE);
+			n = stream.read(&block[size], BLOCKSIZE).gcount();
+			block.resize(size + n);
+		} while(n > 0);
+	}
+	if(stream.bad())
+		throw IOException("Error in InputFileText::parseImageRows() ", 0);
+
+	// a terminator stops the conversions at the end of the block
+	size_t size = block.size();
+	block.push_back('\n');
+	block.push_back('\0');
+
+	bool isSeparator[256] = { false };
+	for(size_t i=0; i<separator.size(); i++)
+		isSeparator[(unsigned char) separator[i]] = true;
+	isSeparator[(unsigned char) '\r'] = true;
+
+	const char* p = &block[0];
+	const char* end = p + size;
+	for(long row = frow; row <= lrow; row++) {
+		const char* lineEnd = (const char*) memchr(p, '\n', end + 1 - p);
+		T* out = data + row * ncols;
+		int col = 0;
+		while(true) {
+			while(p < lineEnd && isSeparator[(unsigned char) *p])
+				p++;
+			if(p == lineEnd)
+				break;
+			const char* tokenEnd = p;
+			while(tokenEnd < lineEnd && !isSeparator[(unsigned char) *tokenEnd])
+				tokenEnd++;
+			if(col == ncols)
+				throw IOException("Error in InputFileText::readImage(): too many columns", 0);
+			if(!convert(p, tokenEnd, out[col++]))
+				throw IOException("Error in InputFileText::readImage(): not a number", 0);
+			p = tokenEnd;
+		}
+		if(col != ncols)
+			throw IOException("Error in InputFileText::readImage(): too few columns", 0);
+
+		// empty lines (not indexed as rows) after this row
+		p = lineEnd + 1;
+		gaps[row] = p < end && *p == '\n';
+		while(p < end && *p == '\n')
+			p++;
+	}
+}
+
+template<class T>
+void InputFileText::readImageData(Image<T>& buff) {
+	if(!isOpened())
+		throw IOException("Error in InputFileText::readImage() ", 0);
+
+	// Each thread parses a block of rows with its own stream. The compressed
+	// stream can't be shared, so it is parsed by a single thread.
+	const long MINROWS = 64;
+	long nthreads = std::thread::hardware_concurrency();
+	if(nthreads < 1 || compressedBuffer)
+		nthreads = 1;
+	if(nthreads > nrows / MINROWS)
+		nthreads = nrows / MINROWS > 0 ? nrows / MINROWS : 1;
+
+	buff.data.resize((size_t) nrows * ncols);
+	std::vector<char> gaps(nrows);
+
+	std::vector<std::thread> threads;
+	std::vector<std::string> errors(nthreads);
+	long rowsPerThread = (nrows + nthreads - 1) / nthreads;
+	for(long t = 0; t < nthreads; t++) {
+		long frow = t * rowsPerThread;
+		long lrow = std::min(frow + rowsPerThread, nrows) - 1;
+		if(t == 0) {
+			// the first block goes to the calling thread, after the others start
+			continue;
+		}
+		threads.push_back(std::thread([this, &buff, &gaps, &errors, t, frow, lrow]() {
+			try {
+				std::ifstream stream(_filename.c_str(), std::ios::in | std::ios::binary);
+				if(!stream.is_open())
+					throw IOException("Error in InputFileText::readImage() ", 0);
+				parseImageRows(stream, &buff.data[0], &gaps[0], frow, lrow);
+			}
+			catch(std::exception& e) {
+				errors[t] = e.what();
+			}
+		}));
+	}
+
+	try {
+		parseImageRows(fileStream, &buff.data[0], &gaps[0], 0, std::min(rowsPerThread, nrows) - 1);
+	}
+	catch(std::exception& e) {
+		errors[0] = e.what();
+	}
+	for(size_t i=0; i<threads.size(); i++)
+		threads[i].join();
+	for(long t = 0; t < nthreads; t++)
+		if(!errors[t].empty())
+			throw IOException(errors[t], 0);
+
+	// Empty lines should split the rows in planes of the same size
+	long planeRows = nrows;
+	for(long row = 0; row < nrows-1; row++) {
+		if(gaps[row]) {
+			planeRows = row + 1;
+			break;
+		}
+	}
+	bool regular = nrows % planeRows == 0;
+	for(long row = 0; row < nrows-1 && regular; row++)
+		regular = gaps[row] == ((row + 1) % planeRows == 0);
+	if(!regular)
+		throw IOException("Error in InputFileText::readImage(): planes with different sizes", 0);
+
+	buff.sizes.resize(0);
+	buff.sizes.push_back(ncols);
+	buff.sizes.push_back(planeRows);
+	if(planeRows < nrows)
+		buff.sizes.push_back(nrows / planeRows);
+	buff.dim = buff.sizes.size();
+}
+
+Image<uint8_t> InputFileText::readImageu8i() {
+	Image<uint8_t> buff(memoryBudget);
+	readImageData(buff);
+	return buff;
+}
+
+Image<int16_t> InputFileText::readImage16i() {
+	Image<int16_t> buff(memoryBudget);
+	readImageData(buff);
+	return buff;
+}
+
+Image<int32_t> InputFileText::readImage32if() {
+	Image<int32_t> buff(memoryBudget);
+	readImageData(buff);
+	return buff;
+}
+
+Image<int64_t> InputFileText::readImage64i() {
+	Image<int64_t> buff(memoryBudget);
+	readImageData(buff);
+	return buff;
+}
+
+Image<float> InputFileText::readImage32f() {
+	Image<float> buff(memoryBudget);
+	readImageData(buff);
+	return buff;
+}
+
+Image<double> InputFileText::readImage64f() {
+	Image<double> buff(memoryBudget);
+	readImageData(buff);
+	return buff;
+}
+
 void InputFileText::_printState() {
 	if(fileStream) {
 		DEBUG("File: " << _filename << "(" << fileStream.rdstate() << ") ");
@@ -20,9 +20,13 @@
 #include <stdint.h>
 #include <vector>
 #include "InputFile.h"
+#include "CompressedStreamBuf.h"
+#include "TextIndex.h"
 
 namespace qlbase {
 
+/// Text file reader. Gzip (and zstd, when available) compressed files are
+/// detected from their magic number and decompressed on the fly.
 class InputFileText : public InputFile {
 
 	public:
@@ -31,6 +35,12 @@ class InputFileText : public InputFile {
 
 		virtual ~InputFileText();
 
+		/// Keep the row index in a sidecar file (filename.qlidx), written on
+		/// the first open and mapped on the next ones, skipping the file
+		/// scan. The sidecar is rebuilt when the file changes.
+		/// Call it before open().
+		void useSidecarIndex(bool enable = true) { sidecar = enable; }
+
 		virtual void open(const std::string &filename);
 		virtual void close();
 		virtual bool isOpened(){ return opened; }
@@ -47,11 +57,24 @@ class InputFileText : public InputFile {
 			throw IOException("getColNum not supported", 0);
 		}
 
+		/// Get the type of a column inferred from the first rows: INT64
+		/// for integers, DOUBLE for other numbers, STRING otherwise.
+		fieldType getColType(int ncol);
+
+		/// Count the lines appended to the file since the last scan. Only the
+		/// new bytes are read. An unterminated line is counted when its
+		/// terminator is appended, only the one found by open() is a row
+		/// before.
+		/// Compressed files don't grow, so they always return 0.
+		virtual long refresh();
+
 		virtual std::vector<uint8_t> readu8i(int ncol, long frow, long lrow);
 		virtual std::vector<int16_t> read16i(int ncol, long frow, long lrow);
 		virtual std::vector<uint16_t> read16u(int ncol, long frow, long lrow);
 		virtual std::vector<int32_t> read32i(int ncol, long frow, long lrow);
 		virtual std::vector<int64_t> read64i(int ncol, long frow, long lrow);
+		virtual std::vector<uint32_t> read32u(int ncol, long frow, long lrow);
+		virtual std::vector<uint64_t> read64u(int ncol, long frow, long lrow);
 		virtual std::vector<float> read32f(int ncol, long frow, long lrow);
 		virtual std::vector<double> read64f(int ncol, long frow, long lrow);
 
@@ -84,30 +107,49 @@ class InputFileText : public InputFile {
 			throw IOException("readString not supported", 0);
 		}
 
-		virtual Image<uint8_t> readImageu8i(){ throw IOException("readImageu8i not supported", 0); }
-		virtual Image<int16_t> readImage16i(){ throw IOException("readImageu8i not supported", 0); }
-		virtual Image<int32_t> readImage32if(){ throw IOException("readImageu8i not supported", 0); }
-		virtual Image<int64_t> readImage64i(){ throw IOException("readImageu8i not supported", 0); }
-		virtual Image<float> readImage32f(){ throw IOException("readImageu8i not supported", 0); }
-		virtual Image<double> readImage64f(){ throw IOException("readImageu8i not supported", 0); }
+		/// Read the whole file as an image: each row is an image row, with
+		/// the same layout of a FITS image (sizes[0] is the number of columns).
+		/// Empty lines placed every N rows split the image in N rows planes,
+		/// giving a 3-D image. Row blocks are parsed in parallel.
+		virtual Image<uint8_t> readImageu8i();
+		virtual Image<int16_t> readImage16i();
+		virtual Image<int32_t> readImage32if();
+		virtual Image<int64_t> readImage64i();
+		virtual Image<float> readImage32f();
+		virtual Image<double> readImage64f();
 
 	private:
 		bool opened;
 
-		std::ifstream fileStream;
+		std::filebuf plainBuffer;
+		CompressedStreamBuf* compressedBuffer;
+		std::istream fileStream;
 		std::string separator;
 
-		void pointTo(int line);
+		void pointTo(long row);
 		bool findField(std::string& line, int& first, int& last, int pos = 0);
 		bool reopen();
 		bool test(int ncol, long frow, long& lrow);
+		long scan(uint64_t from, bool countOpenLine = true);
+		bool readLine(std::string& line);
+		void inferTypes();
 
+		bool sidecar;
 		int ncols;
 		long nrows;
 
+		/// Offset of each row inside the file.
+		TextIndex index;
+
 		template<class T>
 		void readData(std::vector<T> &buff, int ncol, long frow, long lrow);
 
+		template<class T>
+		void readImageData(Image<T>& buff);
+
+		template<class T>
+		void parseImageRows(std::istream& stream, T* data, char* gaps, long frow, long lrow);
+
 		void _printState();
 };
 
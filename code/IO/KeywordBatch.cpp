@@ -0,0 +1,127 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <cstdio>
+#include <cmath>
+#include <cctype>
+#include "KeywordBatch.h"
+
+namespace qlbase {
+
+#define CARDSIZE 80
+#define NAMESIZE 8
+
+/// Values are right justified up to this column, like cfitsio.
+#define VALUEEND 30
+
+static std::string keywordName(const std::string& name) {
+	if(name.empty() || name.size() > NAMESIZE)
+		throw IOException("Error in KeywordBatch::add() invalid keyword name " + name, 0);
+
+	std::string upper(name);
+	for(unsigned int i=0; i<upper.size(); i++) {
+		upper[i] = toupper(upper[i]);
+		if(!isdigit(upper[i]) && (upper[i] < 'A' || upper[i] > 'Z') && upper[i] != '-' && upper[i] != '_')
+			throw IOException("Error in KeywordBatch::add() invalid keyword name " + name, 0);
+	}
+
+	upper.resize(NAMESIZE, ' ');
+	return upper;
+}
+
+void KeywordBatch::addValue(const std::string& name, const std::string& value, const std::string& comment) {
+	std::string card = keywordName(name) + "= ";
+
+	// numbers and logicals are right justified, strings start at column 11
+	if(value[0] != '\'' && card.size() + value.size() < VALUEEND)
+		card.append(VALUEEND - card.size() - value.size(), ' ');
+	card += value;
+
+	if(!comment.empty() && card.size() + 3 < CARDSIZE)
+		card += " / " + comment;
+	if(card.size() > CARDSIZE)
+		card.resize(CARDSIZE);
+
+	cards.push_back(card);
+}
+
+void KeywordBatch::addInt(const std::string& name, int64_t value, const std::string& comment) {
+	char buff[32];
+	snprintf(buff, sizeof(buff), "%lld", (long long) value);
+	addValue(name, buff, comment);
+}
+
+void KeywordBatch::addDouble(const std::string& name, double value, const std::string& comment) {
+	if(std::isnan(value) || std::isinf(value))
+		throw IOException("Error in KeywordBatch::addDouble() not a finite value for " + name, 0);
+
+	// always with a decimal point, like cfitsio
+	char buff[32];
+	snprintf(buff, sizeof(buff), "%.15G", value);
+	std::string str(buff);
+	if(str.find('.') == std::string::npos) {
+		size_t exp = str.find('E');
+		str.insert(exp == std::string::npos ? str.size() : exp, ".");
+	}
+	addValue(name, str, comment);
+}
+
+void KeywordBatch::addBool(const std::string& name, bool value, const std::string& comment) {
+	addValue(name, value ? "T" : "F", comment);
+}
+
+void KeywordBatch::addString(const std::string& name, const std::string& value, const std::string& comment) {
+	std::string quoted("'");
+	for(unsigned int i=0; i<value.size(); i++) {
+		quoted += value[i];
+		if(value[i] == '\'')
+			quoted += '\'';
+	}
+
+	// at least 8 characters between the quotes
+	if(quoted.size() < 9)
+		quoted.append(9 - quoted.size(), ' ');
+	quoted += '\'';
+
+	if(NAMESIZE + 2 + quoted.size() > CARDSIZE)
+		throw IOException("Error in KeywordBatch::addString() string too long for " + name, 0);
+
+	addValue(name, quoted, comment);
+}
+
+void KeywordBatch::addText(const char* name, const std::string& text) {
+	std::string card(name);
+	card.resize(NAMESIZE, ' ');
+	card += text;
+	if(card.size() > CARDSIZE)
+		card.resize(CARDSIZE);
+	cards.push_back(card);
+}
+
+void KeywordBatch::addComment(const std::string& text) {
+	addText("COMMENT", text);
+}
+
+void KeywordBatch::addHistory(const std::string& text) {
+	addText("HISTORY", text);
+}
+
+void KeywordBatch::addCard(const std::string& card) {
+	if(card.empty() || card.size() > CARDSIZE)
+		throw IOException("Error in KeywordBatch::addCard() invalid card " + card, 0);
+
+	cards.push_back(card);
+}
+
+}
@@ -0,0 +1,73 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_KEYWORDBATCH_H
+#define QL_IO_KEYWORDBATCH_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "File.h"
+
+namespace qlbase {
+
+/// A batch of typed FITS keywords, formatted as 80 characters header cards
+/// when added, to be written at once by OutputFileFITS::writeKeywords().
+/// Names are converted to upper case and must be standard FITS names (up to
+/// 8 characters among A-Z, 0-9, '-' and '_'). Comments are truncated to the
+/// card size. The add methods throw qlbase::IOException on invalid names or
+/// values.
+///
+/// \code
+/// KeywordBatch keywords;
+/// keywords.addString("TELESCOP", "AGILE", "telescope name");
+/// keywords.addDouble("TSTART", tstart, "start time");
+/// keywords.addInt("NEVENTS", nevents);
+/// file.writeKeywords(keywords);
+/// \endcode
+class KeywordBatch {
+
+public:
+
+	void addInt(const std::string& name, int64_t value, const std::string& comment = std::string());
+	void addDouble(const std::string& name, double value, const std::string& comment = std::string());
+	void addBool(const std::string& name, bool value, const std::string& comment = std::string());
+
+	/// Add a string, quotes are escaped. Strings must fit in one card.
+	void addString(const std::string& name, const std::string& value, const std::string& comment = std::string());
+
+	void addComment(const std::string& text);
+	void addHistory(const std::string& text);
+
+	/// Add an already formatted card (e.g. read from another header).
+	void addCard(const std::string& card);
+
+	/// Get the header cards.
+	const std::vector<std::string>& getCards() const { return cards; }
+
+	size_t size() const { return cards.size(); }
+
+	void clear() { cards.clear(); }
+
+private:
+
+	std::vector<std::string> cards;
+
+	void addValue(const std::string& name, const std::string& value, const std::string& comment);
+	void addText(const char* name, const std::string& text);
+};
+
+}
+
+#endif
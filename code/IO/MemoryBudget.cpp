@@ -0,0 +1,112 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <sstream>
+#include "MemoryBudget.h"
+#include "File.h"
+
+namespace qlbase {
+
+MemoryBudget::MemoryBudget(const std::string& name, int64_t limit, MemoryBudget* parent)
+	: name(name), limit(limit), used(0), peak(0), refused(0), parent(parent) {
+}
+
+MemoryBudget& MemoryBudget::getGlobal() {
+	// never destroyed, the images may be released by static destructors
+	static MemoryBudget* global = new MemoryBudget("global");
+	return *global;
+}
+
+int64_t MemoryBudget::getAvailable() const {
+	int64_t available = -1;
+	for(const MemoryBudget* b = this; b; b = b->parent) {
+		int64_t l = b->limit.load();
+		if(l <= 0)
+			continue;
+		int64_t left = l > b->used.load() ? l - b->used.load() : 0;
+		if(available < 0 || left < available)
+			available = left;
+	}
+	return available;
+}
+
+double MemoryBudget::getPressure() const {
+	double pressure = 0;
+	for(const MemoryBudget* b = this; b; b = b->parent) {
+		int64_t l = b->limit.load();
+		if(l > 0 && (double) b->used.load() / l > pressure)
+			pressure = (double) b->used.load() / l;
+	}
+	return pressure;
+}
+
+MemoryBudget::Stats MemoryBudget::getStats() const {
+	Stats stats;
+	stats.limit = limit.load();
+	stats.used = used.load();
+	stats.peak = peak.load();
+	stats.refused = refused.load();
+	return stats;
+}
+
+bool MemoryBudget::tryCharge(int64_t bytes) {
+	int64_t now = used.load();
+	do {
+		int64_t l = limit.load();
+		if(l > 0 && now + bytes > l) {
+			refused++;
+			return false;
+		}
+	} while(!used.compare_exchange_weak(now, now + bytes));
+
+	if(parent && !parent->tryCharge(bytes)) {
+		used -= bytes;
+		refused++;
+		return false;
+	}
+
+	now += bytes;
+	int64_t high = peak.load();
+	while(now > high && !peak.compare_exchange_weak(high, now))
+		;
+	return true;
+}
+
+void MemoryBudget::charge(int64_t bytes) {
+	if(tryCharge(bytes))
+		return;
+
+	std::stringstream msg;
+	msg << "Error in MemoryBudget::charge() " << bytes << " bytes exceed the memory budget";
+	const MemoryBudget* exceeded = findExceeded(bytes);
+	if(exceeded)
+		msg << " '" << exceeded->name << "' (" << exceeded->used.load() << " of " << exceeded->limit.load() << " bytes used)";
+	throw IOException(msg.str(), 0);
+}
+
+void MemoryBudget::release(int64_t bytes) {
+	for(MemoryBudget* b = this; b; b = b->parent)
+		b->used -= bytes;
+}
+
+const MemoryBudget* MemoryBudget::findExceeded(int64_t bytes) const {
+	for(const MemoryBudget* b = this; b; b = b->parent) {
+		int64_t l = b->limit.load();
+		if(l > 0 && b->used.load() + bytes > l)
+			return b;
+	}
+	return 0;
+}
+
+}
@@ -0,0 +1,112 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_MEMORYBUDGET_H
+#define QL_IO_MEMORYBUDGET_H
+
+#include <stdint.h>
+#include <string>
+#include <atomic>
+
+namespace qlbase {
+
+/// A limit on the bytes held by the library. Image pixels, the
+/// uncompressed copies of the compressed tables read, the buffers cached by
+/// a BufferPool and ChunkStore chunks are charged to a budget when
+/// allocated and released with them. The column vectors returned by the
+/// readers are not charged.
+/// A budget with a parent charges the parent too, so a reader budget is
+/// bounded by its own limit and by the global one.
+///
+/// \code
+/// MemoryBudget::getGlobal().setLimit(8LL << 30);
+/// MemoryBudget events("events.fits", 2LL << 30, &MemoryBudget::getGlobal());
+/// file.setMemoryBudget(&events);
+/// Image<float> image = file.readImage32f();   // charged to both budgets
+/// if(MemoryBudget::getGlobal().getPressure() > 0.9)
+///     ...
+/// \endcode
+///
+/// All methods are thread safe. A budget must outlive its charges.
+class MemoryBudget {
+
+public:
+
+	struct Stats {
+		/// 0 for no limit.
+		int64_t limit;
+		int64_t used;
+		int64_t peak;
+		/// Charges refused for exceeding the limit.
+		long refused;
+	};
+
+	/// \param[in] name The name in the error messages.
+	/// \param[in] limit The limit in bytes, 0 for no limit.
+	/// \param[in] parent The budget charged too, or 0.
+	MemoryBudget(const std::string& name, int64_t limit = 0, MemoryBudget* parent = 0);
+
+	/// Get the budget of the whole process, without limit until setLimit().
+	static MemoryBudget& getGlobal();
+
+	/// Set the limit, 0 for no limit. The bytes already charged are kept.
+	void setLimit(int64_t limit) { this->limit.store(limit); }
+
+	int64_t getLimit() const { return limit.load(); }
+
+	int64_t getUsed() const { return used.load(); }
+
+	/// Get the bytes that can be charged, the smallest along the parents.
+	/// -1 for no limit.
+	int64_t getAvailable() const;
+
+	/// Get the used fraction of the limit, the highest along the parents, 0
+	/// without limits. Can be above 1 after a setLimit() below the bytes
+	/// already charged.
+	double getPressure() const;
+
+	Stats getStats() const;
+
+	const std::string& getName() const { return name; }
+
+	/// Charge bytes if all the limits allow it.
+	/// \return false if a limit would be exceeded, nothing charged.
+	bool tryCharge(int64_t bytes);
+
+	/// Charge bytes, throwing qlbase::IOException naming the exceeded
+	/// budget if a limit would be exceeded.
+	void charge(int64_t bytes);
+
+	/// Give back charged bytes.
+	void release(int64_t bytes);
+
+private:
+
+	std::string name;
+	std::atomic<int64_t> limit;
+	std::atomic<int64_t> used;
+	std::atomic<int64_t> peak;
+	std::atomic<long> refused;
+	MemoryBudget* parent;
+
+	MemoryBudget(const MemoryBudget&);
+	MemoryBudget& operator=(const MemoryBudget&);
+
+	/// Get the first budget that cannot charge bytes.
+	const MemoryBudget* findExceeded(int64_t bytes) const;
+};
+
+}
+
+#endif
@@ -31,7 +31,11 @@ enum fieldType
 	INT64,
 	FLOAT,
 	DOUBLE,
-	STRING
+	STRING,
+	/// Bits (fits type X), vsize bits for each row. FITS files only.
+	BIT,
+	/// Logicals (fits type L), vsize for each row. FITS files only.
+	LOGICAL
 };
 
 struct field
@@ -42,6 +46,69 @@ struct field
 	std::string unit;
 };
 
+/// Get the bytes of a value of a field type in the memory buffers of the
+/// files: a char for the strings, the logicals and the bits (not packed).
+inline size_t getTypeSize(fieldType type) {
+	switch(type) {
+		case UNSIGNED_INT8:
+		case STRING:
+		case BIT:
+		case LOGICAL:
+			return 1;
+		case INT16:
+			return 2;
+		case INT32:
+		case FLOAT:
+			return 4;
+		default:
+			return 8;
+	}
+}
+
+/// Tell if the host stores the numbers big endian, as the FITS files.
+inline bool hostBigEndian() {
+	const uint16_t one = 1;
+	return *(const char*) &one == 0;
+}
+
+/// Copy n values converting them with a cast.
+template<class S, class T>
+inline void convertValues(S* dst, const T* src, size_t n) {
+	for(size_t i=0; i<n; i++)
+		dst[i] = (S) src[i];
+}
+
+/// Store n values into a buffer of a field type. Nothing is stored for the
+/// bits and the logicals.
+template<class T>
+void storeAs(fieldType type, char* dst, const T* src, size_t n) {
+	switch(type) {
+		case UNSIGNED_INT8: convertValues((uint8_t*) dst, src, n); break;
+		case INT16: convertValues((int16_t*) dst, src, n); break;
+		case INT32: convertValues((int32_t*) dst, src, n); break;
+		case INT64: convertValues((int64_t*) dst, src, n); break;
+		case FLOAT: convertValues((float*) dst, src, n); break;
+		case DOUBLE: convertValues((double*) dst, src, n); break;
+		case STRING: convertValues(dst, src, n); break;
+		default: break;
+	}
+}
+
+/// Load n values from a buffer of a field type, the inverse of storeAs().
+template<class T>
+void loadAs(fieldType type, T* dst, const char* src, size_t n) {
+	switch(type) {
+		case UNSIGNED_INT8: convertValues(dst, (const uint8_t*) src, n); break;
+		case INT16: convertValues(dst, (const int16_t*) src, n); break;
+		case INT32: convertValues(dst, (const int32_t*) src, n); break;
+		case INT64: convertValues(dst, (const int64_t*) src, n); break;
+		case FLOAT: convertValues(dst, (const float*) src, n); break;
+		case DOUBLE: convertValues(dst, (const double*) src, n); break;
+		case STRING: convertValues(dst, src, n); break;
+		default: break;
+	}
+}
+
 /// The interface for reading from a generic file divided into chunks.
 /// It specialize File adding functions for reading tables and images.
 class OutputFile : public File {
@@ -67,6 +134,24 @@ public:
 	virtual void write32fv(int ncol, std::vector< std::vector<float> >& buff, long frow, long lrow) = 0;
 	virtual void write64fv(int ncol, std::vector< std::vector<double> >& buff, long frow, long lrow) = 0;
 	virtual void writeString(int ncol, std::vector< std::vector<char> >& buff, long frow, long lrow) = 0;
+
+	/// Write a column from caller memory, without intermediate copies.
+	/// \param[in] buff lrow-frow+1 values.
+	virtual void writeu8i(int ncol, const uint8_t* buff, long frow, long lrow) = 0;
+	virtual void write16i(int ncol, const int16_t* buff, long frow, long lrow) = 0;
+	virtual void write32i(int ncol, const int32_t* buff, long frow, long lrow) = 0;
+	virtual void write64i(int ncol, const int64_t* buff, long frow, long lrow) = 0;
+	virtual void write32f(int ncol, const float* buff, long frow, long lrow) = 0;
+	virtual void write64f(int ncol, const double* buff, long frow, long lrow) = 0;
+
+	/// Write a vector column from a flat buffer, without intermediate copies.
+	/// \param[in] buff (lrow-frow+1)*vsize values, row after row.
+	virtual void writeu8iv(int ncol, const uint8_t* buff, long frow, long lrow, int vsize) = 0;
+	virtual void write16iv(int ncol, const int16_t* buff, long frow, long lrow, int vsize) = 0;
+	virtual void write32iv(int ncol, const int32_t* buff, long frow, long lrow, int vsize) = 0;
+	virtual void write64iv(int ncol, const int64_t* buff, long frow, long lrow, int vsize) = 0;
+	virtual void write32fv(int ncol, const float* buff, long frow, long lrow, int vsize) = 0;
+	virtual void write64fv(int ncol, const double* buff, long frow, long lrow, int vsize) = 0;
 };
 
 
@@ -16,19 +16,41 @@
 #include <iostream>
 #include <sstream>
 #include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <set>
 
 #include "Definitions.h"
 #include "OutputFileFITS.h"
+#include "BufferPool.h"
+#include "TileCompressor.h"
+#include "TableCompressor.h"
+#include "InputFileFITS.h"
 
 namespace qlbase {
 
 
 #define ERRMSGSIZ 81
 
-OutputFileFITS::OutputFileFITS() : opened(false), infptr(0) {
+/// The memory files grow by this many bytes at least (FITS blocks).
+#define MEMBLOCK (2880 * 360)
+
+OutputFileFITS::OutputFileFITS() : opened(false), memory(false), memBuffer(0), memSize(0), memDataSize(0), tracked(false), logicalRows(0), physicalRows(0), growthStep(0),
+	compression(UNCOMPRESSED), compressionThreads(0), compressionQuantize(0), tiledImage(false), tiledWritten(false), imageBitpix(0),
+	tableTileRows(0), tableThreads(0), tableCompressor(0), tableTiles(0), infptr(0) {
+
+	// like cfitsio: Rice for the integers, shuffled bytes for the wider types
+	columnCompression.resize(STRING+1, GZIP);
+	columnCompression[INT16] = RICE;
+	columnCompression[INT32] = RICE;
+	columnCompression[INT64] = GZIP2;
+	columnCompression[FLOAT] = GZIP2;
+	columnCompression[DOUBLE] = GZIP2;
 }
 
 OutputFileFITS::~OutputFileFITS() {
+	delete tableCompressor;
+	freeBuffer();
 }
 
 void OutputFileFITS::throwException(const char *msg, int status) {
@@ -49,6 +71,7 @@ void OutputFileFITS::throwException(const char *msg, int status) {
 void OutputFileFITS::create(const std::string &filename) {
 	int status = 0;
 
+	freeBuffer();
 	fits_create_file(&infptr, filename.c_str(), &status);
 
 	if (status)
@@ -61,16 +84,37 @@ void OutputFileFITS::open(const std::string &filename) {
 	File::open(filename);
 	int status = 0;
 
+	freeBuffer();
+
 	fits_open_table(&infptr, filename.c_str(), READWRITE, &status);
 
 	if (status)
 		throwException("Error in OutputFileFITS::open() ", status);
 
 	opened = true;
+
+	if(growthStep > 0)
+		track();
 }
 
 void OutputFileFITS::close() {
 	int status = 0;
+
+	// the file is closed even if the unused rows can't be removed
+	if(isOpened()) {
+		try {
+			trim();
+			_endTable();
+			if(memory)
+				_endMemory();
+		}
+		catch(IOException& e) {
+			fits_close_file(infptr, &status);
+			opened = false;
+			throw;
+		}
+	}
+
 	fits_close_file(infptr, &status);
 
 	if (status)
@@ -79,16 +123,94 @@ void OutputFileFITS::close() {
 	opened = false;
 }
 
+void OutputFileFITS::createMemory(size_t initialSize) {
+	int status = 0;
+
+	freeBuffer();
+	memSize = initialSize > 0 ? initialSize : MEMBLOCK;
+	memBuffer = malloc(memSize);
+	if(!memBuffer)
+		throw IOException("Error in OutputFileFITS::createMemory() out of memory", 0);
+
+	fits_create_memfile(&infptr, &memBuffer, &memSize, MEMBLOCK, realloc, &status);
+
+	if (status) {
+		freeBuffer();
+		throwException("Error in OutputFileFITS::createMemory() ", status);
+	}
+
+	memory = true;
+	opened = true;
+}
+
+const void* OutputFileFITS::getBuffer(size_t& size) {
+	if(!memory || isOpened())
+		throw IOException("Error in OutputFileFITS::getBuffer() no closed memory file", 0);
+
+	size = memDataSize;
+	return memBuffer;
+}
+
+void* OutputFileFITS::releaseBuffer(size_t& size) {
+	if(!memory || isOpened())
+		throw IOException("Error in OutputFileFITS::releaseBuffer() no closed memory file", 0);
+
+	size = memDataSize;
+	void* buffer = memBuffer;
+	memBuffer = 0;
+	memSize = 0;
+	memDataSize = 0;
+	memory = false;
+	return buffer;
+}
+
+void OutputFileFITS::freeBuffer() {
+	free(memBuffer);
+	memBuffer = 0;
+	memSize = 0;
+	memDataSize = 0;
+	memory = false;
+}
+
+// The FITS data ends with the last HDU (padding included), the buffer is
+// usually bigger.
+void OutputFileFITS::_endMemory() {
+	int status = 0;
+	int nhdus = 0;
+
+	memDataSize = 0;
+	fits_flush_file(infptr, &status);
+	fits_get_num_hdus(infptr, &nhdus, &status);
+	if(nhdus > 0 && !status) {
+		LONGLONG headstart, datastart, dataend;
+		fits_movabs_hdu(infptr, nhdus, 0, &status);
+		fits_get_hduaddrll(infptr, &headstart, &datastart, &dataend, &status);
+		memDataSize = dataend;
+	}
+
+	if (status)
+		throwException("Error in OutputFileFITS::close() ", status);
+}
+
 void OutputFileFITS::moveToHeader(int number) {
 	int status = 0;
 
 	if(!isOpened())
 		throwException("Error in OutputFileFITS::moveToHeader() ", status);
 
-	fits_movabs_hdu(infptr, number+1, 0, &status);
+	trim();
+	_endTable();
+	tiledImage = false;
+
+	int hdutype;
+	fits_movabs_hdu(infptr, number+1, &hdutype, &status);
 
 	if (status)
 		throwException("Error in OutputFileFITS::moveToHeader() ", status);
+
+	// only tables have rows to preallocate
+	if(growthStep > 0 && hdutype != IMAGE_HDU && !fits_is_compressed_image(infptr, &status))
+		track();
 }
 
 void OutputFileFITS::writeKeyword(const std::string& name, const std::string& value, const std::string& comment) {
@@ -119,45 +241,249 @@ void OutputFileFITS::writeKeyword(const std::string& name, const std::string& va
 		throwException("Error in OutputFileFITS::writeKeyword() ", status);
 }
 
-void OutputFileFITS::createTable(const std::string& name, const std::vector<field>& fields) {
+// The name of a card as found in the header: the 8 characters name, or all
+// the name of a HIERARCH card.
+static std::string cardName(const std::string& card) {
+	if(card.compare(0, 9, "HIERARCH ") == 0)
+	{
+		size_t equal = card.find('=');
+		size_t end = card.find_last_not_of(' ', equal == std::string::npos ? equal : equal - 1);
+		return card.substr(0, end + 1);
+	}
+
+	std::string name = card.substr(0, std::min<size_t>(8, card.size()));
+	name.resize(8, ' ');
+	return name;
+}
+
+void OutputFileFITS::writeKeywords(const KeywordBatch& keywords) {
 	int status = 0;
 
 	if(!isOpened())
-		throwException("Error in OutputFileFITS::createTable() ", status);
+		throwException("Error in OutputFileFITS::writeKeywords() ", status);
 
-	unsigned int nfields = fields.size();
+	const std::vector<std::string>& cards = keywords.getCards();
+	for(unsigned int i=0; i<cards.size(); i++)
+	{
+		if(fits_get_keyclass(const_cast<char*>(cards[i].c_str())) == TYP_STRUC_KEY)
+			throwException(("Error in OutputFileFITS::writeKeywords() protected " + cards[i].substr(0, 8)).c_str(), status);
+	}
 
-	char** ttypes = new char*[nfields*sizeof(char*)];
-	char** tform = new char*[nfields*sizeof(char*)];
-	char** tunit = new char*[nfields*sizeof(char*)];
+	// the names already in the header, read once
+	int nkeys;
+	char card[FLEN_CARD];
+	std::set<std::string> names;
+	fits_get_hdrspace(infptr, &nkeys, 0, &status);
+	for(int i=0; i<nkeys && !status; i++)
+	{
+		fits_read_record(infptr, i+1, card, &status);
+		names.insert(cardName(card));
+	}
 
-	for(unsigned int i=0; i<nfields; i++)
+	// reserve the space of the new keywords before the data, if not
+	// written yet
+	fits_set_hdrsize(infptr, cards.size(), &status);
+
+	for(unsigned int i=0; i<cards.size() && !status; )
+	{
+		// a long string value goes on with the CONTINUE cards after it
+		unsigned int next = i + 1;
+		while(next < cards.size() && cards[next].compare(0, 8, "CONTINUE") == 0)
+			next++;
+
+		std::string name = cardName(cards[i]);
+		bool commentary = name == "COMMENT " || name == "HISTORY " || name == "        " || name == "CONTINUE";
+		if(commentary || !names.count(name))
+		{
+			for(unsigned int j=i; j<next; j++)
+				fits_write_record(infptr, cards[j].c_str(), &status);
+			names.insert(name);
+		}
+		else
+		{
+			// cfitsio deletes the CONTINUE cards of the old value, the new
+			// ones are inserted after the updated card
+			size_t end = name.find_last_not_of(' ');
+			std::string key = name.substr(0, end+1);
+			fits_update_card(infptr, key.c_str(), cards[i].c_str(), &status);
+			if(next > i + 1)
+			{
+				int keypos;
+				fits_read_card(infptr, key.c_str(), card, &status);
+				fits_get_hdrpos(infptr, &nkeys, &keypos, &status);
+				for(unsigned int j=i+1; j<next; j++)
+					fits_insert_record(infptr, keypos++, cards[j].c_str(), &status);
+			}
+		}
+		i = next;
+	}
+
+	if (status)
+		throwException("Error in OutputFileFITS::writeKeywords() ", status);
+}
+
+void OutputFileFITS::copyKeywords(InputFileFITS& file, bool copyNames) {
+	KeywordBatch keywords;
+
+	bool skipped = false;
+	for(int i=0; i<file.getKeywordNum(); i++)
 	{
-		ttypes[i] = new char[10];
-		std::string type = fields[i].name.c_str();
-		std::memcpy(ttypes[i], type.c_str(), 10);
+		std::string card = file.getKeyword(i);
+		int keyclass = fits_get_keyclass(const_cast<char*>(card.c_str()));
 
-		tform[i] = new char[10];
-		std::string form(_getFieldTypeString(fields[i].type, fields[i].vsize));
-		std::memcpy(tform[i], form.c_str(), 10);
+		// the CONTINUE cards go with their keyword
+		if(keyclass == TYP_CONT_KEY)
+		{
+			if(!skipped)
+				keywords.addCard(card);
+			continue;
+		}
 
-		tunit[i] = new char[10];
-		std::string unit = fields[i].unit.c_str();
-		std::memcpy(tunit[i], unit.c_str(), 10);
+		std::string name = cardName(card);
+		skipped = keyclass < TYP_HDUID_KEY || keyclass == TYP_CKSUM_KEY
+		          || (!copyNames && (name == "EXTNAME " || name == "EXTVER  " || name == "EXTLEVEL"));
+		if(!skipped)
+			keywords.addCard(card);
 	}
 
-	fits_create_tbl(infptr, BINARY_TBL, 0, nfields, ttypes, tform, tunit, name.c_str(), &status);
+	writeKeywords(keywords);
+}
+
+long OutputFileFITS::getNRows() {
+	int status = 0;
+	if(!isOpened())
+		throwException("Error in OutputFileFITS::getNRows() ", status);
+
+	if(tableCompressor)
+		return tableCompressor->getNRows();
+
+	if(tracked)
+		return logicalRows;
+
+	long nrows;
+	fits_get_num_rows(infptr, &nrows, &status);
+
+	if (status)
+		throwException("Error in OutputFileFITS::getNRows() ", status);
+
+	return nrows;
+}
+
+long OutputFileFITS::getOptimalRows() {
+	int status = 0;
+	if(!isOpened())
+		throwException("Error in OutputFileFITS::getOptimalRows() ", status);
+
+	long nrows;
+	fits_get_rowsize(infptr, &nrows, &status);
+
+	if (status)
+		throwException("Error in OutputFileFITS::getOptimalRows() ", status);
+
+	return nrows;
+}
+
+void OutputFileFITS::reserveRows(long nrows) {
+	int status = 0;
+	if(!isOpened())
+		throwException("Error in OutputFileFITS::reserveRows() ", status);
+
+	// the rows of compressed tables are the tiles
+	if(tableCompressor)
+		return;
+
+	track();
+	if(nrows <= physicalRows)
+		return;
+
+	fits_insert_rows(infptr, physicalRows, nrows - physicalRows, &status);
+	if (status)
+		throwException("Error in OutputFileFITS::reserveRows() ", status);
+
+	physicalRows = nrows;
+}
+
+void OutputFileFITS::setGrowthStep(long step) {
+	int status = 0;
+	if(!isOpened())
+		throwException("Error in OutputFileFITS::setGrowthStep() ", status);
+
+	growthStep = step;
+	if(growthStep > 0)
+		track();
+}
+
+void OutputFileFITS::track() {
+	if(tracked || tableCompressor)
+		return;
+
+	int status = 0;
+	long nrows;
+	fits_get_num_rows(infptr, &nrows, &status);
+	if (status)
+		throwException("Error in OutputFileFITS::track() ", status);
+
+	tracked = true;
+	logicalRows = nrows;
+	physicalRows = nrows;
+}
+
+void OutputFileFITS::grow(long lrow) {
+	if(!tracked)
+		return;
+
+	if(lrow >= physicalRows && growthStep > 0)
+		reserveRows(std::max(lrow + 1, physicalRows + growthStep));
+
+	physicalRows = std::max(physicalRows, lrow + 1);
+	logicalRows = std::max(logicalRows, lrow + 1);
+}
+
+void OutputFileFITS::trim() {
+	if(!tracked)
+		return;
+
+	tracked = false;
+	if(physicalRows <= logicalRows)
+		return;
+
+	int status = 0;
+	fits_delete_rows(infptr, logicalRows + 1, physicalRows - logicalRows, &status);
+	if (status)
+		throwException("Error in OutputFileFITS::trim() ", status);
+}
+
+void OutputFileFITS::createTable(const std::string& name, const std::vector<field>& fields) {
+	int status = 0;
+
+	if(!isOpened())
+		throwException("Error in OutputFileFITS::createTable() ", status);
+
+	trim();
+	_endTable();
+	tiledImage = false;
+
+	if(tableTileRows > 0)
+	{
+		_createCompressedTable(name, fields);
+		return;
+	}
+
+	unsigned int nfields = fields.size();
+
+	Arena arena;
+	char** ttypes = arena.allocate<char*>(nfields);
+	char** tform = arena.allocate<char*>(nfields);
+	char** tunit = arena.allocate<char*>(nfields);
 
 	for(unsigned int i=0; i<nfields; i++)
 	{
-		delete ttypes[i];
-		delete tform[i];
-		delete tunit[i];
+		ttypes[i] = arena.copy(fields[i].name);
+		tform[i] = arena.copy(_getFieldTypeString(fields[i].type, fields[i].vsize));
+		tunit[i] = arena.copy(fields[i].unit);
 	}
 
-	delete ttypes;
-	delete tform;
-	delete tunit;
+	fits_create_tbl(infptr, BINARY_TBL, 0, nfields, ttypes, tform, tunit, name.c_str(), &status);
 
 	if (status)
 		throwException("Error in OutputFileFITS::createTable() ", status);
@@ -172,37 +498,426 @@ void OutputFileFITS::createTable(const std::string& name, const std::vector<fiel
 	}
 	if (status)
 		throwException("Error in OutputFileFITS::createTable() ", status);
+
+	if(growthStep > 0)
+		track();
+}
+
+
+void OutputFileFITS::setImageCompression(Compression type, const std::vector<long>& tiles, int nthreads, float quantizeLevel) {
+	compression = type;
+	compressionTiles = tiles;
+	compressionThreads = nthreads;
+	compressionQuantize = quantizeLevel;
+}
+
+void OutputFileFITS::createImage(fieldType type, const std::vector<int64_t>& sizes) {
+	int status = 0;
+
+	if(!isOpened())
+		throwException("Error in OutputFileFITS::createImage() ", status);
+
+	trim();
+	_endTable();
+	tiledImage = false;
+
+	int bitpix = _getImageBitpix(type);
+	if(sizes.empty())
+		throwException("Error in OutputFileFITS::createImage() no sizes ", status);
+	std::vector<long> naxes(sizes.begin(), sizes.end());
+
+	TileCompressor::Algorithm algorithm = _getAlgorithm(compression);
+	if(compression != UNCOMPRESSED && compression != HCOMPRESS && TileCompressor::supports(algorithm, bitpix))
+	{
+		_createTiledImage(bitpix, naxes);
+		return;
+	}
+
+	// HCOMPRESS and floating point RICE images are compressed by cfitsio
+	if(compression != UNCOMPRESSED)
+	{
+		if(compression == RICE && bitpix == LONGLONG_IMG)
+			throw IOException("Error in OutputFileFITS::createImage() RICE does not support 64 bit images", 0);
+
+		// cfitsio would quantize them by default, a lossy compression
+		if(bitpix < 0 && compressionQuantize == 0)
+			throw IOException("Error in OutputFileFITS::createImage() floating point images are compressed losslessly only with GZIP, "
+			                  "set a quantization level for RICE or HCOMPRESS", 0);
+
+		fits_set_compression_type(infptr, compression == RICE ? RICE_1 : HCOMPRESS_1, &status);
+		if(!compressionTiles.empty())
+			fits_set_tile_dim(infptr, compressionTiles.size(), &compressionTiles[0], &status);
+		if(bitpix < 0)
+			fits_set_quantize_level(infptr, compressionQuantize, &status);
+	}
+
+	fits_create_img(infptr, bitpix, naxes.size(), &naxes[0], &status);
+
+	// the next HDUs are uncompressed
+	if(compression != UNCOMPRESSED)
+	{
+		int resetStatus = 0;
+		fits_set_compression_type(infptr, NOCOMPRESS, &resetStatus);
+	}
+
+	if (status)
+		throwException("Error in OutputFileFITS::createImage() ", status);
+}
+
+// A tile-compressed image is a binary table with a compressed tile in each
+// row, cfitsio reads it back as an image.
+void OutputFileFITS::_createTiledImage(int bitpix, const std::vector<long>& sizes) {
+	int status = 0;
+
+	TileCompressor compressor(bitpix, sizes, compressionTiles, _getAlgorithm(compression), compressionThreads);
+
+	char* ttype[] = { (char*) "COMPRESSED_DATA" };
+	char* tform[] = { (char*) "1PB" };
+	fits_create_tbl(infptr, BINARY_TBL, 0, 1, ttype, tform, 0, "COMPRESSED_IMAGE", &status);
+
+	int ztrue = 1;
+	int naxis = sizes.size();
+	fits_write_key(infptr, TLOGICAL, "ZIMAGE", &ztrue, "extension contains compressed image", &status);
+	fits_write_key(infptr, TINT, "ZBITPIX", &bitpix, "data type of original image", &status);
+	fits_write_key(infptr, TINT, "ZNAXIS", &naxis, "dimension of original image", &status);
+	for(int d=0; d<naxis; d++)
+	{
+		std::ostringstream key;
+		key << "ZNAXIS" << d+1;
+		long size = sizes[d];
+		fits_write_key(infptr, TLONG, key.str().c_str(), &size, "length of original image axis", &status);
+	}
+	for(int d=0; d<naxis; d++)
+	{
+		std::ostringstream key;
+		key << "ZTILE" << d+1;
+		long size = compressor.getTileSizes()[d];
+		fits_write_key(infptr, TLONG, key.str().c_str(), &size, "size of tiles to be compressed", &status);
+	}
+
+	if(compression == RICE)
+	{
+		int blocksize = 32;
+		int bytepix = bitpix / 8;
+		fits_write_key(infptr, TSTRING, "ZCMPTYPE", (void*) _getAlgorithmName(compression), "compression algorithm", &status);
+		fits_write_key(infptr, TSTRING, "ZNAME1", (void*) "BLOCKSIZE", "compression block size", &status);
+		fits_write_key(infptr, TINT, "ZVAL1", &blocksize, "pixels per block", &status);
+		fits_write_key(infptr, TSTRING, "ZNAME2", (void*) "BYTEPIX", "bytes per pixel (1, 2, 4, or 8)", &status);
+		fits_write_key(infptr, TINT, "ZVAL2", &bytepix, "bytes per pixel (1, 2, 4, or 8)", &status);
+	}
+	else
+	{
+		fits_write_key(infptr, TSTRING, "ZCMPTYPE", (void*) _getAlgorithmName(compression), "compression algorithm", &status);
+		if(bitpix < 0)
+			fits_write_key(infptr, TSTRING, "ZQUANTIZ", (void*) "NONE", "lossless compression without quantization", &status);
+	}
+
+	if (status)
+		throwException("Error in OutputFileFITS::createImage() ", status);
+
+	tiledImage = true;
+	tiledWritten = false;
+	imageBitpix = bitpix;
+	imageSizes = sizes;
+	imageTiles = compressor.getTileSizes();
+}
+
+void OutputFileFITS::_writeTiledImage(const void* pixels) {
+	int status = 0;
+
+	TileCompressor compressor(imageBitpix, imageSizes, imageTiles, _getAlgorithm(compression), compressionThreads);
+
+	std::vector< std::vector<unsigned char> > tiles;
+	compressor.compress(pixels, tiles);
+
+	for(unsigned long tile=0; tile<tiles.size(); tile++)
+		fits_write_col(infptr, TBYTE, 1, tile+1, 1, tiles[tile].size(), &tiles[tile][0], &status);
+
+	if (status)
+		throwException("Error in OutputFileFITS::writeImage() ", status);
+
+	tiledWritten = true;
+}
+
+void OutputFileFITS::writeImageu8i(const Image<uint8_t>& image)
+{
+	_writeImage(image, TBYTE, 0);
+}
+
+void OutputFileFITS::writeImage16i(const Image<int16_t>& image)
+{
+	_writeImage(image, TSHORT, 0);
+}
+
+void OutputFileFITS::writeImage32i(const Image<int32_t>& image)
+{
+	_writeImage(image, TINT, 0);
+}
+
+void OutputFileFITS::writeImage64i(const Image<int64_t>& image)
+{
+	_writeImage(image, TLONG, 0);
+}
+
+void OutputFileFITS::writeImage32f(const Image<float>& image)
+{
+	_writeImage(image, TFLOAT, 0);
 }
 
+void OutputFileFITS::writeImage64f(const Image<double>& image)
+{
+	_writeImage(image, TDOUBLE, 0);
+}
+
+void OutputFileFITS::writeImageu8i(const Image<uint8_t>& image, const std::vector<int64_t>& first)
+{
+	_writeImage(image, TBYTE, &first);
+}
+
+void OutputFileFITS::writeImage16i(const Image<int16_t>& image, const std::vector<int64_t>& first)
+{
+	_writeImage(image, TSHORT, &first);
+}
+
+void OutputFileFITS::writeImage32i(const Image<int32_t>& image, const std::vector<int64_t>& first)
+{
+	_writeImage(image, TINT, &first);
+}
+
+void OutputFileFITS::writeImage64i(const Image<int64_t>& image, const std::vector<int64_t>& first)
+{
+	_writeImage(image, TLONG, &first);
+}
+
+void OutputFileFITS::writeImage32f(const Image<float>& image, const std::vector<int64_t>& first)
+{
+	_writeImage(image, TFLOAT, &first);
+}
+
+void OutputFileFITS::writeImage64f(const Image<double>& image, const std::vector<int64_t>& first)
+{
+	_writeImage(image, TDOUBLE, &first);
+}
+
+template<class S, class V>
+static char* convertPixels(const V& in, Arena& arena) {
+	S* pixels = arena.allocate<S>(in.size());
+	for(size_t i=0; i<in.size(); i++)
+		pixels[i] = (S) in[i];
+	return (char*) pixels;
+}
+
+template<class T>
+void OutputFileFITS::_writeImage(const Image<T>& image, int type, const std::vector<int64_t>* first) {
+	int status = 0;
+	if(!isOpened())
+		throwException("Error in OutputFileFITS::_writeImage() ", status);
+
+	long nelem = 1;
+	for(unsigned int d=0; d<image.sizes.size(); d++)
+		nelem *= image.sizes[d];
+	if(image.sizes.empty() || nelem != (long) image.data.size())
+		throwException("Error in OutputFileFITS::_writeImage() wrong image sizes ", status);
+
+	if(tiledImage)
+	{
+		if(first || tiledWritten || std::vector<long>(image.sizes.begin(), image.sizes.end()) != imageSizes)
+			throwException("Error in OutputFileFITS::_writeImage() compressed images are written whole once ", status);
+
+		// the tiles are compressed from the pixels in the image type
+		Arena arena(0);
+		char* converted;
+		switch(imageBitpix)
+		{
+			case BYTE_IMG: converted = convertPixels<uint8_t>(image.data, arena); break;
+			case SHORT_IMG: converted = convertPixels<int16_t>(image.data, arena); break;
+			case LONG_IMG: converted = convertPixels<int32_t>(image.data, arena); break;
+			case LONGLONG_IMG: converted = convertPixels<int64_t>(image.data, arena); break;
+			case FLOAT_IMG: converted = convertPixels<float>(image.data, arena); break;
+			default: converted = convertPixels<double>(image.data, arena); break;
+		}
+		_writeTiledImage(converted);
+		return;
+	}
+
+	std::vector<long> fpixel(image.sizes.size(), 1);
+	if(!first)
+	{
+		fits_write_pix(infptr, type, &fpixel[0], nelem, const_cast<T*>(&image.data[0]), &status);
+	}
+	else
+	{
+		if(first->size() != image.sizes.size())
+			throwException("Error in OutputFileFITS::_writeImage() wrong region ", status);
+
+		std::vector<long> lpixel(image.sizes.size());
+		for(unsigned int d=0; d<image.sizes.size(); d++)
+		{
+			fpixel[d] = (*first)[d] + 1;
+			lpixel[d] = (*first)[d] + image.sizes[d];
+		}
+		fits_write_subset(infptr, type, &fpixel[0], &lpixel[0], const_cast<T*>(&image.data[0]), &status);
+	}
+
+	if(status)
+		throwException("Error in OutputFileFITS::_writeImage() ", status);
+}
+
+void OutputFileFITS::setTableCompression(long tileRows, int nthreads) {
+	tableTileRows = tileRows;
+	tableThreads = nthreads;
+}
+
+void OutputFileFITS::setColumnCompression(fieldType type, Compression algorithm) {
+	if(type > STRING || algorithm == UNCOMPRESSED || algorithm == HCOMPRESS || (algorithm == RICE && (type == INT64 || type == FLOAT || type == DOUBLE || type == STRING)))
+		throw IOException("Error in OutputFileFITS::setColumnCompression() ", 0);
+
+	columnCompression[type] = algorithm;
+}
+
+// The compressed table has a row for each tile and a variable length
+// column of compressed bytes for each column of the table.
+void OutputFileFITS::_createCompressedTable(const std::string& name, const std::vector<field>& fields) {
+	int status = 0;
+
+	unsigned int nfields = fields.size();
+	std::vector<TileCompressor::Algorithm> algorithms(nfields);
+	std::vector<std::string> forms(nfields);
+	std::vector<char*> ttypes(nfields), tform(nfields), tunit(nfields);
+	std::string cellForm("1PB");
+	for(unsigned int i=0; i<nfields; i++)
+	{
+		if(fields[i].vsize < 1 || fields[i].type > STRING)
+			throw IOException("Error in OutputFileFITS::createTable() variable length, bit and logical columns of compressed tables are not supported", 0);
+		algorithms[i] = _getAlgorithm(columnCompression[fields[i].type]);
+		forms[i] = _getFieldTypeString(fields[i].type, fields[i].vsize);
+		ttypes[i] = const_cast<char*>(fields[i].name.c_str());
+		tform[i] = const_cast<char*>(cellForm.c_str());
+		tunit[i] = const_cast<char*>(fields[i].unit.c_str());
+	}
+
+	TableCompressor* compressor = new TableCompressor(fields, algorithms, tableTileRows, tableThreads);
+	long rowWidth = compressor->getRowWidth();
+
+	fits_create_tbl(infptr, BINARY_TBL, 0, nfields, &ttypes[0], &tform[0], &tunit[0], name.c_str(), &status);
+
+	int ztrue = 1;
+	long zero = 0;
+	fits_write_key(infptr, TLOGICAL, "ZTABLE", &ztrue, "extension contains compressed binary table", &status);
+	fits_write_key(infptr, TLONG, "ZTILELEN", &tableTileRows, "number of rows in each tile", &status);
+	fits_write_key(infptr, TLONG, "ZNAXIS1", &rowWidth, "length of uncompressed rows", &status);
+	fits_write_key(infptr, TLONG, "ZNAXIS2", &zero, "number of uncompressed rows", &status);
+	fits_write_key(infptr, TLONG, "ZPCOUNT", &zero, "size of heap in uncompressed table", &status);
+	for(unsigned int i=0; i<nfields; i++)
+	{
+		std::ostringstream zform, zctyp;
+		zform << "ZFORM" << i+1;
+		zctyp << "ZCTYP" << i+1;
+		fits_write_key(infptr, TSTRING, zform.str().c_str(), (void*) forms[i].c_str(), "original format of column", &status);
+		fits_write_key(infptr, TSTRING, zctyp.str().c_str(), (void*) _getAlgorithmName(columnCompression[fields[i].type]),
+		               "compression algorithm for column", &status);
+	}
+
+	if (status)
+	{
+		delete compressor;
+		throwException("Error in OutputFileFITS::createTable() ", status);
+	}
+
+	tableCompressor = compressor;
+	tableTiles = 0;
+}
+
+void OutputFileFITS::_flushTable(bool last) {
+	int status = 0;
+
+	// a batch of tiles to compress in parallel
+	if(!last && tableCompressor->getCompleteTiles() < tableCompressor->getThreads())
+		return;
+
+	std::vector< std::vector< std::vector<unsigned char> > > tiles;
+	tableCompressor->compress(last, tiles);
+
+	for(unsigned long tile=0; tile<tiles.size(); tile++)
+	{
+		for(unsigned int col=0; col<tiles[tile].size(); col++)
+		{
+			std::vector<unsigned char>& cell = tiles[tile][col];
+			fits_write_col(infptr, TBYTE, col+1, tableTiles+1, 1, cell.size(), &cell[0], &status);
+		}
+		tableTiles++;
+	}
+
+	if (status)
+		throwException("Error in OutputFileFITS::_flushTable() ", status);
+}
+
+void OutputFileFITS::_endTable() {
+	if(!tableCompressor)
+		return;
+
+	// the table is ended even when the last tiles can't be written
+	int status = 0;
+	try
+	{
+		_flushTable(true);
+		long nrows = tableCompressor->getNRows();
+		fits_update_key(infptr, TLONG, "ZNAXIS2", &nrows, 0, &status);
+	}
+	catch(IOException& e)
+	{
+		delete tableCompressor;
+		tableCompressor = 0;
+		throw;
+	}
+
+	delete tableCompressor;
+	tableCompressor = 0;
+
+	if (status)
+		throwException("Error in OutputFileFITS::_endTable() ", status);
+}
 
 void OutputFileFITS::writeu8i(int ncol, std::vector<uint8_t>& buff, long frow, long lrow)
 {
-	_write(ncol, buff, TBYTE, frow, lrow);
+	if((long) buff.size() < lrow - frow + 1)
+		throwException("Error in OutputFileFITS::writeu8i() ", 0);
+	_write(ncol, buff.data(), TBYTE, frow, lrow);
 }
 
 void OutputFileFITS::write16i(int ncol, std::vector<int16_t>& buff, long frow, long lrow)
 {
-	_write(ncol, buff, TSHORT, frow, lrow);
+	if((long) buff.size() < lrow - frow + 1)
+		throwException("Error in OutputFileFITS::write16i() ", 0);
+	_write(ncol, buff.data(), TSHORT, frow, lrow);
 }
 
 void OutputFileFITS::write32i(int ncol, std::vector<int32_t>& buff, long frow, long lrow)
 {
-	_write(ncol, buff, TINT, frow, lrow);
+	if((long) buff.size() < lrow - frow + 1)
+		throwException("Error in OutputFileFITS::write32i() ", 0);
+	_write(ncol, buff.data(), TINT, frow, lrow);
 }
 
 void OutputFileFITS::write64i(int ncol, std::vector<int64_t>& buff, long frow, long lrow)
 {
-	_write(ncol, buff, TLONG, frow, lrow);
+	if((long) buff.size() < lrow - frow + 1)
+		throwException("Error in OutputFileFITS::write64i() ", 0);
+	_write(ncol, buff.data(), TLONG, frow, lrow);
 }
 
 void OutputFileFITS::write32f(int ncol, std::vector<float>& buff, long frow, long lrow)
 {
-	_write(ncol, buff, TFLOAT, frow, lrow);
+	if((long) buff.size() < lrow - frow + 1)
+		throwException("Error in OutputFileFITS::write32f() ", 0);
+	_write(ncol, buff.data(), TFLOAT, frow, lrow);
 }
 
 void OutputFileFITS::write64f(int ncol, std::vector<double>& buff, long frow, long lrow)
 {
-	_write(ncol, buff, TDOUBLE, frow, lrow);
+	if((long) buff.size() < lrow - frow + 1)
+		throwException("Error in OutputFileFITS::write64f() ", 0);
+	_write(ncol, buff.data(), TDOUBLE, frow, lrow);
 }
 
 void OutputFileFITS::writeu8iv(int ncol, std::vector< std::vector<uint8_t> >& buff, long frow, long lrow)
@@ -242,67 +957,463 @@ void OutputFileFITS::writeString(int ncol, std::vector< std::vector<char> >& buf
 		throwException("Error in OutputFileFITS::writeString() ", status);
 
 	long nelem = lrow - frow + 1;
-	unsigned int size = buff[0].size();
-	char** buffptrs = new char*[nelem];
-	for(unsigned int row=frow; row<lrow+1; row++)
+	if(nelem < 1 || (long) buff.size() < nelem)
+		throwException("Error in OutputFileFITS::writeString() ", status);
+
+	// cfitsio needs null terminated strings, as wide as the longest row
+	size_t width = 0;
+	for(long row=0; row<nelem; row++)
+		width = std::max(width, buff[row].size());
+	StringColumn column(nelem, width);
+	for(long row=0; row<nelem; row++)
+		column.set(row, buff[row].data(), buff[row].size());
+
+	writeString(ncol, column, frow);
+}
+
+void OutputFileFITS::writeString(int ncol, const StringColumn& column, long frow)
+{
+	int status = 0;
+	if(!isOpened() || column.size() < 1)
+		throwException("Error in OutputFileFITS::writeString() ", status);
+
+	long lrow = frow + column.size() - 1;
+	if(tableCompressor)
 	{
-		buffptrs[row] = new char[buff[0].size()];
-		memcpy(buffptrs[row], &buff[row][0], buff[0].size());
+		tableCompressor->writeString(ncol, column, frow);
+		_flushTable(false);
+		return;
 	}
 
-	fits_write_col(infptr, TSTRING, ncol+1, frow+1, 1, nelem, buffptrs, &status);
+	// the rows are already null terminated
+	Arena arena(0);
+	char** rows = arena.allocate<char*>(column.size());
+	for(long row=0; row<column.size(); row++)
+		rows[row] = const_cast<char*>(column[row]);
 
-	for(unsigned int row=frow; row<lrow+1; row++)
-		delete buffptrs[row];
-	delete[] buffptrs;
+	grow(lrow);
+	fits_write_col(infptr, TSTRING, ncol+1, frow+1, 1, column.size(), rows, &status);
 
 	if(status)
 		throwException("Error in OutputFileFITS::writeString() ", status);
 }
 
+// cfitsio writes packed bytes to a bit column when given TBYTE
+void OutputFileFITS::writeBits(int ncol, const BitColumn& column, long frow)
+{
+	int status = 0;
+	if(!isOpened() || column.size() < 1 || column.getBits() < 1)
+		throwException("Error in OutputFileFITS::writeBits() ", status);
+	if(tableCompressor)
+		throw IOException("Error in OutputFileFITS::writeBits() bit columns of compressed tables are not supported", 0);
+
+	long nbytes = (column.getBits() + 7) / 8;
+	bitBytes.resize(column.size() * nbytes);
+	column.getFitsBytes((uint8_t*) &bitBytes[0]);
+
+	grow(frow + column.size() - 1);
+	fits_write_col(infptr, TBYTE, ncol+1, frow+1, 1, bitBytes.size(), &bitBytes[0], &status);
+
+	if(status)
+		throwException("Error in OutputFileFITS::writeBits() ", status);
+}
+
+void OutputFileFITS::writeLogical(int ncol, const BitColumn& column, long frow)
+{
+	int status = 0;
+	if(!isOpened() || column.size() < 1 || column.getBits() < 1)
+		throwException("Error in OutputFileFITS::writeLogical() ", status);
+	if(tableCompressor)
+		throw IOException("Error in OutputFileFITS::writeLogical() logical columns of compressed tables are not supported", 0);
+
+	bitBytes.resize(column.size() * column.getBits());
+	column.getLogicals(&bitBytes[0]);
+
+	grow(frow + column.size() - 1);
+	fits_write_col(infptr, TLOGICAL, ncol+1, frow+1, 1, bitBytes.size(), &bitBytes[0], &status);
+
+	if(status)
+		throwException("Error in OutputFileFITS::writeLogical() ", status);
+}
+
+void OutputFileFITS::writeVar(int ncol, const VarColumn<uint8_t>& column, long frow)
+{
+	_writeVar(ncol, column, TBYTE, frow);
+}
+
+void OutputFileFITS::writeVar(int ncol, const VarColumn<int16_t>& column, long frow)
+{
+	_writeVar(ncol, column, TSHORT, frow);
+}
+
+void OutputFileFITS::writeVar(int ncol, const VarColumn<int32_t>& column, long frow)
+{
+	_writeVar(ncol, column, TINT, frow);
+}
+
+void OutputFileFITS::writeVar(int ncol, const VarColumn<int64_t>& column, long frow)
+{
+	_writeVar(ncol, column, TLONGLONG, frow);
+}
+
+void OutputFileFITS::writeVar(int ncol, const VarColumn<float>& column, long frow)
+{
+	_writeVar(ncol, column, TFLOAT, frow);
+}
+
+void OutputFileFITS::writeVar(int ncol, const VarColumn<double>& column, long frow)
+{
+	_writeVar(ncol, column, TDOUBLE, frow);
+}
+
+// cfitsio appends the values of each row to the heap and writes its
+// descriptor, empty rows only get the descriptor.
 template<class T>
-void OutputFileFITS::_write(int ncol, std::vector<T>& buff, int type, long frow, long lrow) {
+void OutputFileFITS::_writeVar(int ncol, const VarColumn<T>& column, int type, long frow)
+{
+	int status = 0;
+	if(!isOpened() || column.size() < 1)
+		throwException("Error in OutputFileFITS::writeVar() ", status);
+	if(tableCompressor)
+		throw IOException("Error in OutputFileFITS::writeVar() variable length columns of compressed tables are not supported", 0);
+
+	grow(frow + column.size() - 1);
+	for(long row=0; row<column.size() && !status; row++)
+	{
+		long n = column.length(row);
+		if(n > 0)
+			fits_write_col(infptr, type, ncol+1, frow+row+1, 1, n, const_cast<T*>(column[row]), &status);
+		else
+			fits_write_descript(infptr, ncol+1, frow+row+1, 0, 0, &status);
+	}
+
+	if(status)
+		throwException("Error in OutputFileFITS::writeVar() ", status);
+}
+
+void OutputFileFITS::writeu8i(int ncol, const uint8_t* buff, long frow, long lrow)
+{
+	_write(ncol, buff, TBYTE, frow, lrow);
+}
+
+void OutputFileFITS::write16i(int ncol, const int16_t* buff, long frow, long lrow)
+{
+	_write(ncol, buff, TSHORT, frow, lrow);
+}
+
+void OutputFileFITS::write32i(int ncol, const int32_t* buff, long frow, long lrow)
+{
+	_write(ncol, buff, TINT, frow, lrow);
+}
+
+void OutputFileFITS::write64i(int ncol, const int64_t* buff, long frow, long lrow)
+{
+	_write(ncol, buff, TLONG, frow, lrow);
+}
+
+void OutputFileFITS::write32f(int ncol, const float* buff, long frow, long lrow)
+{
+	_write(ncol, buff, TFLOAT, frow, lrow);
+}
+
+void OutputFileFITS::write64f(int ncol, const double* buff, long frow, long lrow)
+{
+	_write(ncol, buff, TDOUBLE, frow, lrow);
+}
+
+void OutputFileFITS::write32u(int ncol, const uint32_t* buff, long frow, long lrow)
+{
+	_write(ncol, buff, TUINT, frow, lrow);
+}
+
+void OutputFileFITS::write64u(int ncol, const uint64_t* buff, long frow, long lrow)
+{
+	_write(ncol, buff, TULONGLONG, frow, lrow);
+}
+
+void OutputFileFITS::writeu8iv(int ncol, const uint8_t* buff, long frow, long lrow, int vsize)
+{
+	_write(ncol, buff, TBYTE, frow, lrow, vsize);
+}
+
+void OutputFileFITS::write16iv(int ncol, const int16_t* buff, long frow, long lrow, int vsize)
+{
+	_write(ncol, buff, TSHORT, frow, lrow, vsize);
+}
+
+void OutputFileFITS::write32iv(int ncol, const int32_t* buff, long frow, long lrow, int vsize)
+{
+	_write(ncol, buff, TINT, frow, lrow, vsize);
+}
+
+void OutputFileFITS::write64iv(int ncol, const int64_t* buff, long frow, long lrow, int vsize)
+{
+	_write(ncol, buff, TLONG, frow, lrow, vsize);
+}
+
+void OutputFileFITS::write32fv(int ncol, const float* buff, long frow, long lrow, int vsize)
+{
+	_write(ncol, buff, TFLOAT, frow, lrow, vsize);
+}
+
+void OutputFileFITS::write64fv(int ncol, const double* buff, long frow, long lrow, int vsize)
+{
+	_write(ncol, buff, TDOUBLE, frow, lrow, vsize);
+}
+
+// cfitsio converts the values through its own work buffer, the caller
+// memory is only read.
+template<class T>
+void OutputFileFITS::_write(int ncol, const T* buff, int type, long frow, long lrow, int vsize) {
 	int status = 0;
 	if(!isOpened())
 		throwException("Error in OutputFileFITS::_write() ", status);
 
-	long nelem = lrow - frow + 1;
+	long nelem = (lrow - frow + 1) * vsize;
+
+	if(tableCompressor)
+	{
+		tableCompressor->write(ncol, buff, frow, nelem);
+		_flushTable(false);
+		return;
+	}
 
-	std::vector<T> buffptr = buff;
-	fits_write_col(infptr, type, ncol+1, frow+1, 1, nelem, &buffptr[0], &status);
+	grow(lrow);
+	fits_write_col(infptr, type, ncol+1, frow+1, 1, nelem, const_cast<T*>(buff), &status);
 
 	if(status)
 		throwException("Error in OutputFileFITS::_write() ", status);
 }
 
+// for the inline write()
+template void OutputFileFITS::_write(int ncol, const uint8_t* buff, int type, long frow, long lrow, int vsize);
+template void OutputFileFITS::_write(int ncol, const int16_t* buff, int type, long frow, long lrow, int vsize);
+template void OutputFileFITS::_write(int ncol, const uint16_t* buff, int type, long frow, long lrow, int vsize);
+template void OutputFileFITS::_write(int ncol, const uint32_t* buff, int type, long frow, long lrow, int vsize);
+template void OutputFileFITS::_write(int ncol, const uint64_t* buff, int type, long frow, long lrow, int vsize);
+template void OutputFileFITS::_write(int ncol, const int32_t* buff, int type, long frow, long lrow, int vsize);
+template void OutputFileFITS::_write(int ncol, const int64_t* buff, int type, long frow, long lrow, int vsize);
+template void OutputFileFITS::_write(int ncol, const float* buff, int type, long frow, long lrow, int vsize);
+template void OutputFileFITS::_write(int ncol, const double* buff, int type, long frow, long lrow, int vsize);
+
 template<class T>
 void OutputFileFITS::_writev(int ncol, std::vector< std::vector<T> >& buff, int type, long frow, long lrow) {
 	int status = 0;
 	if(!isOpened())
 		throwException("Error in OutputFileFITS::_writev() ", status);
 
+	// the rows aren't contiguous, pack them once for a single cfitsio call.
+	// Use the flat overloads to avoid the copy.
 	long nelem = lrow - frow + 1;
+	if(nelem < 1 || (long) buff.size() < nelem || buff[0].empty())
+		throwException("Error in OutputFileFITS::_writev() ", status);
+
 	unsigned int size = buff[0].size();
-	T* buffptr = new T[nelem*size];
-	for(unsigned int row=frow; row<lrow+1; row++)
+	std::vector<T> flat(nelem*size);
+	for(long row=0; row<nelem; row++)
 	{
-		for(unsigned int i=0; i<size; i++)
+		if(buff[row].size() != size)
+			throw IOException("Error in OutputFileFITS::_writev() rows of different sizes", 0);
+		std::copy(buff[row].begin(), buff[row].end(), flat.begin() + row*size);
+	}
+
+	_write(ncol, &flat[0], type, frow, lrow, size);
+}
+
+// Write the values, then mark the undefined ones a run at a time.
+template<class T>
+void OutputFileFITS::_writeNull(int ncol, const T* buff, int type, long frow, long lrow, int vsize, const ValidityBitmap& validity) {
+	int status = 0;
+	long nelem = (lrow - frow + 1) * vsize;
+	if(!isOpened() || tableCompressor || nelem < 1 || validity.size() < nelem)
+		throwException("Error in OutputFileFITS::_writeNull() ", status);
+
+	_write(ncol, buff, type, frow, lrow, vsize);
+
+	const uint64_t* words = validity.data();
+	long i = 0;
+	while(i < nelem && !status)
+	{
+		if(i % 64 == 0 && words[i / 64] == ~(uint64_t) 0)
+		{
+			i += 64;
+			continue;
+		}
+		if(validity.isValid(i))
 		{
-			buffptr[row*size + i] = buff[row][i];
+			i++;
+			continue;
 		}
+
+		long first = i;
+		while(i < nelem && !validity.isValid(i))
+			i++;
+		fits_write_col_null(infptr, ncol+1, frow+1 + first / vsize, first % vsize + 1, i - first, &status);
+	}
+
+	if(status)
+		throwException("Error in OutputFileFITS::_writeNull() ", status);
+}
+
+void OutputFileFITS::setNullValue(int ncol, int64_t value) {
+	int status = 0;
+	if(!isOpened() || tableCompressor)
+		throwException("Error in OutputFileFITS::setNullValue() ", status);
+
+	char keyname[FLEN_KEYWORD];
+	LONGLONG tnull = value;
+	fits_make_keyn("TNULL", ncol+1, keyname, &status);
+	fits_update_key(infptr, TLONGLONG, keyname, &tnull, "undefined value", &status);
+	fits_set_btblnull(infptr, ncol+1, value, &status);
+
+	if(status)
+		throwException("Error in OutputFileFITS::setNullValue() ", status);
+}
+
+void OutputFileFITS::setScaling(int ncol, double scale, double zero) {
+	int status = 0;
+	if(!isOpened() || tableCompressor || scale == 0.)
+		throwException("Error in OutputFileFITS::setScaling() ", status);
+
+	char keyname[FLEN_KEYWORD];
+	fits_make_keyn("TSCAL", ncol+1, keyname, &status);
+	fits_update_key(infptr, TDOUBLE, keyname, &scale, "data scale", &status);
+	fits_make_keyn("TZERO", ncol+1, keyname, &status);
+	if(zero == 9223372036854775808.)
+	{
+		// 2^63 has no exact 15 digits form
+		ULONGLONG offset = 9223372036854775808ULL;
+		fits_update_key(infptr, TULONGLONG, keyname, &offset, "data offset", &status);
 	}
+	else
+		fits_update_key(infptr, TDOUBLE, keyname, &zero, "data offset", &status);
+	fits_set_tscale(infptr, ncol+1, scale, zero, &status);
 
-	fits_write_col(infptr, type, ncol+1, frow+1, 1, nelem*size, buffptr, &status);
+	if(status)
+		throwException("Error in OutputFileFITS::setScaling() ", status);
+}
 
-	delete[] buffptr;
+void OutputFileFITS::setUnsigned(int ncol) {
+	int status = 0;
+	if(!isOpened())
+		throwException("Error in OutputFileFITS::setUnsigned() ", status);
 
+	int typecode;
+	long repeat, width;
+	fits_get_coltype(infptr, ncol+1, &typecode, &repeat, &width, &status);
 	if(status)
-		throwException("Error in OutputFileFITS::_writev() ", status);
+		throwException("Error in OutputFileFITS::setUnsigned() ", status);
+
+	switch(typecode)
+	{
+		case TSHORT:
+			setScaling(ncol, 1., 32768.);
+			break;
+		case TLONG:
+			setScaling(ncol, 1., 2147483648.);
+			break;
+		case TLONGLONG:
+			setScaling(ncol, 1., 9223372036854775808.);
+			break;
+		default:
+			throw IOException("Error in OutputFileFITS::setUnsigned() not a 16, 32 or 64 bit integer column", 0);
+	}
+}
+
+void OutputFileFITS::_getScaling(int ncol, double& scale, double& zero) {
+	int status = 0;
+	if(!isOpened())
+		throwException("Error in OutputFileFITS::writeRaw() ", status);
+
+	char keyname[FLEN_KEYWORD];
+	scale = 1.;
+	zero = 0.;
+	fits_make_keyn("TSCAL", ncol+1, keyname, &status);
+	fits_read_key(infptr, TDOUBLE, keyname, &scale, NULL, &status);
+	if(status == KEY_NO_EXIST)
+		status = 0;
+	fits_make_keyn("TZERO", ncol+1, keyname, &status);
+	fits_read_key(infptr, TDOUBLE, keyname, &zero, NULL, &status);
+	if(status == KEY_NO_EXIST)
+		status = 0;
+
+	if(status)
+		throwException("Error in OutputFileFITS::writeRaw() ", status);
+}
+
+void OutputFileFITS::_setTableScale(int ncol, double scale, double zero) {
+	int status = 0;
+	fits_set_tscale(infptr, ncol+1, scale, zero, &status);
+	if(status)
+		throwException("Error in OutputFileFITS::writeRaw() ", status);
+}
+
+void OutputFileFITS::writeu8i(int ncol, const uint8_t* buff, long frow, long lrow, const ValidityBitmap& validity)
+{
+	_writeNull(ncol, buff, TBYTE, frow, lrow, 1, validity);
+}
+
+void OutputFileFITS::write16i(int ncol, const int16_t* buff, long frow, long lrow, const ValidityBitmap& validity)
+{
+	_writeNull(ncol, buff, TSHORT, frow, lrow, 1, validity);
+}
+
+void OutputFileFITS::write32i(int ncol, const int32_t* buff, long frow, long lrow, const ValidityBitmap& validity)
+{
+	_writeNull(ncol, buff, TINT, frow, lrow, 1, validity);
+}
+
+void OutputFileFITS::write64i(int ncol, const int64_t* buff, long frow, long lrow, const ValidityBitmap& validity)
+{
+	_writeNull(ncol, buff, TLONG, frow, lrow, 1, validity);
+}
+
+void OutputFileFITS::write32f(int ncol, const float* buff, long frow, long lrow, const ValidityBitmap& validity)
+{
+	_writeNull(ncol, buff, TFLOAT, frow, lrow, 1, validity);
+}
+
+void OutputFileFITS::write64f(int ncol, const double* buff, long frow, long lrow, const ValidityBitmap& validity)
+{
+	_writeNull(ncol, buff, TDOUBLE, frow, lrow, 1, validity);
+}
+
+void OutputFileFITS::writeu8iv(int ncol, const uint8_t* buff, long frow, long lrow, int vsize, const ValidityBitmap& validity)
+{
+	_writeNull(ncol, buff, TBYTE, frow, lrow, vsize, validity);
+}
+
+void OutputFileFITS::write16iv(int ncol, const int16_t* buff, long frow, long lrow, int vsize, const ValidityBitmap& validity)
+{
+	_writeNull(ncol, buff, TSHORT, frow, lrow, vsize, validity);
+}
+
+void OutputFileFITS::write32iv(int ncol, const int32_t* buff, long frow, long lrow, int vsize, const ValidityBitmap& validity)
+{
+	_writeNull(ncol, buff, TINT, frow, lrow, vsize, validity);
+}
+
+void OutputFileFITS::write64iv(int ncol, const int64_t* buff, long frow, long lrow, int vsize, const ValidityBitmap& validity)
+{
+	_writeNull(ncol, buff, TLONG, frow, lrow, vsize, validity);
+}
+
+void OutputFileFITS::write32fv(int ncol, const float* buff, long frow, long lrow, int vsize, const ValidityBitmap& validity)
+{
+	_writeNull(ncol, buff, TFLOAT, frow, lrow, vsize, validity);
+}
+
+void OutputFileFITS::write64fv(int ncol, const double* buff, long frow, long lrow, int vsize, const ValidityBitmap& validity)
+{
+	_writeNull(ncol, buff, TDOUBLE, frow, lrow, vsize, validity);
 }
 
 const std::string OutputFileFITS::_getFieldTypeString(fieldType type, int vsize) {
 	std::ostringstream ist;
-	ist << vsize;
+	if(vsize == 0)
+		ist << "1P";
+	else
+		ist << vsize;
 	switch(type)
 	{
 		case UNSIGNED_INT8:
@@ -326,10 +1437,62 @@ const std::string OutputFileFITS::_getFieldTypeString(fieldType type, int vsize)
 		case STRING:
 			ist << "A";
 			break;
+		case BIT:
+			ist << "X";
+			break;
+		case LOGICAL:
+			ist << "L";
+			break;
 		default:
 			throw IOException("Error in OutputFileFITS::_getFieldTypeString() ", 0);
 	}
 	return ist.str();
 }
 
+int OutputFileFITS::_getImageBitpix(fieldType type) {
+	switch(type)
+	{
+		case UNSIGNED_INT8:
+			return BYTE_IMG;
+		case INT16:
+			return SHORT_IMG;
+		case INT32:
+			return LONG_IMG;
+		case INT64:
+			return LONGLONG_IMG;
+		case FLOAT:
+			return FLOAT_IMG;
+		case DOUBLE:
+			return DOUBLE_IMG;
+		default:
+			throw IOException("Error in OutputFileFITS::_getImageBitpix() ", 0);
+	}
+}
+
+TileCompressor::Algorithm OutputFileFITS::_getAlgorithm(Compression type) {
+	switch(type)
+	{
+		case RICE:
+			return TileCompressor::RICE;
+		case GZIP2:
+			return TileCompressor::GZIP2;
+		default:
+			return TileCompressor::GZIP;
+	}
+}
+
+const char* OutputFileFITS::_getAlgorithmName(Compression type) {
+	switch(type)
+	{
+		case RICE:
+			return "RICE_1";
+		case GZIP2:
+			return "GZIP_2";
+		case HCOMPRESS:
+			return "HCOMPRESS_1";
+		default:
+			return "GZIP_1";
+	}
+}
+
 }
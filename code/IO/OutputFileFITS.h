@@ -21,15 +21,34 @@
 #include <string>
 #include <stdexcept>
 #include "OutputFile.h"
+#include "InputFile.h"
+#include "TileCompressor.h"
+#include "KeywordBatch.h"
+#include "StringColumn.h"
+#include "ValidityBitmap.h"
+#include "VarColumn.h"
+#include "BitColumn.h"
+#include "FitsTraits.h"
 
 namespace qlbase {
 
-
+class TableCompressor;
+class InputFileFITS;
 
 class OutputFileFITS : public OutputFile {
 
 public:
 
+	/// Image tile compression.
+	enum Compression {
+		UNCOMPRESSED = 0,
+		RICE,
+		GZIP,
+		HCOMPRESS,
+		/// GZIP of the shuffled bytes, the most significant ones first.
+		GZIP2
+	};
+
 	OutputFileFITS();
 	virtual ~OutputFileFITS();
 
@@ -38,10 +57,111 @@ public:
 	virtual void close();
 	virtual bool isOpened() { return opened; }
 
+	/// Create a FITS file in memory, grown with realloc(). After close()
+	/// the FITS bytes can be borrowed with getBuffer() or taken with
+	/// releaseBuffer(), without copies.
+	/// \param[in] initialSize The initial buffer size, 0 for the default.
+	void createMemory(size_t initialSize = 0);
+
+	/// Get the FITS bytes of the closed memory file. The buffer belongs to
+	/// this object until the next create, open or its destruction.
+	/// \param[out] size The FITS size (a multiple of 2880).
+	const void* getBuffer(size_t& size);
+
+	/// Take the FITS bytes of the closed memory file, to be released with
+	/// free(). The buffer can be bigger than size.
+	void* releaseBuffer(size_t& size);
+
 	virtual void moveToHeader(int number);
 
 	void writeKeyword(const std::string& name, const std::string& value, const std::string& comment);
 
+	/// Write a batch of keywords in the current header, checking the
+	/// protected keywords before writing any of them. Existing keywords are
+	/// updated, the new ones appended after reserving their space. The
+	/// CONTINUE cards of a long string value must follow its card.
+	void writeKeywords(const KeywordBatch& keywords);
+
+	/// Copy the keywords of the current header of a file, except the ones
+	/// describing the data (structure, compression, scaling, columns and
+	/// checksums).
+	/// \param[in] copyNames Copy EXTNAME, EXTVER and EXTLEVEL too.
+	void copyKeywords(InputFileFITS& file, bool copyNames = false);
+
+	/// Get the number of rows of the current table. With preallocated rows
+	/// this is the number of rows written.
+	long getNRows();
+
+	/// Preallocate the current table up to nrows rows, avoiding the
+	/// small table extensions of cfitsio when appending. The rows not
+	/// written are removed by close() or when moving to another header.
+	void reserveRows(long nrows);
+
+	/// Preallocate at least step rows each time a write goes past the
+	/// preallocated rows, on the current and next tables. 0 disables it.
+	void setGrowthStep(long step);
+
+	/// Get the number of rows cfitsio keeps in its buffers (fits_get_rowsize),
+	/// the optimal number of rows for each write.
+	long getOptimalRows();
+
+	/// Set the tile compression of the next images. RICE (integer images
+	/// up to 32 bit) and GZIP tiles are compressed in parallel and written
+	/// in order, the other images are compressed by cfitsio. RICE does not
+	/// support 64 bit integer images.
+	///
+	/// GZIP compresses floating point images losslessly. RICE and HCOMPRESS
+	/// compress them only after quantizing the pixels (cfitsio
+	/// fits_set_quantize_level), a lossy compression that must be asked
+	/// with a quantization level.
+	/// \param[in] type The compression algorithm.
+	/// \param[in] tiles The tile sizes, the image rows if empty.
+	/// \param[in] nthreads Compression threads, 0 for the available cores.
+	/// \param[in] quantizeLevel The quantization level of the floating point
+	/// images compressed with RICE or HCOMPRESS (e.g. 16 for a step of 1/16
+	/// of the noise, negative for an absolute step), 0 to refuse them.
+	void setImageCompression(Compression type, const std::vector<long>& tiles = std::vector<long>(), int nthreads = 0, float quantizeLevel = 0);
+
+	/// Create an image HDU.
+	/// \param[in] type The pixel type (not STRING).
+	/// \param[in] sizes The image sizes, the first axis is the fastest.
+	void createImage(fieldType type, const std::vector<int64_t>& sizes);
+
+	/// Write the whole image, the values are converted to the image type.
+	/// Images compressed in parallel are written at once.
+	void writeImageu8i(const Image<uint8_t>& image);
+	void writeImage16i(const Image<int16_t>& image);
+	void writeImage32i(const Image<int32_t>& image);
+	void writeImage64i(const Image<int64_t>& image);
+	void writeImage32f(const Image<float>& image);
+	void writeImage64f(const Image<double>& image);
+
+	/// Write a region of the image.
+	/// \param[in] image The region, with its sizes.
+	/// \param[in] first The first pixel of the region (starting from 0).
+	void writeImageu8i(const Image<uint8_t>& image, const std::vector<int64_t>& first);
+	void writeImage16i(const Image<int16_t>& image, const std::vector<int64_t>& first);
+	void writeImage32i(const Image<int32_t>& image, const std::vector<int64_t>& first);
+	void writeImage64i(const Image<int64_t>& image, const std::vector<int64_t>& first);
+	void writeImage32f(const Image<float>& image, const std::vector<int64_t>& first);
+	void writeImage64f(const Image<double>& image, const std::vector<int64_t>& first);
+
+	/// Write the next tables tile-compressed (the FITS tiled table
+	/// convention). The rows are buffered and each tile of tileRows rows is
+	/// compressed column by column, the tiles in parallel. Rows can be written
+	/// only after the last compressed tile. 0 disables the compression.
+	/// \param[in] tileRows Rows of each tile.
+	/// \param[in] nthreads Compression threads, 0 for the available cores.
+	void setTableCompression(long tileRows, int nthreads = 0);
+
+	/// Set the compression algorithm of the columns of a type in the
+	/// compressed tables. RICE is for integers up to 32 bit. By default
+	/// 16 and 32 bit integers are RICE, the wider numbers GZIP2 and the
+	/// bytes and strings GZIP.
+	void setColumnCompression(fieldType type, Compression algorithm);
+
+	/// Create a table. Fields with vsize 0 are variable length array
+	/// columns (fits type 1P), written with writeVar().
 	virtual void createTable(const std::string& name, const std::vector<field>& fields);
 	virtual void writeu8i(int ncol, std::vector<uint8_t>& buff, long frow, long lrow);
 	virtual void write16i(int ncol, std::vector<int16_t>& buff, long frow, long lrow);
@@ -58,20 +178,191 @@ public:
 	virtual void write64fv(int ncol, std::vector< std::vector<double> >& buff, long frow, long lrow);
 	virtual void writeString(int ncol, std::vector< std::vector<char> >& buff, long frow, long lrow);
 
+	/// Write a column of strings from one buffer, without allocations for
+	/// each row. The strings are truncated to the column width.
+	/// \param[in] column The rows from frow.
+	void writeString(int ncol, const StringColumn& column, long frow);
+
+	/// Write a column of bits (a BIT field) from packed words.
+	/// \param[in] column The rows from frow, as many bits as the column.
+	void writeBits(int ncol, const BitColumn& column, long frow);
+
+	/// Write a column of logicals (a LOGICAL field) from packed words.
+	void writeLogical(int ncol, const BitColumn& column, long frow);
+
+	/// Write the rows of a variable length array column (a field with
+	/// vsize 0, created as fits type 1P), the values go to the heap.
+	/// \param[in] column The rows from frow.
+	void writeVar(int ncol, const VarColumn<uint8_t>& column, long frow);
+	void writeVar(int ncol, const VarColumn<int16_t>& column, long frow);
+	void writeVar(int ncol, const VarColumn<int32_t>& column, long frow);
+	void writeVar(int ncol, const VarColumn<int64_t>& column, long frow);
+	void writeVar(int ncol, const VarColumn<float>& column, long frow);
+	void writeVar(int ncol, const VarColumn<double>& column, long frow);
+
+	/// Write from caller memory, passed straight to cfitsio.
+	virtual void writeu8i(int ncol, const uint8_t* buff, long frow, long lrow);
+	virtual void write16i(int ncol, const int16_t* buff, long frow, long lrow);
+	virtual void write32i(int ncol, const int32_t* buff, long frow, long lrow);
+	virtual void write64i(int ncol, const int64_t* buff, long frow, long lrow);
+	virtual void write32f(int ncol, const float* buff, long frow, long lrow);
+	virtual void write64f(int ncol, const double* buff, long frow, long lrow);
+
+	/// Write unsigned integers to a column set with setUnsigned().
+	void write32u(int ncol, const uint32_t* buff, long frow, long lrow);
+	void write64u(int ncol, const uint64_t* buff, long frow, long lrow);
+
+	virtual void writeu8iv(int ncol, const uint8_t* buff, long frow, long lrow, int vsize);
+	virtual void write16iv(int ncol, const int16_t* buff, long frow, long lrow, int vsize);
+	virtual void write32iv(int ncol, const int32_t* buff, long frow, long lrow, int vsize);
+	virtual void write64iv(int ncol, const int64_t* buff, long frow, long lrow, int vsize);
+	virtual void write32fv(int ncol, const float* buff, long frow, long lrow, int vsize);
+	virtual void write64fv(int ncol, const double* buff, long frow, long lrow, int vsize);
+
+	/// Write a column from caller memory, the cfitsio type of T is resolved
+	/// at compile time (see FitsTraits).
+	/// \param[in] buff (lrow-frow+1)*vsize values, row after row.
+	template<class T>
+	void write(int ncol, const T* buff, long frow, long lrow, int vsize = 1) {
+		_write(ncol, buff, FitsTraits<T>::datatype, frow, lrow, vsize);
+	}
+
+	/// Set the TSCALn and TZEROn of a column of the current table, the
+	/// following writes store (value - zero) / scale.
+	void setScaling(int ncol, double scale, double zero);
+
+	/// Make an INT16, INT32 or INT64 column of the current table unsigned,
+	/// with TZEROn 2^15, 2^31 or 2^63 as in the FITS convention.
+	void setUnsigned(int ncol);
+
+	/// Write stored values to a scaled column, without TSCALn and TZEROn,
+	/// e.g. the ones of InputFileFITS::readRaw() from a table with the same
+	/// scaling.
+	template<class T>
+	void writeRaw(int ncol, const T* buff, long frow, long lrow, int vsize = 1) {
+		double scale, zero;
+		_getScaling(ncol, scale, zero);
+		_setTableScale(ncol, 1., 0.);
+		try {
+			_write(ncol, buff, FitsTraits<T>::datatype, frow, lrow, vsize);
+		}
+		catch(IOException& e) {
+			_setTableScale(ncol, scale, zero);
+			throw;
+		}
+		_setTableScale(ncol, scale, zero);
+	}
+
+	/// Set the TNULL value of an integer column of the current table, the
+	/// value of its undefined values.
+	void setNullValue(int ncol, int64_t value);
+
+	/// Write a column, the values with a 0 bit in validity are undefined:
+	/// TNULL for the integer columns (see setNullValue()), NaN for the float
+	/// ones. Only for uncompressed tables.
+	void writeu8i(int ncol, const uint8_t* buff, long frow, long lrow, const ValidityBitmap& validity);
+	void write16i(int ncol, const int16_t* buff, long frow, long lrow, const ValidityBitmap& validity);
+	void write32i(int ncol, const int32_t* buff, long frow, long lrow, const ValidityBitmap& validity);
+	void write64i(int ncol, const int64_t* buff, long frow, long lrow, const ValidityBitmap& validity);
+	void write32f(int ncol, const float* buff, long frow, long lrow, const ValidityBitmap& validity);
+	void write64f(int ncol, const double* buff, long frow, long lrow, const ValidityBitmap& validity);
+
+	/// Write a vector column, the bit of value j of row i is
+	/// (i - frow) * vsize + j.
+	void writeu8iv(int ncol, const uint8_t* buff, long frow, long lrow, int vsize, const ValidityBitmap& validity);
+	void write16iv(int ncol, const int16_t* buff, long frow, long lrow, int vsize, const ValidityBitmap& validity);
+	void write32iv(int ncol, const int32_t* buff, long frow, long lrow, int vsize, const ValidityBitmap& validity);
+	void write64iv(int ncol, const int64_t* buff, long frow, long lrow, int vsize, const ValidityBitmap& validity);
+	void write32fv(int ncol, const float* buff, long frow, long lrow, int vsize, const ValidityBitmap& validity);
+	void write64fv(int ncol, const double* buff, long frow, long lrow, int vsize, const ValidityBitmap& validity);
+
 private:
 
 	bool opened;
 
+	/// The memory file buffer, updated by cfitsio when it grows, and the
+	/// FITS size computed at close().
+	bool memory;
+	void* memBuffer;
+	size_t memSize;
+	size_t memDataSize;
+
+	void freeBuffer();
+	void _endMemory();
+
+	/// Rows written and rows allocated in the current table, tracked when
+	/// rows are preallocated.
+	bool tracked;
+	long logicalRows;
+	long physicalRows;
+	long growthStep;
+
+	/// Image compression settings.
+	Compression compression;
+	std::vector<long> compressionTiles;
+	int compressionThreads;
+	float compressionQuantize;
+
+	/// The current image, when compressed in parallel.
+	bool tiledImage;
+	bool tiledWritten;
+	int imageBitpix;
+	std::vector<long> imageSizes;
+	std::vector<long> imageTiles;
+
+	/// Table compression settings, and the current compressed table.
+	long tableTileRows;
+	int tableThreads;
+	std::vector<Compression> columnCompression;
+	TableCompressor* tableCompressor;
+	long tableTiles;
+
 	void throwException(const char *msg, int status);
 
+	void track();
+	void grow(long lrow);
+	void trim();
+
+	/// The FITS bytes of the bit and logical writes, reused.
+	std::vector<char> bitBytes;
+
+	template<class T>
+	void _writeVar(int ncol, const VarColumn<T>& column, int type, long frow);
+
 	template<class T>
-	void _write(int ncol, std::vector<T>& buff, int type, long frow, long lrow);
+	void _write(int ncol, const T* buff, int type, long frow, long lrow, int vsize = 1);
+
+	template<class T>
+	void _writeImage(const Image<T>& image, int type, const std::vector<int64_t>* first);
+
+	void _createTiledImage(int bitpix, const std::vector<long>& sizes);
+
+	void _writeTiledImage(const void* pixels);
+
+	void _createCompressedTable(const std::string& name, const std::vector<field>& fields);
+
+	void _flushTable(bool last);
+
+	void _endTable();
+
+	TileCompressor::Algorithm _getAlgorithm(Compression type);
+
+	const char* _getAlgorithmName(Compression type);
 
 	template<class T>
 	void _writev(int ncol, std::vector< std::vector<T> >& buff, int type, long frow, long lrow);
 
+	template<class T>
+	void _writeNull(int ncol, const T* buff, int type, long frow, long lrow, int vsize, const ValidityBitmap& validity);
+
 	const std::string _getFieldTypeString(fieldType type, int vsize);
 
+	void _getScaling(int ncol, double& scale, double& zero);
+
+	void _setTableScale(int ncol, double scale, double zero);
+
+	int _getImageBitpix(fieldType type);
+
 protected:
 
 	fitsfile *infptr;
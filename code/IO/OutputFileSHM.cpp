@@ -0,0 +1,263 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <cstring>
+#include <algorithm>
+#include "OutputFileSHM.h"
+
+namespace qlbase {
+
+OutputFileSHM::OutputFileSHM(long capacity) : opened(false), capacity(capacity), committed(0), reserved(0) {
+	if(capacity < 1)
+		throw IOException("Error in OutputFileSHM::OutputFileSHM() invalid capacity", 0);
+}
+
+OutputFileSHM::~OutputFileSHM() {
+	try {
+		close();
+	}
+	catch(IOException& e) {
+	}
+}
+
+void OutputFileSHM::create(const std::string &name) {
+	if(opened)
+		throw IOException("Error in OutputFileSHM::create() already opened", 0);
+
+	File::open(name);
+	committed = 0;
+	reserved = 0;
+	opened = true;
+}
+
+void OutputFileSHM::open(const std::string &name) {
+	throw IOException("Error in OutputFileSHM::open() shared memory tables can only be created", 0);
+}
+
+void OutputFileSHM::close() {
+	if(!opened)
+		return;
+
+	opened = false;
+	if(ring.isAttached()) {
+		ring.setClosed();
+		ring.detach();
+	}
+}
+
+void OutputFileSHM::moveToHeader(int number) {
+	if(!opened || number != 0)
+		throw IOException("Error in OutputFileSHM::moveToHeader() ", 0);
+}
+
+void OutputFileSHM::createTable(const std::string& name, const std::vector<field>& fields) {
+	if(!opened)
+		throw IOException("Error in OutputFileSHM::createTable() ", 0);
+	if(ring.isAttached())
+		throw IOException("Error in OutputFileSHM::createTable() only one table per segment", 0);
+
+	ring.create(_filename, name, fields, capacity);
+}
+
+long OutputFileSHM::getNRows() {
+	if(!ring.isAttached())
+		throw IOException("Error in OutputFileSHM::getNRows() ", 0);
+
+	return committed;
+}
+
+void OutputFileSHM::endRows(long nrows) {
+	if(!ring.isAttached() || nrows < 1 || committed + nrows > reserved)
+		throw IOException("Error in OutputFileSHM::endRows() rows not written", 0);
+
+	committed += nrows;
+	ring.commit(committed);
+}
+
+// Check a write and announce its rows to the readers. Published rows can't
+// be changed, and a write can't overwrite the rows not published yet.
+void OutputFileSHM::prepare(int ncol, long frow, long lrow, int vsize) {
+	if(!ring.isAttached())
+		throw IOException("Error in OutputFileSHM::write() no table", 0);
+	if(ncol < 0 || ncol >= (int) ring.getFields().size() || ring.getFields()[ncol].vsize != vsize)
+		throw IOException("Error in OutputFileSHM::write() invalid column", 0);
+	if(frow < committed || lrow < frow || lrow >= committed + capacity)
+		throw IOException("Error in OutputFileSHM::write() rows out of the ring", 0);
+
+	if(lrow >= reserved) {
+		reserved = lrow + 1;
+		ring.reserve(reserved);
+	}
+}
+
+template<class T>
+void OutputFileSHM::_write(int ncol, const T* buff, long frow, long lrow, int vsize) {
+	prepare(ncol, frow, lrow, vsize);
+
+	fieldType type = ring.getFields()[ncol].type;
+	long row = frow;
+	while(row <= lrow) {
+		// up to the end of the ring
+		long nrows = std::min(lrow - row + 1, capacity - row % capacity);
+		char* dst = ring.getSlot(ncol, row);
+		const T* src = buff + (row - frow) * vsize;
+		storeAs(type, dst, src, nrows * vsize);
+		row += nrows;
+	}
+}
+
+template<class T>
+void OutputFileSHM::_writev(int ncol, std::vector< std::vector<T> >& buff, long frow, long lrow) {
+	long nrows = lrow - frow + 1;
+	if(nrows < 1 || (long) buff.size() < nrows)
+		throw IOException("Error in OutputFileSHM::write() ", 0);
+
+	int vsize = buff[0].size();
+	std::vector<T> values;
+	values.reserve(nrows * vsize);
+	for(long i=0; i<nrows; i++) {
+		if((int) buff[i].size() != vsize)
+			throw IOException("Error in OutputFileSHM::write() rows of different sizes", 0);
+		values.insert(values.end(), buff[i].begin(), buff[i].end());
+	}
+
+	_write(ncol, &values[0], frow, lrow, vsize);
+}
+
+void OutputFileSHM::writeString(int ncol, std::vector< std::vector<char> >& buff, long frow, long lrow) {
+	long nrows = lrow - frow + 1;
+	if(!ring.isAttached() || ncol < 0 || ncol >= (int) ring.getFields().size()
+	   || ring.getFields()[ncol].type != STRING || nrows < 1 || (long) buff.size() < nrows)
+		throw IOException("Error in OutputFileSHM::writeString() ", 0);
+
+	// truncated or padded to the column size
+	int vsize = ring.getFields()[ncol].vsize;
+	prepare(ncol, frow, lrow, vsize);
+	for(long i=0; i<nrows; i++) {
+		char* dst = ring.getSlot(ncol, frow + i);
+		size_t n = std::min(buff[i].size(), (size_t) vsize);
+		memcpy(dst, buff[i].data(), n);
+		memset(dst + n, 0, vsize - n);
+	}
+}
+
+void OutputFileSHM::writeu8i(int ncol, std::vector<uint8_t>& buff, long frow, long lrow) {
+	if((long) buff.size() < lrow - frow + 1)
+		throw IOException("Error in OutputFileSHM::writeu8i() ", 0);
+	_write(ncol, buff.data(), frow, lrow);
+}
+
+void OutputFileSHM::write16i(int ncol, std::vector<int16_t>& buff, long frow, long lrow) {
+	if((long) buff.size() < lrow - frow + 1)
+		throw IOException("Error in OutputFileSHM::write16i() ", 0);
+	_write(ncol, buff.data(), frow, lrow);
+}
+
+void OutputFileSHM::write32i(int ncol, std::vector<int32_t>& buff, long frow, long lrow) {
+	if((long) buff.size() < lrow - frow + 1)
+		throw IOException("Error in OutputFileSHM::write32i() ", 0);
+	_write(ncol, buff.data(), frow, lrow);
+}
+
+void OutputFileSHM::write64i(int ncol, std::vector<int64_t>& buff, long frow, long lrow) {
+	if((long) buff.size() < lrow - frow + 1)
+		throw IOException("Error in OutputFileSHM::write64i() ", 0);
+	_write(ncol, buff.data(), frow, lrow);
+}
+
+void OutputFileSHM::write32f(int ncol, std::vector<float>& buff, long frow, long lrow) {
+	if((long) buff.size() < lrow - frow + 1)
+		throw IOException("Error in OutputFileSHM::write32f() ", 0);
+	_write(ncol, buff.data(), frow, lrow);
+}
+
+void OutputFileSHM::write64f(int ncol, std::vector<double>& buff, long frow, long lrow) {
+	if((long) buff.size() < lrow - frow + 1)
+		throw IOException("Error in OutputFileSHM::write64f() ", 0);
+	_write(ncol, buff.data(), frow, lrow);
+}
+
+void OutputFileSHM::writeu8iv(int ncol, std::vector< std::vector<uint8_t> >& buff, long frow, long lrow) {
+	_writev(ncol, buff, frow, lrow);
+}
+
+void OutputFileSHM::write16iv(int ncol, std::vector< std::vector<int16_t> >& buff, long frow, long lrow) {
+	_writev(ncol, buff, frow, lrow);
+}
+
+void OutputFileSHM::write32iv(int ncol, std::vector< std::vector<int32_t> >& buff, long frow, long lrow) {
+	_writev(ncol, buff, frow, lrow);
+}
+
+void OutputFileSHM::write64iv(int ncol, std::vector< std::vector<int64_t> >& buff, long frow, long lrow) {
+	_writev(ncol, buff, frow, lrow);
+}
+
+void OutputFileSHM::write32fv(int ncol, std::vector< std::vector<float> >& buff, long frow, long lrow) {
+	_writev(ncol, buff, frow, lrow);
+}
+
+void OutputFileSHM::write64fv(int ncol, std::vector< std::vector<double> >& buff, long frow, long lrow) {
+	_writev(ncol, buff, frow, lrow);
+}
+
+void OutputFileSHM::writeu8i(int ncol, const uint8_t* buff, long frow, long lrow) {
+	_write(ncol, buff, frow, lrow);
+}
+
+void OutputFileSHM::write16i(int ncol, const int16_t* buff, long frow, long lrow) {
+	_write(ncol, buff, frow, lrow);
+}
+
+void OutputFileSHM::write32i(int ncol, const int32_t* buff, long frow, long lrow) {
+	_write(ncol, buff, frow, lrow);
+}
+
+void OutputFileSHM::write64i(int ncol, const int64_t* buff, long frow, long lrow) {
+	_write(ncol, buff, frow, lrow);
+}
+
+void OutputFileSHM::write32f(int ncol, const float* buff, long frow, long lrow) {
+	_write(ncol, buff, frow, lrow);
+}
+
+void OutputFileSHM::write64f(int ncol, const double* buff, long frow, long lrow) {
+	_write(ncol, buff, frow, lrow);
+}
+
+void OutputFileSHM::writeu8iv(int ncol, const uint8_t* buff, long frow, long lrow, int vsize) {
+	_write(ncol, buff, frow, lrow, vsize);
+}
+
+void OutputFileSHM::write16iv(int ncol, const int16_t* buff, long frow, long lrow, int vsize) {
+	_write(ncol, buff, frow, lrow, vsize);
+}
+
+void OutputFileSHM::write32iv(int ncol, const int32_t* buff, long frow, long lrow, int vsize) {
+	_write(ncol, buff, frow, lrow, vsize);
+}
+
+void OutputFileSHM::write64iv(int ncol, const int64_t* buff, long frow, long lrow, int vsize) {
+	_write(ncol, buff, frow, lrow, vsize);
+}
+
+void OutputFileSHM::write32fv(int ncol, const float* buff, long frow, long lrow, int vsize) {
+	_write(ncol, buff, frow, lrow, vsize);
+}
+
+void OutputFileSHM::write64fv(int ncol, const double* buff, long frow, long lrow, int vsize) {
+	_write(ncol, buff, frow, lrow, vsize);
+}
+
+}
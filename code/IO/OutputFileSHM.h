@@ -0,0 +1,129 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_OUTPUTFILESHM_H
+#define QL_IO_OUTPUTFILESHM_H
+
+#include <stdint.h>
+#include <string>
+#include "OutputFile.h"
+#include "SharedRing.h"
+
+namespace qlbase {
+
+/// Publish a table to other processes through a POSIX shared memory ring
+/// (see SharedRing), read with InputFileSHM. The columns of a block of rows
+/// are written as in a file, then the block is published with endRows().
+/// The writer never waits for the readers: the rows older than the ring
+/// capacity are overwritten.
+///
+/// \code
+/// OutputFileSHM file(65536);
+/// file.create("/acquisition");
+/// file.createTable("EVENTS", fields);
+/// file.write64f(0, time, frow, lrow);
+/// file.write32i(1, counts, frow, lrow);
+/// file.endRows(lrow - frow + 1);
+/// \endcode
+///
+/// The values are converted to the column types. The segment is removed
+/// by close(), the readers attached keep reading it.
+/// All methods throw qlbase::IOException on errors.
+class OutputFileSHM : public OutputFile {
+
+public:
+
+	/// \param[in] capacity The rows of the ring.
+	OutputFileSHM(long capacity = 65536);
+
+	virtual ~OutputFileSHM();
+
+	/// Set the segment name, created with the table.
+	virtual void create(const std::string &name);
+
+	/// Shared memory tables can only be created.
+	virtual void open(const std::string &name);
+
+	/// Mark the table as finished and remove the segment.
+	virtual void close();
+	virtual bool isOpened() { return opened; }
+
+	/// There is only the table header (0).
+	virtual void moveToHeader(int number);
+
+	/// Create the segment with the table, only one per file.
+	virtual void createTable(const std::string& name, const std::vector<field>& fields);
+
+	/// Publish the next nrows rows, written in all the columns.
+	void endRows(long nrows);
+
+	/// Get the number of published rows.
+	long getNRows();
+
+	long getCapacity() { return capacity; }
+
+	virtual void writeu8i(int ncol, std::vector<uint8_t>& buff, long frow, long lrow);
+	virtual void write16i(int ncol, std::vector<int16_t>& buff, long frow, long lrow);
+	virtual void write32i(int ncol, std::vector<int32_t>& buff, long frow, long lrow);
+	virtual void write64i(int ncol, std::vector<int64_t>& buff, long frow, long lrow);
+	virtual void write32f(int ncol, std::vector<float>& buff, long frow, long lrow);
+	virtual void write64f(int ncol, std::vector<double>& buff, long frow, long lrow);
+
+	virtual void writeu8iv(int ncol, std::vector< std::vector<uint8_t> >& buff, long frow, long lrow);
+	virtual void write16iv(int ncol, std::vector< std::vector<int16_t> >& buff, long frow, long lrow);
+	virtual void write32iv(int ncol, std::vector< std::vector<int32_t> >& buff, long frow, long lrow);
+	virtual void write64iv(int ncol, std::vector< std::vector<int64_t> >& buff, long frow, long lrow);
+	virtual void write32fv(int ncol, std::vector< std::vector<float> >& buff, long frow, long lrow);
+	virtual void write64fv(int ncol, std::vector< std::vector<double> >& buff, long frow, long lrow);
+	virtual void writeString(int ncol, std::vector< std::vector<char> >& buff, long frow, long lrow);
+
+	virtual void writeu8i(int ncol, const uint8_t* buff, long frow, long lrow);
+	virtual void write16i(int ncol, const int16_t* buff, long frow, long lrow);
+	virtual void write32i(int ncol, const int32_t* buff, long frow, long lrow);
+	virtual void write64i(int ncol, const int64_t* buff, long frow, long lrow);
+	virtual void write32f(int ncol, const float* buff, long frow, long lrow);
+	virtual void write64f(int ncol, const double* buff, long frow, long lrow);
+
+	virtual void writeu8iv(int ncol, const uint8_t* buff, long frow, long lrow, int vsize);
+	virtual void write16iv(int ncol, const int16_t* buff, long frow, long lrow, int vsize);
+	virtual void write32iv(int ncol, const int32_t* buff, long frow, long lrow, int vsize);
+	virtual void write64iv(int ncol, const int64_t* buff, long frow, long lrow, int vsize);
+	virtual void write32fv(int ncol, const float* buff, long frow, long lrow, int vsize);
+	virtual void write64fv(int ncol, const double* buff, long frow, long lrow, int vsize);
+
+private:
+
+	OutputFileSHM(const OutputFileSHM&);
+	OutputFileSHM& operator=(const OutputFileSHM&);
+
+	bool opened;
+	long capacity;
+	SharedRing ring;
+
+	/// Rows published, and rows announced to the readers.
+	long committed;
+	long reserved;
+
+	void prepare(int ncol, long frow, long lrow, int vsize);
+
+	template<class T>
+	void _write(int ncol, const T* buff, long frow, long lrow, int vsize = 1);
+
+	template<class T>
+	void _writev(int ncol, std::vector< std::vector<T> >& buff, long frow, long lrow);
+};
+
+}
+
+#endif
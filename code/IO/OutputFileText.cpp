@@ -0,0 +1,458 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include "OutputFileText.h"
+
+namespace qlbase {
+
+/// Rows buffered before formatting, and minimum rows formatted by a thread.
+#define FLUSHROWS 65536
+#define THREADROWS 4096
+
+static inline void appendInt(std::string& out, int64_t value) {
+	char buff[24];
+	char* p = buff + sizeof(buff);
+	uint64_t u = value < 0 ? -(uint64_t) value : value;
+	do {
+		*--p = '0' + u % 10;
+		u /= 10;
+	} while(u);
+	if(value < 0)
+		*--p = '-';
+	out.append(p, buff + sizeof(buff) - p);
+}
+
+// The shortest %g precision reading back the same value. Most values need
+// the first try (6 digits for float, 15 for double).
+static inline void appendReal(std::string& out, double value, bool single) {
+	if(std::isnan(value)) {
+		out += "nan";
+		return;
+	}
+	if(std::isinf(value)) {
+		out += value < 0 ? "-inf" : "inf";
+		return;
+	}
+
+	char buff[32];
+	int n = 0;
+	for(int precision = single ? 6 : 15; precision <= (single ? 9 : 17); precision++) {
+		n = snprintf(buff, sizeof(buff), "%.*g", precision, value);
+		if(single ? strtof(buff, 0) == (float) value : strtod(buff, 0) == value)
+			break;
+	}
+	out.append(buff, n);
+}
+
+OutputFileText::OutputFileText(const std::string &separator) : opened(false), fp(0), separator(separator),
+                                                               columnNames(false), tables(false), baseRow(0) {
+}
+
+OutputFileText::~OutputFileText() {
+	// write the buffered rows
+	try {
+		if(opened)
+			close();
+	}
+	catch(IOException& e) {
+	}
+	if(fp)
+		fclose(fp);
+}
+
+void OutputFileText::openFile(const std::string &filename, const char* mode) {
+	if(opened)
+		throw IOException("Error in OutputFileText::open() file already opened", 0);
+
+	File::open(filename);
+	fp = fopen(filename.c_str(), mode);
+	if(!fp)
+		throw IOException("Error in OutputFileText::open() ", 0);
+
+	// the formatted blocks are written at once
+	setvbuf(fp, 0, _IONBF, 0);
+
+	opened = true;
+	tables = false;
+}
+
+void OutputFileText::create(const std::string &filename) {
+	openFile(filename, "w");
+}
+
+void OutputFileText::open(const std::string &filename) {
+	openFile(filename, "a");
+
+	// append the tables after an empty line, like a new table
+	fseek(fp, 0, SEEK_END);
+	tables = ftell(fp) > 0;
+}
+
+void OutputFileText::close() {
+	if(!opened)
+		throw IOException("Error in OutputFileText::close() ", 0);
+
+	opened = false;
+	try {
+		endTable();
+	}
+	catch(IOException& e) {
+		fclose(fp);
+		fp = 0;
+		throw;
+	}
+
+	int status = fclose(fp);
+	fp = 0;
+	if(status != 0)
+		throw IOException("Error in OutputFileText::close() ", 0);
+}
+
+void OutputFileText::createTable(const std::string& name, const std::vector<field>& fields) {
+	if(!isOpened())
+		throw IOException("Error in OutputFileText::createTable() ", 0);
+
+	endTable();
+
+	std::string header;
+	if(tables)
+		header += "\n";
+	tables = true;
+
+	columns.resize(fields.size());
+	for(unsigned int i=0; i<fields.size(); i++) {
+		if(fields[i].vsize < 1)
+			throw IOException("Error in OutputFileText::createTable() vsize < 1", 0);
+		if(fields[i].type > STRING)
+			throw IOException("Error in OutputFileText::createTable() bit and logical columns are not supported", 0);
+
+		columns[i].type = fields[i].type;
+		columns[i].vsize = fields[i].vsize;
+		columns[i].width = getTypeSize(fields[i].type) * fields[i].vsize;
+		columns[i].data.clear();
+		columns[i].rows = 0;
+
+		if(!columnNames)
+			continue;
+
+		int nnames = fields[i].type == STRING ? 1 : fields[i].vsize;
+		for(int j=0; j<nnames; j++) {
+			if(header.size() && header[header.size()-1] != '\n')
+				header += separator;
+			header += fields[i].name;
+			if(nnames > 1) {
+				header += "_";
+				appendInt(header, j);
+			}
+		}
+	}
+	if(columnNames)
+		header += "\n";
+
+	baseRow = 0;
+	writeBuffer(header);
+}
+
+void OutputFileText::endTable() {
+	// rows not written by some columns are left to 0
+	long rows = 0;
+	for(unsigned int i=0; i<columns.size(); i++)
+		rows = std::max(rows, columns[i].rows);
+	for(unsigned int i=0; i<columns.size(); i++) {
+		columns[i].data.resize(rows * columns[i].width, 0);
+		columns[i].rows = rows;
+	}
+
+	flush(rows);
+	columns.clear();
+}
+
+char* OutputFileText::prepare(int ncol, long frow, long lrow, int vsize, bool strings) {
+	if(!isOpened())
+		throw IOException("Error in OutputFileText::write() ", 0);
+	if(ncol < 0 || ncol >= (int) columns.size())
+		throw IOException("Error in OutputFileText::write() wrong column", 0);
+	if(frow < baseRow || lrow < frow)
+		throw IOException("Error in OutputFileText::write() wrong rows or rows already written", 0);
+
+	Column& c = columns[ncol];
+	if(strings && c.type != STRING)
+		throw IOException("Error in OutputFileText::writeString() strings in a number column", 0);
+	if(!strings && c.type == STRING)
+		throw IOException("Error in OutputFileText::write() numbers in a string column", 0);
+	if(vsize != c.vsize && c.type != STRING)
+		throw IOException("Error in OutputFileText::write() wrong vector size", 0);
+
+	long rows = lrow + 1 - baseRow;
+	if(rows > c.rows) {
+		c.data.resize(rows * c.width, 0);
+		c.rows = rows;
+	}
+
+	return &c.data[(frow - baseRow) * c.width];
+}
+
+template<class T>
+void OutputFileText::_write(int ncol, const T* buff, long frow, long lrow, int vsize) {
+	char* dst = prepare(ncol, frow, lrow, vsize);
+	storeAs(columns[ncol].type, dst, buff, (lrow - frow + 1) * vsize);
+	flushComplete();
+}
+
+template<class T>
+void OutputFileText::_writev(int ncol, std::vector< std::vector<T> >& buff, long frow, long lrow) {
+	long nelem = lrow - frow + 1;
+	if(nelem < 1 || (long) buff.size() < nelem)
+		throw IOException("Error in OutputFileText::_writev() ", 0);
+	for(long row = 1; row < nelem; row++)
+		if(buff[row].size() != buff[0].size())
+			throw IOException("Error in OutputFileText::_writev() wrong vector size", 0);
+
+	char* dst = prepare(ncol, frow, lrow, buff[0].size());
+	Column& c = columns[ncol];
+	for(long row = 0; row < nelem; row++)
+		storeAs(c.type, dst + row * c.width, &buff[row][0], c.vsize);
+	flushComplete();
+}
+
+void OutputFileText::writeu8i(int ncol, std::vector<uint8_t>& buff, long frow, long lrow) {
+	if((long) buff.size() < lrow - frow + 1)
+		throw IOException("Error in OutputFileText::writeu8i() ", 0);
+	_write(ncol, buff.data(), frow, lrow);
+}
+
+void OutputFileText::write16i(int ncol, std::vector<int16_t>& buff, long frow, long lrow) {
+	if((long) buff.size() < lrow - frow + 1)
+		throw IOException("Error in OutputFileText::write16i() ", 0);
+	_write(ncol, buff.data(), frow, lrow);
+}
+
+void OutputFileText::write32i(int ncol, std::vector<int32_t>& buff, long frow, long lrow) {
+	if((long) buff.size() < lrow - frow + 1)
+		throw IOException("Error in OutputFileText::write32i() ", 0);
+	_write(ncol, buff.data(), frow, lrow);
+}
+
+void OutputFileText::write64i(int ncol, std::vector<int64_t>& buff, long frow, long lrow) {
+	if((long) buff.size() < lrow - frow + 1)
+		throw IOException("Error in OutputFileText::write64i() ", 0);
+	_write(ncol, buff.data(), frow, lrow);
+}
+
+void OutputFileText::write32f(int ncol, std::vector<float>& buff, long frow, long lrow) {
+	if((long) buff.size() < lrow - frow + 1)
+		throw IOException("Error in OutputFileText::write32f() ", 0);
+	_write(ncol, buff.data(), frow, lrow);
+}
+
+void OutputFileText::write64f(int ncol, std::vector<double>& buff, long frow, long lrow) {
+	if((long) buff.size() < lrow - frow + 1)
+		throw IOException("Error in OutputFileText::write64f() ", 0);
+	_write(ncol, buff.data(), frow, lrow);
+}
+
+void OutputFileText::writeu8iv(int ncol, std::vector< std::vector<uint8_t> >& buff, long frow, long lrow) {
+	_writev(ncol, buff, frow, lrow);
+}
+
+void OutputFileText::write16iv(int ncol, std::vector< std::vector<int16_t> >& buff, long frow, long lrow) {
+	_writev(ncol, buff, frow, lrow);
+}
+
+void OutputFileText::write32iv(int ncol, std::vector< std::vector<int32_t> >& buff, long frow, long lrow) {
+	_writev(ncol, buff, frow, lrow);
+}
+
+void OutputFileText::write64iv(int ncol, std::vector< std::vector<int64_t> >& buff, long frow, long lrow) {
+	_writev(ncol, buff, frow, lrow);
+}
+
+void OutputFileText::write32fv(int ncol, std::vector< std::vector<float> >& buff, long frow, long lrow) {
+	_writev(ncol, buff, frow, lrow);
+}
+
+void OutputFileText::write64fv(int ncol, std::vector< std::vector<double> >& buff, long frow, long lrow) {
+	_writev(ncol, buff, frow, lrow);
+}
+
+void OutputFileText::writeu8i(int ncol, const uint8_t* buff, long frow, long lrow) {
+	_write(ncol, buff, frow, lrow);
+}
+
+void OutputFileText::write16i(int ncol, const int16_t* buff, long frow, long lrow) {
+	_write(ncol, buff, frow, lrow);
+}
+
+void OutputFileText::write32i(int ncol, const int32_t* buff, long frow, long lrow) {
+	_write(ncol, buff, frow, lrow);
+}
+
+void OutputFileText::write64i(int ncol, const int64_t* buff, long frow, long lrow) {
+	_write(ncol, buff, frow, lrow);
+}
+
+void OutputFileText::write32f(int ncol, const float* buff, long frow, long lrow) {
+	_write(ncol, buff, frow, lrow);
+}
+
+void OutputFileText::write64f(int ncol, const double* buff, long frow, long lrow) {
+	_write(ncol, buff, frow, lrow);
+}
+
+void OutputFileText::writeu8iv(int ncol, const uint8_t* buff, long frow, long lrow, int vsize) {
+	_write(ncol, buff, frow, lrow, vsize);
+}
+
+void OutputFileText::write16iv(int ncol, const int16_t* buff, long frow, long lrow, int vsize) {
+	_write(ncol, buff, frow, lrow, vsize);
+}
+
+void OutputFileText::write32iv(int ncol, const int32_t* buff, long frow, long lrow, int vsize) {
+	_write(ncol, buff, frow, lrow, vsize);
+}
+
+void OutputFileText::write64iv(int ncol, const int64_t* buff, long frow, long lrow, int vsize) {
+	_write(ncol, buff, frow, lrow, vsize);
+}
+
+void OutputFileText::write32fv(int ncol, const float* buff, long frow, long lrow, int vsize) {
+	_write(ncol, buff, frow, lrow, vsize);
+}
+
+void OutputFileText::write64fv(int ncol, const double* buff, long frow, long lrow, int vsize) {
+	_write(ncol, buff, frow, lrow, vsize);
+}
+
+void OutputFileText::writeString(int ncol, std::vector< std::vector<char> >& buff, long frow, long lrow) {
+	long nelem = lrow - frow + 1;
+	if((long) buff.size() < nelem)
+		throw IOException("Error in OutputFileText::writeString() ", 0);
+
+	char* dst = prepare(ncol, frow, lrow, 0, true);
+	Column& c = columns[ncol];
+
+	for(long row = 0; row < nelem; row++) {
+		size_t size = std::min(buff[row].size(), c.width);
+		if(size)
+			memcpy(dst + row * c.width, &buff[row][0], size);
+		memset(dst + row * c.width + size, 0, c.width - size);
+	}
+	flushComplete();
+}
+
+void OutputFileText::flushComplete() {
+	long complete = columns[0].rows;
+	for(unsigned int i=1; i<columns.size(); i++)
+		complete = std::min(complete, columns[i].rows);
+
+	if(complete >= FLUSHROWS)
+		flush(complete);
+}
+
+void OutputFileText::flush(long rows) {
+	if(rows <= 0)
+		return;
+
+	long nthreads = std::thread::hardware_concurrency();
+	if(nthreads < 1)
+		nthreads = 1;
+	if(nthreads > rows / THREADROWS)
+		nthreads = rows / THREADROWS > 0 ? rows / THREADROWS : 1;
+
+	// each thread formats a block of rows in its own buffer
+	std::vector<std::string> buffers(nthreads);
+	std::vector<std::thread> threads;
+	long rowsPerThread = (rows + nthreads - 1) / nthreads;
+	for(long t = 1; t < nthreads; t++) {
+		long frow = t * rowsPerThread;
+		long lrow = std::min(frow + rowsPerThread, rows) - 1;
+		threads.push_back(std::thread(&OutputFileText::formatRows, this, std::ref(buffers[t]), frow, lrow));
+	}
+	formatRows(buffers[0], 0, std::min(rowsPerThread, rows) - 1);
+	for(unsigned int i=0; i<threads.size(); i++)
+		threads[i].join();
+
+	for(long t = 0; t < nthreads; t++)
+		writeBuffer(buffers[t]);
+
+	for(unsigned int i=0; i<columns.size(); i++) {
+		Column& c = columns[i];
+		c.data.erase(c.data.begin(), c.data.begin() + rows * c.width);
+		c.rows -= rows;
+	}
+	baseRow += rows;
+}
+
+void OutputFileText::formatRows(std::string& out, long frow, long lrow) {
+	out.reserve((lrow - frow + 1) * columns.size() * 12);
+
+	for(long row = frow; row <= lrow; row++) {
+		bool first = true;
+		for(unsigned int i=0; i<columns.size(); i++) {
+			const Column& c = columns[i];
+			const char* data = &c.data[row * c.width];
+
+			if(c.type == STRING) {
+				if(!first)
+					out += separator;
+				first = false;
+
+				size_t size = strnlen(data, c.width);
+				bool quote = size == 0 || std::string(data, size).find_first_of(separator + "\"\n") != std::string::npos;
+				if(!quote) {
+					out.append(data, size);
+					continue;
+				}
+				out += '"';
+				for(size_t j=0; j<size; j++) {
+					if(data[j] == '"')
+						out += '"';
+					out += data[j];
+				}
+				out += '"';
+				continue;
+			}
+
+			for(int j=0; j<c.vsize; j++) {
+				if(!first)
+					out += separator;
+				first = false;
+
+				switch(c.type) {
+					case UNSIGNED_INT8: appendInt(out, ((const uint8_t*) data)[j]); break;
+					case INT16: appendInt(out, ((const int16_t*) data)[j]); break;
+					case INT32: appendInt(out, ((const int32_t*) data)[j]); break;
+					case INT64: appendInt(out, ((const int64_t*) data)[j]); break;
+					case FLOAT: appendReal(out, ((const float*) data)[j], true); break;
+					case DOUBLE: appendReal(out, ((const double*) data)[j], false); break;
+					default: break;
+				}
+			}
+		}
+		out += '\n';
+	}
+}
+
+void OutputFileText::writeBuffer(const std::string& buffer) {
+	if(buffer.size() && fwrite(buffer.data(), 1, buffer.size(), fp) != buffer.size())
+		throw IOException("Error in OutputFileText::write() ", 0);
+}
+
+}
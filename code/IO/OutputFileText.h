@@ -0,0 +1,142 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_OUTPUTFILETEXT_H
+#define QL_IO_OUTPUTFILETEXT_H
+
+#include <stdint.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "OutputFile.h"
+
+namespace qlbase {
+
+/// Text (e.g. CSV) file writer, one table row for each line.
+/// Columns are buffered until all of them are written for a block of rows,
+/// then the rows are formatted in parallel and written in order. Floating
+/// point values use the shortest precision that reads back the same value.
+/// Rows never written by some column are written as 0 when the table ends.
+/// All methods except isOpened() throw qlbase::IOException on errors.
+class OutputFileText : public OutputFile {
+
+public:
+
+	/// \param[in] separator The field separator (e.g. "," for CSV).
+	OutputFileText(const std::string &separator = std::string(" "));
+	virtual ~OutputFileText();
+
+	/// Create a new file, overwriting an existing one.
+	virtual void create(const std::string &filename);
+
+	/// Open a file, the new tables are appended.
+	virtual void open(const std::string &filename);
+
+	/// Write the buffered rows and close the file.
+	virtual void close();
+	virtual bool isOpened() { return opened; }
+
+	virtual void moveToHeader(int number)
+	{
+		throw IOException("moveToHeader not supported", 0);
+	}
+
+	/// Write the column names as the first line of each table (vector
+	/// columns as name_0, name_1, ...). Call it before createTable().
+	void writeColumnNames(bool enable = true) { columnNames = enable; }
+
+	/// Start a new table, writing the rows of the previous one. Tables are
+	/// separated by an empty line.
+	virtual void createTable(const std::string& name, const std::vector<field>& fields);
+
+	/// Write a block of rows of a column. Rows already flushed to the file
+	/// can't be written again.
+	virtual void writeu8i(int ncol, std::vector<uint8_t>& buff, long frow, long lrow);
+	virtual void write16i(int ncol, std::vector<int16_t>& buff, long frow, long lrow);
+	virtual void write32i(int ncol, std::vector<int32_t>& buff, long frow, long lrow);
+	virtual void write64i(int ncol, std::vector<int64_t>& buff, long frow, long lrow);
+	virtual void write32f(int ncol, std::vector<float>& buff, long frow, long lrow);
+	virtual void write64f(int ncol, std::vector<double>& buff, long frow, long lrow);
+
+	/// Write a block of rows of a vector column, one field for each element.
+	virtual void writeu8iv(int ncol, std::vector< std::vector<uint8_t> >& buff, long frow, long lrow);
+	virtual void write16iv(int ncol, std::vector< std::vector<int16_t> >& buff, long frow, long lrow);
+	virtual void write32iv(int ncol, std::vector< std::vector<int32_t> >& buff, long frow, long lrow);
+	virtual void write64iv(int ncol, std::vector< std::vector<int64_t> >& buff, long frow, long lrow);
+	virtual void write32fv(int ncol, std::vector< std::vector<float> >& buff, long frow, long lrow);
+	virtual void write64fv(int ncol, std::vector< std::vector<double> >& buff, long frow, long lrow);
+
+	/// Write a block of strings. Strings that are empty or contain the
+	/// separator or quotes are quoted, CSV style.
+	virtual void writeString(int ncol, std::vector< std::vector<char> >& buff, long frow, long lrow);
+
+	/// Write from caller memory, the values are converted to the column type.
+	virtual void writeu8i(int ncol, const uint8_t* buff, long frow, long lrow);
+	virtual void write16i(int ncol, const int16_t* buff, long frow, long lrow);
+	virtual void write32i(int ncol, const int32_t* buff, long frow, long lrow);
+	virtual void write64i(int ncol, const int64_t* buff, long frow, long lrow);
+	virtual void write32f(int ncol, const float* buff, long frow, long lrow);
+	virtual void write64f(int ncol, const double* buff, long frow, long lrow);
+
+	virtual void writeu8iv(int ncol, const uint8_t* buff, long frow, long lrow, int vsize);
+	virtual void write16iv(int ncol, const int16_t* buff, long frow, long lrow, int vsize);
+	virtual void write32iv(int ncol, const int32_t* buff, long frow, long lrow, int vsize);
+	virtual void write64iv(int ncol, const int64_t* buff, long frow, long lrow, int vsize);
+	virtual void write32fv(int ncol, const float* buff, long frow, long lrow, int vsize);
+	virtual void write64fv(int ncol, const double* buff, long frow, long lrow, int vsize);
+
+private:
+
+	struct Column {
+		fieldType type;
+		int vsize;
+		size_t width;
+		/// Values of the buffered rows, in the column type.
+		std::vector<char> data;
+		/// Number of buffered rows.
+		long rows;
+	};
+
+	bool opened;
+	FILE* fp;
+	std::string separator;
+	bool columnNames;
+	bool tables;
+
+	std::vector<Column> columns;
+
+	/// The table row of the first buffered row.
+	long baseRow;
+
+	void openFile(const std::string &filename, const char* mode);
+
+	/// Check a write, numbers or strings, then get the buffer of its rows.
+	char* prepare(int ncol, long frow, long lrow, int vsize, bool strings = false);
+	void flushComplete();
+	void flush(long rows);
+	void endTable();
+
+	void formatRows(std::string& out, long frow, long lrow);
+	void writeBuffer(const std::string& buffer);
+
+	template<class T>
+	void _write(int ncol, const T* buff, long frow, long lrow, int vsize = 1);
+
+	template<class T>
+	void _writev(int ncol, std::vector< std::vector<T> >& buff, long frow, long lrow);
+};
+
+}
+
+#endif
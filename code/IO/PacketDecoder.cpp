@@ -0,0 +1,221 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include "PacketDecoder.h"
+
+namespace qlbase {
+
+// the types written by fits2xml
+static bool ddlType(const std::string& name, fieldType& type) {
+	if(name == "byte")
+		type = UNSIGNED_INT8;
+	else if(name == "int16")
+		type = INT16;
+	else if(name == "int32")
+		type = INT32;
+	else if(name == "int64")
+		type = INT64;
+	else if(name == "float32")
+		type = FLOAT;
+	else if(name == "float64")
+		type = DOUBLE;
+	else
+		return false;
+	return true;
+}
+
+// the value of attribute name in the tag text, "" if missing
+static std::string attribute(const std::string& tag, const std::string& name) {
+	std::string key = " " + name + "=\"";
+	size_t p = tag.find(key);
+	if(p == std::string::npos)
+		return "";
+	p += key.size();
+	size_t end = tag.find('"', p);
+	if(end == std::string::npos)
+		return "";
+	return tag.substr(p, end - p);
+}
+
+PacketDecoder::PacketDecoder() : headerSize(0), packetSize(0), fixedPacketSize(false), bigEndian(true) {
+}
+
+void PacketDecoder::load(const std::string& filename, const std::string& typeName) {
+	std::ifstream file(filename.c_str());
+	if(!file.is_open())
+		throw IOException("Error in PacketDecoder::load() cannot open " + filename, 0);
+
+	std::stringstream ddl;
+	ddl << file.rdbuf();
+	loadString(ddl.str(), typeName);
+}
+
+void PacketDecoder::loadString(const std::string& ddl, const std::string& typeName) {
+	size_t begin = ddl.find("<type name=\"" + typeName + "\"");
+	if(begin == std::string::npos)
+		throw IOException("Error in PacketDecoder::loadString() no type " + typeName, 0);
+	size_t end = ddl.find("</type>", begin);
+	if(end == std::string::npos)
+		throw IOException("Error in PacketDecoder::loadString() unterminated type " + typeName, 0);
+
+	std::vector<field> loaded;
+	size_t p = begin;
+	while((p = ddl.find("<column", p)) < end) {
+		size_t close = ddl.find('>', p);
+		if(close == std::string::npos || close > end)
+			throw IOException("Error in PacketDecoder::loadString() unterminated column", 0);
+		std::string tag = ddl.substr(p, close - p);
+		p = close;
+
+		field f;
+		f.name = attribute(tag, "name");
+		if(!ddlType(attribute(tag, "type"), f.type))
+			throw IOException("Error in PacketDecoder::loadString() unsupported type of column " + f.name, 0);
+		std::string arraysize = attribute(tag, "arraysize");
+		f.vsize = arraysize.empty() ? 1 : atoi(arraysize.c_str());
+		if(f.vsize < 1)
+			throw IOException("Error in PacketDecoder::loadString() invalid arraysize of column " + f.name, 0);
+		f.unit = attribute(tag, "unit");
+		loaded.push_back(f);
+	}
+
+	if(loaded.empty())
+		throw IOException("Error in PacketDecoder::loadString() no columns in type " + typeName, 0);
+
+	fields.swap(loaded);
+	layout();
+}
+
+void PacketDecoder::setBigEndian(bool bigEndian) {
+	this->bigEndian = bigEndian;
+	layout();
+}
+
+void PacketDecoder::setHeaderSize(size_t bytes) {
+	headerSize = bytes;
+	layout();
+}
+
+void PacketDecoder::setPacketSize(size_t bytes) {
+	packetSize = bytes;
+	fixedPacketSize = true;
+	layout();
+}
+
+void PacketDecoder::layout() {
+	columns.resize(fields.size());
+	size_t offset = headerSize;
+	bool swap = bigEndian != hostBigEndian();
+	for(unsigned int i=0; i<fields.size(); i++) {
+		Column& c = columns[i];
+		c.offset = offset;
+		c.elementSize = getTypeSize(fields[i].type);
+		c.width = c.elementSize * fields[i].vsize;
+		c.swap = swap && c.elementSize > 1;
+		offset += c.width;
+	}
+
+	if(!fixedPacketSize)
+		packetSize = offset;
+	else if(packetSize < offset)
+		throw IOException("Error in PacketDecoder::setPacketSize() packets smaller than the columns", 0);
+}
+
+// copy a column of width bytes for each packet, with a constant width the
+// memcpy becomes a few moves
+template<size_t WIDTH>
+static void copyFixed(const char* src, size_t stride, long npackets, char* dst) {
+	for(long i=0; i<npackets; i++, src += stride, dst += WIDTH)
+		memcpy(dst, src, WIDTH);
+}
+
+static void copy(const char* src, size_t stride, size_t width, long npackets, char* dst) {
+	for(long i=0; i<npackets; i++, src += stride, dst += width)
+		memcpy(dst, src, width);
+}
+
+// copy and byte swap n elements of each packet
+template<class U>
+static U bswap(U v);
+
+template<>
+uint16_t bswap(uint16_t v) { return __builtin_bswap16(v); }
+
+template<>
+uint32_t bswap(uint32_t v) { return __builtin_bswap32(v); }
+
+template<>
+uint64_t bswap(uint64_t v) { return __builtin_bswap64(v); }
+
+template<class U>
+static void copySwap(const char* src, size_t stride, int n, long npackets, char* dst) {
+	U* out = (U*) dst;
+	for(long i=0; i<npackets; i++, src += stride) {
+		for(int j=0; j<n; j++) {
+			U v;
+			memcpy(&v, src + j * sizeof(U), sizeof(U));
+			*out++ = bswap(v);
+		}
+	}
+}
+
+void PacketDecoder::decodeColumn(const Column& c, const char* packets, long npackets, char* dst) const {
+	const char* src = packets + c.offset;
+	int n = c.width / c.elementSize;
+
+	if(c.swap) {
+		switch(c.elementSize) {
+			case 2: copySwap<uint16_t>(src, packetSize, n, npackets, dst); break;
+			case 4: copySwap<uint32_t>(src, packetSize, n, npackets, dst); break;
+			case 8: copySwap<uint64_t>(src, packetSize, n, npackets, dst); break;
+		}
+		return;
+	}
+
+	switch(c.width) {
+		case 1: copyFixed<1>(src, packetSize, npackets, dst); break;
+		case 2: copyFixed<2>(src, packetSize, npackets, dst); break;
+		case 4: copyFixed<4>(src, packetSize, npackets, dst); break;
+		case 8: copyFixed<8>(src, packetSize, npackets, dst); break;
+		default: copy(src, packetSize, c.width, npackets, dst); break;
+	}
+}
+
+void PacketDecoder::decode(const void* packets, long npackets, void* const* buffers) const {
+	if(fields.empty())
+		throw IOException("Error in PacketDecoder::decode() no layout loaded", 0);
+	if(npackets < 0)
+		throw IOException("Error in PacketDecoder::decode() ", 0);
+
+	// one column at a time, so the writes are sequential
+	for(unsigned int i=0; i<columns.size(); i++)
+		decodeColumn(columns[i], (const char*) packets, npackets, (char*) buffers[i]);
+}
+
+void PacketDecoder::decode(const void* packets, long npackets, TableAppender& appender) const {
+	if(fields.empty())
+		throw IOException("Error in PacketDecoder::decode() no layout loaded", 0);
+	if(npackets < 1)
+		return;
+
+	for(unsigned int i=0; i<columns.size(); i++)
+		decodeColumn(columns[i], (const char*) packets, npackets, appender.getRows(i, npackets));
+	appender.endRows(npackets);
+}
+
+}
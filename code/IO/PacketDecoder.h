@@ -0,0 +1,105 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_PACKETDECODER_H
+#define QL_IO_PACKETDECODER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "OutputFile.h"
+#include "TableAppender.h"
+
+namespace qlbase {
+
+/// Decode raw telemetry packets into columns. The packet layout is a type
+/// of a DDL written by fits2xml: the columns of the binaryTable, packed one
+/// after the other with no padding, after an optional header. The offset,
+/// size and byte swap of each column are computed once by load(), then
+/// decode() copies the columns of a batch of packets with a loop
+/// specialized on the element size.
+///
+/// \code
+/// PacketDecoder decoder;
+/// decoder.load("telemetry.xml", "EVENTS");
+/// file.createTable("EVENTS", decoder.getFields());
+/// TableAppender appender(file, decoder.getFields());
+/// decoder.decode(packets, npackets, appender);
+/// \endcode
+///
+/// All methods throw qlbase::IOException on errors.
+class PacketDecoder {
+
+public:
+
+	PacketDecoder();
+
+	/// Load the layout of a packet type from a DDL file.
+	/// \param[in] typeName The name of the type (the EXTNAME of the table).
+	void load(const std::string& filename, const std::string& typeName);
+
+	/// Load the layout of a packet type from the DDL text.
+	void loadString(const std::string& ddl, const std::string& typeName);
+
+	/// Set the byte order of the packets, big endian by default as FITS
+	/// and CCSDS.
+	void setBigEndian(bool bigEndian);
+
+	/// Set the bytes before the first column, e.g. a packet header.
+	void setHeaderSize(size_t bytes);
+
+	/// Set the distance between two packets, at least the header and the
+	/// columns. The default is the header and the columns.
+	void setPacketSize(size_t bytes);
+
+	/// Get the columns, as given to createTable().
+	const std::vector<field>& getFields() const { return fields; }
+
+	size_t getPacketSize() const { return packetSize; }
+
+	/// Decode npackets consecutive packets.
+	/// \param[in] packets npackets*getPacketSize() bytes.
+	/// \param[out] columns A buffer for each column, npackets*vsize values
+	/// of the column type in native byte order.
+	void decode(const void* packets, long npackets, void* const* columns) const;
+
+	/// Decode npackets consecutive packets as new rows of an appender of a
+	/// table created with getFields(), then commit them with endRows().
+	void decode(const void* packets, long npackets, TableAppender& appender) const;
+
+private:
+
+	/// The layout of a column in the packet.
+	struct Column {
+		size_t offset;
+		size_t elementSize;
+		/// Bytes of a row, elementSize*vsize.
+		size_t width;
+		bool swap;
+	};
+
+	std::vector<field> fields;
+	std::vector<Column> columns;
+	size_t headerSize;
+	size_t packetSize;
+	bool fixedPacketSize;
+	bool bigEndian;
+
+	void layout();
+	void decodeColumn(const Column& column, const char* packets, long npackets, char* dst) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,222 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <cstdio>
+#include <unistd.h>
+#include <sys/time.h>
+#include "RollingWriter.h"
+
+namespace qlbase {
+
+static double unixTime() {
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+RollingWriter::RollingWriter(const std::string& prefix, const std::string& tableName, const std::vector<field>& fields)
+	: prefix(prefix), tableName(tableName), fields(fields), rowWidth(0), maxRows(0), maxBytes(0), maxSeconds(0),
+	  current(0), next(0), index(0), fileRows(0), openTime(0) {
+
+	if(fields.empty())
+		throw IOException("Error in RollingWriter::RollingWriter() no fields", 0);
+
+	for(unsigned int i=0; i<fields.size(); i++)
+		if(fields[i].type == BIT)
+			rowWidth += (fields[i].vsize + 7) / 8;
+		else
+			rowWidth += getTypeSize(fields[i].type) * fields[i].vsize;
+}
+
+RollingWriter::~RollingWriter() {
+	try {
+		close();
+	}
+	catch(IOException& e) {
+	}
+
+	if(worker.joinable())
+		worker.join();
+	delete current;
+	delete next;
+}
+
+std::string RollingWriter::fileName(int number) {
+	char buff[16];
+	snprintf(buff, sizeof(buff), "_%06d.fits", number);
+	return prefix + buff;
+}
+
+OutputFileFITS* RollingWriter::createFile(int number) {
+	OutputFileFITS* file = new OutputFileFITS;
+	try {
+		file->create(fileName(number));
+		file->createTable(tableName, fields);
+		if(keywords.size())
+			file->writeKeywords(keywords);
+		if(maxRows > 0)
+			file->reserveRows(maxRows);
+	}
+	catch(IOException& e) {
+		if(file->isOpened()) {
+			try {
+				file->close();
+			}
+			catch(IOException& e2) {
+			}
+		}
+		delete file;
+		throw;
+	}
+	return file;
+}
+
+// Close a full file (the unused preallocated rows are removed) and add it
+// to the manifest.
+void RollingWriter::closeFile(OutputFileFITS* file, int number, long rows, double start) {
+	try {
+		file->close();
+	}
+	catch(IOException& e) {
+		delete file;
+		throw;
+	}
+	delete file;
+
+	std::string manifest = getManifestName();
+	bool header = access(manifest.c_str(), F_OK) != 0;
+	FILE* fp = fopen(manifest.c_str(), "a");
+	if(!fp)
+		throw IOException("Error in RollingWriter::closeFile() can't write the manifest " + manifest, 0);
+
+	if(header)
+		fprintf(fp, "file,rows,bytes,start,end\n");
+	fprintf(fp, "%s,%ld,%lld,%.3f,%.3f\n", fileName(number).c_str(), rows, (long long) rows * rowWidth,
+	        start, unixTime());
+	fclose(fp);
+}
+
+// Runs on the worker thread: close the full file, if any, then create the
+// next one.
+void RollingWriter::prepare(OutputFileFITS* full, int number, long rows, double start, int nextNumber) {
+	try {
+		if(full)
+			closeFile(full, number, rows, start);
+		next = createFile(nextNumber);
+	}
+	catch(IOException& e) {
+		error = e.what();
+	}
+}
+
+void RollingWriter::wait() {
+	if(worker.joinable())
+		worker.join();
+
+	if(!error.empty()) {
+		std::string msg = error;
+		error.clear();
+		throw IOException(msg, 0);
+	}
+}
+
+void RollingWriter::open() {
+	if(current)
+		throw IOException("Error in RollingWriter::open() already opened", 0);
+
+	index = 0;
+	fileRows = 0;
+	current = createFile(index);
+	openTime = unixTime();
+
+	worker = std::thread(&RollingWriter::prepare, this, (OutputFileFITS*) 0, 0, 0L, 0.0, index + 1);
+}
+
+void RollingWriter::writeString(int ncol, std::vector< std::vector<char> >& buff, long nrows) {
+	if(!current || nrows < 1)
+		throw IOException("Error in RollingWriter::writeString() ", 0);
+
+	current->writeString(ncol, buff, fileRows, fileRows + nrows - 1);
+}
+
+void RollingWriter::endRows(long nrows) {
+	if(!current || nrows < 1)
+		throw IOException("Error in RollingWriter::endRows() ", 0);
+
+	fileRows += nrows;
+
+	bool full = (maxRows > 0 && fileRows >= maxRows)
+	         || (maxBytes > 0 && (int64_t) fileRows * rowWidth >= maxBytes)
+	         || (maxSeconds > 0 && unixTime() - openTime >= maxSeconds);
+	if(full)
+		rotate();
+}
+
+void RollingWriter::rotate() {
+	if(!current)
+		throw IOException("Error in RollingWriter::rotate() ", 0);
+
+	// the next file is usually ready. If the worker failed, it is created
+	// here, the current file is kept when that fails too.
+	wait();
+	if(!next)
+		next = createFile(index + 1);
+
+	OutputFileFITS* full = current;
+	long rows = fileRows;
+	double start = openTime;
+
+	current = next;
+	next = 0;
+	index++;
+	fileRows = 0;
+	openTime = unixTime();
+
+	worker = std::thread(&RollingWriter::prepare, this, full, index - 1, rows, start, index + 1);
+}
+
+void RollingWriter::close() {
+	if(!current)
+		return;
+
+	// the errors of the worker come after the current file is closed
+	std::string workerError;
+	try {
+		wait();
+	}
+	catch(IOException& e) {
+		workerError = e.what();
+	}
+
+	if(next) {
+		std::string unused = fileName(index + 1);
+		try {
+			next->close();
+		}
+		catch(IOException& e) {
+		}
+		delete next;
+		next = 0;
+		unlink(unused.c_str());
+	}
+
+	OutputFileFITS* last = current;
+	current = 0;
+	closeFile(last, index, fileRows, openTime);
+
+	if(!workerError.empty())
+		throw IOException(workerError, 0);
+}
+
+}
@@ -0,0 +1,154 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_ROLLINGWRITER_H
+#define QL_IO_ROLLINGWRITER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include "OutputFileFITS.h"
+#include "KeywordBatch.h"
+
+namespace qlbase {
+
+/// Write a table split into files of bounded rows, size or duration, named
+/// prefix_000000.fits, prefix_000001.fits, ... The next file, with its table
+/// and keywords, is created by a background thread while the current one is
+/// written, and the full file is closed in background too, so rotating is a
+/// pointer swap. The rows are written in blocks: write the columns of the
+/// block, then commit it with endRows(). The limits are checked after each
+/// block, so a file can exceed them by less than a block.
+///
+/// Each closed file is appended to the manifest prefix.manifest, a CSV file
+/// with the file name, rows, data bytes and the open and close times (Unix
+/// seconds).
+///
+/// cfitsio must be built reentrant (the default with pthreads) to work on
+/// different files from different threads.
+/// All methods throw qlbase::IOException on errors, including the ones of the
+/// background thread.
+class RollingWriter {
+
+public:
+
+	/// \param[in] prefix The file names prefix, may include a directory.
+	/// \param[in] tableName The table name (EXTNAME).
+	/// \param[in] fields The table fields.
+	RollingWriter(const std::string& prefix, const std::string& tableName, const std::vector<field>& fields);
+
+	/// Close the files, ignoring the errors.
+	~RollingWriter();
+
+	/// Rotate when a file has this many rows. With a row limit the rows
+	/// of the next files are preallocated in background. 0 disables it.
+	void setMaxRows(long rows) { maxRows = rows; }
+
+	/// Rotate when the data of a file is this big. 0 disables it.
+	void setMaxBytes(int64_t bytes) { maxBytes = bytes; }
+
+	/// Rotate when a file has been open for this many seconds. 0 disables it.
+	void setMaxSeconds(double seconds) { maxSeconds = seconds; }
+
+	/// Keywords written in the table header of each file. The settings
+	/// must not change after open().
+	void setKeywords(const KeywordBatch& keywords) { this->keywords = keywords; }
+
+	/// Create the first file and start creating the next one.
+	void open();
+
+	/// Write nrows rows of a column (vsize values each) in the current
+	/// block, with the types of the OutputFile writes (uint8_t, int16_t,
+	/// int32_t, int64_t, float or double).
+	template<class T>
+	void write(int ncol, const T* buff, long nrows, int vsize = 1);
+
+	void writeString(int ncol, std::vector< std::vector<char> >& buff, long nrows);
+
+	/// Commit the block of nrows rows, rotating if a limit was reached.
+	void endRows(long nrows);
+
+	/// Switch to the next file. After an error of the background thread
+	/// the writer stays on the current file, and the next rotate() creates
+	/// the next file if still missing.
+	void rotate();
+
+	/// Close the current file and remove the unused next one.
+	void close();
+
+	bool isOpened() { return current != 0; }
+
+	/// Get the name of the current file.
+	std::string getFileName() { return fileName(index); }
+
+	/// Get the number of the current file (starting from 0).
+	int getFileNum() { return index; }
+
+	/// Get the number of rows committed in the current file.
+	long getFileRows() { return fileRows; }
+
+	std::string getManifestName() { return prefix + ".manifest"; }
+
+private:
+
+	RollingWriter(const RollingWriter&);
+	RollingWriter& operator=(const RollingWriter&);
+
+	std::string prefix;
+	std::string tableName;
+	std::vector<field> fields;
+	KeywordBatch keywords;
+	long rowWidth;
+
+	long maxRows;
+	int64_t maxBytes;
+	double maxSeconds;
+
+	/// The file being written and the one created in background.
+	OutputFileFITS* current;
+	OutputFileFITS* next;
+	int index;
+	long fileRows;
+	double openTime;
+
+	/// The background thread and its error.
+	std::thread worker;
+	std::string error;
+
+	std::string fileName(int number);
+	OutputFileFITS* createFile(int number);
+	void closeFile(OutputFileFITS* file, int number, long rows, double start);
+	void prepare(OutputFileFITS* full, int number, long rows, double start, int nextNumber);
+	void wait();
+
+	static void writeColumn(OutputFileFITS& f, int ncol, const uint8_t* b, long fr, long lr, int vs) { f.writeu8iv(ncol, b, fr, lr, vs); }
+	static void writeColumn(OutputFileFITS& f, int ncol, const int16_t* b, long fr, long lr, int vs) { f.write16iv(ncol, b, fr, lr, vs); }
+	static void writeColumn(OutputFileFITS& f, int ncol, const int32_t* b, long fr, long lr, int vs) { f.write32iv(ncol, b, fr, lr, vs); }
+	static void writeColumn(OutputFileFITS& f, int ncol, const int64_t* b, long fr, long lr, int vs) { f.write64iv(ncol, b, fr, lr, vs); }
+	static void writeColumn(OutputFileFITS& f, int ncol, const float* b, long fr, long lr, int vs) { f.write32fv(ncol, b, fr, lr, vs); }
+	static void writeColumn(OutputFileFITS& f, int ncol, const double* b, long fr, long lr, int vs) { f.write64fv(ncol, b, fr, lr, vs); }
+};
+
+template<class T>
+void RollingWriter::write(int ncol, const T* buff, long nrows, int vsize) {
+	if(!current || nrows < 1)
+		throw IOException("Error in RollingWriter::write() ", 0);
+
+	writeColumn(*current, ncol, buff, fileRows, fileRows + nrows - 1, vsize);
+}
+
+}
+
+#endif
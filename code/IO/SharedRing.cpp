@@ -0,0 +1,260 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <cstring>
+#include <cerrno>
+#include <new>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "SharedRing.h"
+
+namespace qlbase {
+
+#define MAGIC "QLRING1"
+#define NAMESIZE 72
+#define MAXCOLUMNS 999
+
+/// The column rings are aligned to the cache lines, so the writer and the
+/// readers of different columns don't share lines.
+#define ALIGNMENT 64
+
+struct SegmentField {
+	char name[NAMESIZE];
+	char unit[NAMESIZE];
+	int32_t type;
+	int32_t vsize;
+};
+
+/// The segment starts with this header, followed by the fields and the
+/// column rings.
+struct SharedRing::Segment {
+	char magic[8];
+	uint64_t size;
+	uint64_t capacity;
+	uint32_t ncols;
+	char tableName[NAMESIZE];
+
+	/// Set last by the writer, when the segment is initialized.
+	std::atomic<uint32_t> ready;
+	std::atomic<uint32_t> closed;
+	std::atomic<uint64_t> reserved;
+	std::atomic<uint64_t> committed;
+};
+
+static size_t align(size_t n) {
+	return (n + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+static void copyName(char* dst, const std::string& src) {
+	strncpy(dst, src.c_str(), NAMESIZE - 1);
+	dst[NAMESIZE - 1] = 0;
+}
+
+SharedRing::SharedRing() : owner(false), header(0), base(0), size(0), capacity(0) {
+}
+
+SharedRing::~SharedRing() {
+	try {
+		detach();
+	}
+	catch(IOException& e) {
+	}
+}
+
+std::string SharedRing::segmentName(const std::string& name) {
+	if(name.empty())
+		throw IOException("Error in SharedRing: empty segment name", 0);
+	return name[0] == '/' ? name : "/" + name;
+}
+
+// Compute the offsets of the column rings after the header and the fields.
+void SharedRing::layout() {
+	columns.resize(fields.size());
+	size_t offset = align(sizeof(Segment) + fields.size() * sizeof(SegmentField));
+	for(unsigned int i=0; i<fields.size(); i++) {
+		columns[i].elementSize = getTypeSize(fields[i].type);
+		columns[i].width = (size_t) columns[i].elementSize * fields[i].vsize;
+		columns[i].offset = offset;
+		offset = align(offset + columns[i].width * capacity);
+	}
+	size = offset;
+}
+
+void SharedRing::create(const std::string& name, const std::string& tableName, const std::vector<field>& fields, long capacity) {
+	if(header)
+		throw IOException("Error in SharedRing::create() already attached", 0);
+	if(fields.empty() || fields.size() > MAXCOLUMNS || capacity < 1)
+		throw IOException("Error in SharedRing::create() invalid table", 0);
+	for(unsigned int i=0; i<fields.size(); i++)
+		if(fields[i].vsize < 1 || fields[i].type > STRING)
+			throw IOException("Error in SharedRing::create() invalid type or size of " + fields[i].name, 0);
+
+	this->name = segmentName(name);
+	this->tableName = tableName;
+	this->fields = fields;
+	this->capacity = capacity;
+	layout();
+
+	// a segment left by a writer that crashed is replaced, the readers
+	// still attached to it are not affected
+	shm_unlink(this->name.c_str());
+	int fd = shm_open(this->name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+	if(fd < 0)
+		throw IOException("Error in SharedRing::create() can't create " + this->name + ": " + strerror(errno), errno);
+
+	if(ftruncate(fd, size) != 0) {
+		int err = errno;
+		::close(fd);
+		shm_unlink(this->name.c_str());
+		throw IOException("Error in SharedRing::create() can't resize " + this->name + ": " + strerror(err), err);
+	}
+
+	void* addr = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if(addr == MAP_FAILED) {
+		int err = errno;
+		shm_unlink(this->name.c_str());
+		throw IOException("Error in SharedRing::create() can't map " + this->name + ": " + strerror(err), err);
+	}
+
+	owner = true;
+	base = (char*) addr;
+	header = new(addr) Segment;
+	if(!header->committed.is_lock_free()) {
+		detach();
+		throw IOException("Error in SharedRing::create() no lock free atomics", 0);
+	}
+
+	memcpy(header->magic, MAGIC, sizeof(header->magic));
+	header->size = size;
+	header->capacity = capacity;
+	header->ncols = fields.size();
+	copyName(header->tableName, tableName);
+	header->closed.store(0);
+	header->reserved.store(0);
+	header->committed.store(0);
+
+	SegmentField* segmentFields = (SegmentField*) (base + sizeof(Segment));
+	for(unsigned int i=0; i<fields.size(); i++) {
+		copyName(segmentFields[i].name, fields[i].name);
+		copyName(segmentFields[i].unit, fields[i].unit);
+		segmentFields[i].type = fields[i].type;
+		segmentFields[i].vsize = fields[i].vsize;
+	}
+
+	header->ready.store(1, std::memory_order_release);
+}
+
+void SharedRing::attach(const std::string& name) {
+	if(header)
+		throw IOException("Error in SharedRing::attach() already attached", 0);
+
+	this->name = segmentName(name);
+	int fd = shm_open(this->name.c_str(), O_RDONLY, 0);
+	if(fd < 0)
+		throw IOException("Error in SharedRing::attach() can't open " + this->name + ": " + strerror(errno), errno);
+
+	struct stat st;
+	if(fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(Segment)) {
+		::close(fd);
+		throw IOException("Error in SharedRing::attach() segment not ready " + this->name, 0);
+	}
+
+	size = st.st_size;
+	void* addr = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if(addr == MAP_FAILED)
+		throw IOException("Error in SharedRing::attach() can't map " + this->name + ": " + strerror(errno), errno);
+
+	owner = false;
+	base = (char*) addr;
+	header = (Segment*) addr;
+
+	if(!header->ready.load(std::memory_order_acquire) || memcmp(header->magic, MAGIC, sizeof(header->magic))
+	   || header->size != size || header->capacity < 1 || header->ncols < 1 || header->ncols > MAXCOLUMNS
+	   || size < sizeof(Segment) + header->ncols * sizeof(SegmentField)) {
+		detach();
+		throw IOException("Error in SharedRing::attach() not a table segment " + this->name, 0);
+	}
+
+	tableName = header->tableName;
+	capacity = header->capacity;
+	fields.resize(header->ncols);
+	const SegmentField* segmentFields = (const SegmentField*) (base + sizeof(Segment));
+	for(unsigned int i=0; i<fields.size(); i++) {
+		fields[i].name = segmentFields[i].name;
+		fields[i].unit = segmentFields[i].unit;
+		fields[i].type = (fieldType) segmentFields[i].type;
+		fields[i].vsize = segmentFields[i].vsize;
+		if(fields[i].type < UNSIGNED_INT8 || fields[i].type > STRING || fields[i].vsize < 1) {
+			detach();
+			throw IOException("Error in SharedRing::attach() corrupted segment " + this->name, 0);
+		}
+	}
+
+	size_t mapped = size;
+	layout();
+	if(size != mapped) {
+		size = mapped;
+		detach();
+		throw IOException("Error in SharedRing::attach() corrupted segment " + this->name, 0);
+	}
+}
+
+void SharedRing::detach() {
+	if(!header)
+		return;
+
+	munmap(base, size);
+	header = 0;
+	base = 0;
+
+	if(owner) {
+		owner = false;
+		if(shm_unlink(name.c_str()) != 0)
+			throw IOException("Error in SharedRing::detach() can't remove " + name + ": " + strerror(errno), errno);
+	}
+}
+
+long SharedRing::getCommitted() {
+	return header->committed.load(std::memory_order_acquire);
+}
+
+long SharedRing::getReserved() {
+	// the values read before must not be read after this load
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return header->reserved.load(std::memory_order_relaxed);
+}
+
+void SharedRing::reserve(long nrows) {
+	// the new reservation must be visible before the values are overwritten
+	header->reserved.store(nrows, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+void SharedRing::commit(long nrows) {
+	header->committed.store(nrows, std::memory_order_release);
+}
+
+bool SharedRing::isClosed() {
+	return header->closed.load(std::memory_order_acquire) != 0;
+}
+
+void SharedRing::setClosed() {
+	header->closed.store(1, std::memory_order_release);
+}
+
+}
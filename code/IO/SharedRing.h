@@ -0,0 +1,131 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_SHAREDRING_H
+#define QL_IO_SHAREDRING_H
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "OutputFile.h"
+
+namespace qlbase {
+
+/// A table in a POSIX shared memory segment, written as a ring by one
+/// process (OutputFileSHM) and read by others (InputFileSHM).
+/// Rows are numbered from the start of the table, row r is in the slot
+/// r % capacity. Each column has its own ring of capacity values, cache line
+/// aligned, so the rows of a column are contiguous unless they wrap.
+///
+/// The writer announces the rows it is going to write (reserved rows)
+/// before writing them, and publishes them (committed rows) after, with
+/// atomic counters in the segment. Readers take no locks and make no system
+/// calls, and check after a copy that the writer didn't overwrite the rows
+/// meanwhile: the rows before reserved - capacity are lost.
+///
+/// All methods throw qlbase::IOException on errors.
+class SharedRing {
+
+public:
+
+	SharedRing();
+
+	/// Detach, ignoring the errors.
+	~SharedRing();
+
+	/// Create the segment (replacing an old one with the same name) and map
+	/// it for writing.
+	/// \param[in] name The segment name, a leading '/' is added if missing.
+	/// \param[in] tableName The table name.
+	/// \param[in] fields The table fields.
+	/// \param[in] capacity The rows of the ring.
+	void create(const std::string& name, const std::string& tableName, const std::vector<field>& fields, long capacity);
+
+	/// Map an existing segment for reading.
+	void attach(const std::string& name);
+
+	/// Unmap the segment, and remove it if created by this object. The
+	/// readers already attached keep their mapping.
+	void detach();
+
+	bool isAttached() { return header != 0; }
+
+	const std::string& getTableName() { return tableName; }
+	const std::vector<field>& getFields() { return fields; }
+	long getCapacity() { return capacity; }
+
+	/// Get the size of a value of a column.
+	int getElementSize(int ncol) { return columns[ncol].elementSize; }
+
+	/// Get the address of a row of a column.
+	char* getSlot(int ncol, long row) {
+		const Column& c = columns[ncol];
+		return base + c.offset + (row % capacity) * c.width;
+	}
+
+	/// Rows published by the writer.
+	long getCommitted();
+
+	/// Rows the writer may be writing (committed ones included).
+	long getReserved();
+
+	/// Announce the writer is going to write the rows up to nrows - 1.
+	void reserve(long nrows);
+
+	/// Publish the rows up to nrows - 1.
+	void commit(long nrows);
+
+	/// Set by the writer when it has finished.
+	bool isClosed();
+	void setClosed();
+
+	/// Get the number of the first row that can still be read.
+	long getFirstRow() {
+		long first = getReserved() - capacity;
+		return first > 0 ? first : 0;
+	}
+
+private:
+
+	struct Segment;
+
+	struct Column {
+		int elementSize;
+		/// Bytes of a row and offset of the ring from the segment start.
+		size_t width;
+		size_t offset;
+	};
+
+	SharedRing(const SharedRing&);
+	SharedRing& operator=(const SharedRing&);
+
+	std::string name;
+	bool owner;
+	Segment* header;
+	char* base;
+	size_t size;
+
+	std::string tableName;
+	std::vector<field> fields;
+	std::vector<Column> columns;
+	long capacity;
+
+	static std::string segmentName(const std::string& name);
+	void layout();
+};
+
+}
+
+#endif
@@ -0,0 +1,91 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_STRINGCOLUMN_H
+#define QL_IO_STRINGCOLUMN_H
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace qlbase {
+
+/// The rows of a fixed width string column in one buffer. Each row takes
+/// width + 1 bytes: the string, padded with '\0', and a terminator, so a row
+/// is a C string of at most width characters and cfitsio can read and write
+/// all the rows in place.
+///
+/// \code
+/// StringColumn labels;
+/// file.readString(2, frow, lrow, labels);
+/// for(long i=0; i<labels.size(); i++)
+///     std::cout << labels[i] << std::endl;
+/// \endcode
+class StringColumn {
+
+public:
+
+	StringColumn() : nrows(0), width(0) {}
+
+	StringColumn(long nrows, int width) : nrows(0), width(0) {
+		resize(nrows, width);
+	}
+
+	/// Set the number of rows and the width, the rows become empty. The
+	/// buffer is reallocated only when it grows.
+	void resize(long nrows, int width) {
+		this->nrows = nrows;
+		this->width = width;
+		buffer.assign(nrows * (width + 1), 0);
+	}
+
+	/// Get the number of rows.
+	long size() const { return nrows; }
+
+	/// Get the maximum length of a string.
+	int getWidth() const { return width; }
+
+	/// Get a row, a null terminated string.
+	const char* operator[](long row) const { return &buffer[row * (width + 1)]; }
+
+	/// Get a row to be written in place, up to getWidth() characters.
+	char* operator[](long row) { return &buffer[row * (width + 1)]; }
+
+	/// Get the length of a row.
+	size_t length(long row) const { return strnlen((*this)[row], width); }
+
+	/// Set a row, truncated to the width.
+	void set(long row, const char* value, size_t size) {
+		char* dst = (*this)[row];
+		size_t n = size < (size_t) width ? size : width;
+		memcpy(dst, value, n);
+		memset(dst + n, 0, width + 1 - n);
+	}
+
+	void set(long row, const std::string& value) { set(row, value.data(), value.size()); }
+
+	/// Get all the rows, getWidth() + 1 bytes each.
+	char* data() { return buffer.empty() ? 0 : &buffer[0]; }
+	const char* data() const { return buffer.empty() ? 0 : &buffer[0]; }
+
+private:
+
+	std::vector<char> buffer;
+	long nrows;
+	int width;
+};
+
+}
+
+#endif
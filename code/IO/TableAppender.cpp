@@ -0,0 +1,345 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <cstring>
+#include <algorithm>
+#include "TableAppender.h"
+#include "mac_clock_gettime.h"
+
+namespace qlbase {
+
+TableAppender::TableAppender(OutputFileFITS& file, const std::vector<field>& fields, long blockRows)
+	: file(file), blockRows(blockRows), flushms(0), pending(0), used(0), pendingSince(0), active(0),
+	  async(false), stopping(false), maxBlocks(0), policy(BLOCK), inFlight(0) {
+
+	if(fields.empty())
+		throw IOException("Error in TableAppender::TableAppender() no fields", 0);
+
+	fileRows = file.getNRows();
+	if(this->blockRows <= 0)
+		this->blockRows = std::max(file.getOptimalRows(), 1L);
+
+	columns.resize(fields.size());
+	for(unsigned int i=0; i<fields.size(); i++) {
+		if(fields[i].vsize < 1)
+			throw IOException("Error in TableAppender::TableAppender() vsize < 1", 0);
+		if(fields[i].type > STRING)
+			throw IOException("Error in TableAppender::TableAppender() bit and logical columns are not supported", 0);
+
+		columns[i].type = fields[i].type;
+		columns[i].vsize = fields[i].vsize;
+		columns[i].width = getTypeSize(fields[i].type) * fields[i].vsize;
+	}
+
+	memset(&stats, 0, sizeof(stats));
+	active = newBlock();
+}
+
+TableAppender::~TableAppender() {
+	try {
+		if(async)
+			stopAsync();
+		else
+			flush();
+	}
+	catch(IOException& e) {
+	}
+
+	// the writer could be still running after an error
+	if(writer.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		cond.notify_all();
+		writer.join();
+	}
+
+	for(unsigned int i=0; i<blocks.size(); i++)
+		delete blocks[i];
+}
+
+TableAppender::Block* TableAppender::newBlock() {
+	Block* block = new Block;
+	block->data.resize(columns.size());
+	for(unsigned int i=0; i<columns.size(); i++)
+		block->data[i].assign(blockRows * columns[i].width, 0);
+	block->frow = 0;
+	block->nrows = 0;
+	block->used = 0;
+	blocks.push_back(block);
+	return block;
+}
+
+char* TableAppender::element(int ncol, long row, long nrows) {
+	if(ncol < 0 || ncol >= (int) columns.size() || row < 0 || nrows < 1)
+		throw IOException("Error in TableAppender::set() ", 0);
+
+	// batches bigger than the block enlarge the buffers
+	long end = pending + row + nrows;
+	if(end * columns[0].width > active->data[0].size()) {
+		for(unsigned int i=0; i<columns.size(); i++)
+			active->data[i].resize(end * columns[i].width, 0);
+	}
+	used = std::max(used, end);
+
+	return &active->data[ncol][(pending + row) * columns[ncol].width];
+}
+
+void TableAppender::set(int ncol, const std::string& value, long row) {
+	char* dst = element(ncol, row, 1);
+	const Column& c = columns[ncol];
+	if(c.type != STRING)
+		throw IOException("Error in TableAppender::set() string in a number column", 0);
+
+	size_t size = std::min(value.size(), c.width);
+	memcpy(dst, value.c_str(), size);
+	memset(dst + size, 0, c.width - size);
+}
+
+void TableAppender::endRows(long nrows) {
+	if(nrows < 1)
+		throw IOException("Error in TableAppender::endRows() ", 0);
+
+	element(0, 0, nrows);
+	if(pending == 0)
+		pendingSince = gettimensec();
+	pending += nrows;
+
+	if(pending >= blockRows)
+		flush();
+	else
+		poll();
+}
+
+bool TableAppender::poll() {
+	if(pending == 0 || flushms <= 0)
+		return false;
+
+	if((gettimensec() - pendingSince) / 1000000L < flushms)
+		return false;
+
+	flush();
+	return true;
+}
+
+void TableAppender::clearRows(Block* block, long frow, long lrow) {
+	for(unsigned int i=0; i<columns.size(); i++) {
+		size_t width = columns[i].width;
+		memset(&block->data[i][frow * width], 0, (lrow - frow + 1) * width);
+	}
+}
+
+// Values already set for the rows after the pending ones move to the
+// start of a block (possibly the same one).
+void TableAppender::carryRows(Block* from, Block* to) {
+	long ahead = used - pending;
+	if(ahead <= 0)
+		return;
+
+	for(unsigned int i=0; i<columns.size(); i++) {
+		size_t width = columns[i].width;
+		if(to->data[i].size() < ahead * width)
+			to->data[i].resize(ahead * width, 0);
+		memmove(&to->data[i][0], &from->data[i][pending * width], ahead * width);
+	}
+}
+
+void TableAppender::writeBlock(Block* block) {
+	long frow = block->frow;
+	long lrow = block->frow + block->nrows - 1;
+	for(unsigned int i=0; i<columns.size(); i++) {
+		const Column& c = columns[i];
+		const char* data = &block->data[i][0];
+		switch(c.type) {
+			case UNSIGNED_INT8: file.writeu8iv(i, (const uint8_t*) data, frow, lrow, c.vsize); break;
+			case INT16: file.write16iv(i, (const int16_t*) data, frow, lrow, c.vsize); break;
+			case INT32: file.write32iv(i, (const int32_t*) data, frow, lrow, c.vsize); break;
+			case INT64: file.write64iv(i, (const int64_t*) data, frow, lrow, c.vsize); break;
+			case FLOAT: file.write32fv(i, (const float*) data, frow, lrow, c.vsize); break;
+			case DOUBLE: file.write64fv(i, (const double*) data, frow, lrow, c.vsize); break;
+			case STRING: {
+				StringColumn strings(block->nrows, c.width);
+				for(long row=0; row<block->nrows; row++)
+					strings.set(row, data + row * c.width, c.width);
+				file.writeString(i, strings, frow);
+				break;
+			}
+			default:
+				break;
+		}
+	}
+}
+
+void TableAppender::flush() {
+	if(pending == 0)
+		return;
+
+	active->frow = fileRows;
+	active->nrows = pending;
+
+	if(!async) {
+		writeBlock(active);
+		carryRows(active, active);
+		clearRows(active, used - pending, used - 1);
+	}
+	else {
+		std::unique_lock<std::mutex> lock(mutex);
+		checkError();
+
+		if(inFlight >= maxBlocks && policy == DROP) {
+			stats.droppedBlocks++;
+			stats.droppedRows += pending;
+			lock.unlock();
+
+			carryRows(active, active);
+			clearRows(active, used - pending, used - 1);
+			used -= pending;
+			pending = 0;
+			return;
+		}
+
+		if(inFlight >= maxBlocks) {
+			long start = gettimensec();
+			while(inFlight >= maxBlocks && error.empty())
+				cond.wait(lock);
+			stats.producerWaits++;
+			stats.producerWaitTime += gettimensec() - start;
+			checkError();
+		}
+
+		Block* next;
+		if(freeBlocks.size()) {
+			next = freeBlocks.back();
+			freeBlocks.pop_back();
+		}
+		else
+			next = newBlock();
+
+		// the writer clears the block after writing it
+		carryRows(active, next);
+		active->used = used;
+		queue.push_back(active);
+		inFlight++;
+		stats.queueDepth = inFlight;
+		stats.queueDepthMax = std::max(stats.queueDepthMax, inFlight);
+		active = next;
+
+		lock.unlock();
+		cond.notify_all();
+	}
+
+	fileRows += pending;
+	used -= pending;
+	pending = 0;
+}
+
+void TableAppender::startAsync(int maxBlocks, Backpressure policy) {
+	if(async || maxBlocks < 1)
+		throw IOException("Error in TableAppender::startAsync() ", 0);
+
+	flush();
+
+	this->maxBlocks = maxBlocks;
+	this->policy = policy;
+	stopping = false;
+	error.clear();
+	async = true;
+	writer = std::thread(&TableAppender::run, this);
+}
+
+void TableAppender::stopAsync() {
+	if(!async)
+		throw IOException("Error in TableAppender::stopAsync() ", 0);
+
+	try {
+		flush();
+	}
+	catch(IOException& e) {
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	cond.notify_all();
+	writer.join();
+	async = false;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	checkError();
+}
+
+void TableAppender::sync() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while(inFlight > 0 && error.empty())
+		cond.wait(lock);
+	checkError();
+}
+
+TableAppender::Stats TableAppender::getStats() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+// Called with the mutex locked.
+void TableAppender::checkError() {
+	if(!error.empty())
+		throw IOException(error, 0);
+}
+
+void TableAppender::run() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while(true) {
+		while(queue.empty() && !stopping)
+			cond.wait(lock);
+		if(queue.empty())
+			break;
+
+		Block* block = queue.front();
+		queue.pop_front();
+		bool failed = !error.empty();
+		lock.unlock();
+
+		// after an error the next blocks are discarded
+		long start = gettimensec();
+		std::string msg;
+		if(!failed) {
+			try {
+				writeBlock(block);
+			}
+			catch(IOException& e) {
+				msg = e.what();
+			}
+		}
+		long elapsed = gettimensec() - start;
+		clearRows(block, 0, block->used - 1);
+
+		lock.lock();
+		if(!msg.empty())
+			error = msg;
+		else if(!failed) {
+			stats.writtenBlocks++;
+			stats.writtenRows += block->nrows;
+			stats.writeTimeTotal += elapsed;
+			stats.writeTimeMax = std::max(stats.writeTimeMax, elapsed);
+		}
+		inFlight--;
+		stats.queueDepth = inFlight;
+		freeBlocks.push_back(block);
+		cond.notify_all();
+	}
+}
+
+}
@@ -0,0 +1,228 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_TABLEAPPENDER_H
+#define QL_IO_TABLEAPPENDER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "OutputFileFITS.h"
+
+namespace qlbase {
+
+/// Append rows to the current table of an OutputFileFITS.
+/// Rows are accumulated column-wise in preallocated buffers and written in
+/// blocks, one fits_write_col call for each column, instead of a few rows at
+/// a time. Values are set on the rows being filled, then committed with
+/// endRows(). Values are converted to the column types.
+///
+/// \code
+/// TableAppender appender(file, fields);
+/// appender.set(0, time);
+/// appender.set(1, counts);   // a vector column, vsize values
+/// appender.endRows();
+/// \endcode
+///
+/// In asynchronous mode (startAsync()) full blocks are written by a writer
+/// thread while the producer fills the next one. The file must not be used
+/// by other threads until stopAsync().
+///
+/// All methods throw qlbase::IOException on errors.
+class TableAppender {
+
+public:
+
+	/// What flush() does when all the asynchronous blocks are in flight.
+	enum Backpressure {
+		/// Wait for the writer thread.
+		BLOCK,
+		/// Drop the block, counting the dropped rows.
+		DROP
+	};
+
+	/// Statistics of the asynchronous writes (times in ns).
+	struct Stats {
+		long writtenBlocks;
+		long writtenRows;
+		long droppedBlocks;
+		long droppedRows;
+		long writeTimeTotal;
+		long writeTimeMax;
+		/// Blocks queued or being written, now and at most.
+		int queueDepth;
+		int queueDepthMax;
+		/// Times the producer waited for a free block, and for how long.
+		long producerWaits;
+		long producerWaitTime;
+	};
+
+	/// \param[in] file The file, moved to the table to append.
+	/// \param[in] fields The table fields, as given to createTable().
+	/// \param[in] blockRows Rows written at once, 0 for the cfitsio optimal
+	/// number of rows (fits_get_rowsize).
+	TableAppender(OutputFileFITS& file, const std::vector<field>& fields, long blockRows = 0);
+
+	/// Flush the pending rows and stop the writer thread. Errors are
+	/// ignored, call flush() or stopAsync() to get them.
+	~TableAppender();
+
+	/// Start writing the blocks with a writer thread.
+	/// \param[in] maxBlocks Maximum number of blocks in flight (queued or
+	/// being written), besides the one being filled.
+	/// \param[in] policy What to do when maxBlocks blocks are in flight.
+	void startAsync(int maxBlocks = 1, Backpressure policy = BLOCK);
+
+	/// Flush, wait for the writer thread to write all the blocks and stop it.
+	void stopAsync();
+
+	/// Wait for the writer thread to write all the flushed blocks.
+	void sync();
+
+	/// Get the asynchronous writes statistics.
+	Stats getStats();
+
+	/// Flush the pending rows when they are older than ms milliseconds,
+	/// checked by endRows() and poll(). 0 disables the time-based flush.
+	void setFlushInterval(int ms) { flushms = ms; }
+
+	/// Set a value of the current row, or of the next ones.
+	/// \param[in] ncol Column number (starting from 0).
+	/// \param[in] row The row after the current one (0 for the current row).
+	template<class T>
+	void set(int ncol, T value, long row = 0);
+
+	/// Set the vsize values of a vector column.
+	template<class T>
+	void set(int ncol, T* values, long row = 0);
+
+	/// Set a string, truncated or padded to the column size.
+	void set(int ncol, const std::string& value, long row = 0);
+	void set(int ncol, const char* value, long row = 0) { set(ncol, std::string(value), row); }
+
+	/// Set a column for a batch of nrows rows, starting from the current one.
+	/// \param[in] values nrows*vsize values, row after row.
+	template<class T>
+	void setRows(int ncol, const T* values, long nrows);
+
+	/// Get the buffer of a column for nrows rows starting from the current
+	/// one, to be filled in place with nrows*vsize values of the column
+	/// type, in native byte order.
+	char* getRows(int ncol, long nrows) { return element(ncol, 0, nrows); }
+
+	/// Commit nrows rows, the next row becomes the current one. The block
+	/// is written when full or when the flush interval elapsed.
+	void endRows(long nrows = 1);
+
+	/// Write the committed rows, or pass them to the writer thread.
+	void flush();
+
+	/// Flush if the flush interval elapsed, for idle producers.
+	/// \return true if rows were written.
+	bool poll();
+
+	/// Get the number of rows of the table, pending rows included.
+	long getNRows() { return fileRows + pending; }
+
+	/// Get the number of rows written at once.
+	long getBlockRows() { return blockRows; }
+
+private:
+
+	struct Column {
+		fieldType type;
+		int vsize;
+		size_t width;
+	};
+
+	/// The column buffers of a block of rows.
+	struct Block {
+		std::vector< std::vector<char> > data;
+		long frow;
+		long nrows;
+		/// Rows with values set, to be cleared after the write.
+		long used;
+	};
+
+	TableAppender(const TableAppender&);
+	TableAppender& operator=(const TableAppender&);
+
+	OutputFileFITS& file;
+	std::vector<Column> columns;
+	long blockRows;
+	int flushms;
+
+	/// Rows in the file (or passed to the writer) and committed rows.
+	long fileRows;
+	long pending;
+
+	/// Rows with values set in the active block, committed or not.
+	long used;
+
+	/// Time of the first pending row.
+	long pendingSince;
+
+	/// The block being filled, and all the blocks.
+	Block* active;
+	std::vector<Block*> blocks;
+
+	/// Asynchronous mode, guarded by mutex.
+	std::thread writer;
+	std::mutex mutex;
+	std::condition_variable cond;
+	bool async;
+	bool stopping;
+	int maxBlocks;
+	Backpressure policy;
+	int inFlight;
+	std::deque<Block*> queue;
+	std::vector<Block*> freeBlocks;
+	std::string error;
+	Stats stats;
+
+	Block* newBlock();
+	void carryRows(Block* from, Block* to);
+	void clearRows(Block* block, long frow, long lrow);
+	void writeBlock(Block* block);
+	void run();
+	void checkError();
+
+	char* element(int ncol, long row, long nrows);
+};
+
+template<class T>
+void TableAppender::set(int ncol, T value, long row) {
+	char* dst = element(ncol, row, 1);
+	storeAs(columns[ncol].type, dst, &value, 1);
+}
+
+template<class T>
+void TableAppender::set(int ncol, T* values, long row) {
+	char* dst = element(ncol, row, 1);
+	storeAs(columns[ncol].type, dst, values, columns[ncol].vsize);
+}
+
+template<class T>
+void TableAppender::setRows(int ncol, const T* values, long nrows) {
+	char* dst = element(ncol, 0, nrows);
+	storeAs(columns[ncol].type, dst, values, nrows * columns[ncol].vsize);
+}
+
+}
+
+#endif
@@ -0,0 +1,138 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <cstring>
+#include <algorithm>
+#include <thread>
+#include "TableCompressor.h"
+
+namespace qlbase {
+
+TableCompressor::TableCompressor(const std::vector<field>& fields, const std::vector<TileCompressor::Algorithm>& algorithms,
+                                 long tileRows, int nthreads)
+	: tileRows(tileRows), nthreads(nthreads), baseRow(0) {
+
+	if(fields.empty() || fields.size() != algorithms.size() || tileRows < 1)
+		throw IOException("Error in TableCompressor::TableCompressor() ", 0);
+
+	columns.resize(fields.size());
+	for(unsigned int i=0; i<fields.size(); i++) {
+		Column& c = columns[i];
+		c.type = fields[i].type;
+		c.vsize = fields[i].vsize;
+		c.bytepix = getTypeSize(fields[i].type);
+		c.algorithm = algorithms[i];
+		c.rows = 0;
+
+		if(c.vsize < 1)
+			throw IOException("Error in TableCompressor::TableCompressor() vsize < 1", 0);
+
+		// Rice compresses integers up to 32 bit only
+		bool integer = c.type == UNSIGNED_INT8 || c.type == INT16 || c.type == INT32;
+		if(c.algorithm == TileCompressor::RICE && !integer)
+			throw IOException("Error in TableCompressor::TableCompressor() RICE needs an integer column", 0);
+	}
+
+	if(this->nthreads <= 0)
+		this->nthreads = std::max(1u, std::thread::hardware_concurrency());
+}
+
+char* TableCompressor::prepare(int ncol, long frow, long nelem) {
+	if(ncol < 0 || ncol >= (int) columns.size() || nelem < 1)
+		throw IOException("Error in TableCompressor::write() ", 0);
+	if(frow < baseRow)
+		throw IOException("Error in TableCompressor::write() rows already compressed", 0);
+
+	Column& c = columns[ncol];
+	size_t width = c.vsize * c.bytepix;
+	long rows = frow - baseRow + (nelem + c.vsize - 1) / c.vsize;
+	if(c.data.size() < rows * width)
+		c.data.resize(rows * width, 0);
+	c.rows = std::max(c.rows, rows);
+
+	return &c.data[(frow - baseRow) * width];
+}
+
+void TableCompressor::writeString(int ncol, const StringColumn& column, long frow) {
+	long nrows = column.size();
+	if(ncol < 0 || ncol >= (int) columns.size() || columns[ncol].type != STRING || nrows < 1)
+		throw IOException("Error in TableCompressor::writeString() ", 0);
+
+	// the rows are padded with '\0' up to the column width
+	size_t width = columns[ncol].vsize;
+	size_t size = std::min(width, (size_t) column.getWidth());
+	char* dst = prepare(ncol, frow, nrows * width);
+	for(long row=0; row<nrows; row++) {
+		memcpy(dst + row * width, column[row], size);
+		memset(dst + row * width + size, 0, width - size);
+	}
+}
+
+long TableCompressor::getRowWidth() {
+	long width = 0;
+	for(unsigned int i=0; i<columns.size(); i++)
+		width += columns[i].vsize * columns[i].bytepix;
+	return width;
+}
+
+long TableCompressor::getNRows() {
+	long rows = 0;
+	for(unsigned int i=0; i<columns.size(); i++)
+		rows = std::max(rows, columns[i].rows);
+	return baseRow + rows;
+}
+
+long TableCompressor::getCompleteTiles() {
+	long rows = columns[0].rows;
+	for(unsigned int i=1; i<columns.size(); i++)
+		rows = std::min(rows, columns[i].rows);
+	return rows / tileRows;
+}
+
+void TableCompressor::compress(bool last, std::vector< std::vector< std::vector<unsigned char> > >& tiles) {
+	long ntiles = getCompleteTiles();
+	long rows = ntiles * tileRows;
+	if(last) {
+		rows = getNRows() - baseRow;
+		ntiles = (rows + tileRows - 1) / tileRows;
+		for(unsigned int i=0; i<columns.size(); i++)
+			columns[i].data.resize(rows * columns[i].vsize * columns[i].bytepix, 0);
+	}
+
+	long ncols = columns.size();
+	tiles.assign(ntiles, std::vector< std::vector<unsigned char> >(ncols));
+	if(ntiles == 0)
+		return;
+
+	// a job for each cell, the last tile can be shorter
+	TileCompressor::forEach(nthreads, ntiles * ncols, [this, ncols, rows, &tiles](long n) {
+		long tile = n / ncols;
+		const Column& c = columns[n % ncols];
+		size_t width = c.vsize * c.bytepix;
+		long nrows = std::min(tileRows, rows - tile * tileRows);
+		const char* first = &c.data[tile * tileRows * width];
+		std::vector<char> values(first, first + nrows * width);
+		TileCompressor::compressBuffer(c.algorithm, c.bytepix, values, tiles[tile][n % ncols]);
+	});
+
+	for(unsigned int i=0; i<columns.size(); i++) {
+		Column& c = columns[i];
+		size_t width = c.vsize * c.bytepix;
+		c.data.erase(c.data.begin(), c.data.begin() + std::min(c.data.size(), rows * width));
+		c.rows = std::max(0L, c.rows - rows);
+	}
+	baseRow += rows;
+}
+
+}
@@ -0,0 +1,98 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_TABLECOMPRESSOR_H
+#define QL_IO_TABLECOMPRESSOR_H
+
+#include <stdint.h>
+#include <vector>
+#include "OutputFile.h"
+#include "TileCompressor.h"
+#include "StringColumn.h"
+
+namespace qlbase {
+
+/// Buffer the rows of a binary table and compress them with the FITS tiled
+/// table convention: each tile of tileRows rows becomes a row of the
+/// compressed table, with a compressed cell for each column. The cells of a
+/// batch of tiles are compressed in parallel.
+class TableCompressor {
+
+public:
+
+	/// \param[in] fields The table fields.
+	/// \param[in] algorithms The algorithm of each field.
+	/// \param[in] tileRows Rows of each tile.
+	/// \param[in] nthreads Number of threads, 0 for the available cores.
+	TableCompressor(const std::vector<field>& fields, const std::vector<TileCompressor::Algorithm>& algorithms,
+	                long tileRows, int nthreads = 0);
+
+	/// Buffer nelem values of a column, starting from row frow, converted
+	/// to the column type. Rows already compressed can't be written.
+	template<class T>
+	void write(int ncol, const T* values, long frow, long nelem);
+
+	/// Buffer strings from row frow, truncated or padded to the column size.
+	void writeString(int ncol, const StringColumn& column, long frow);
+
+	/// Get the number of threads.
+	int getThreads() { return nthreads; }
+
+	/// Get the size of an uncompressed row.
+	long getRowWidth();
+
+	/// Get the number of rows written.
+	long getNRows();
+
+	/// Get the number of tiles ready to be compressed, the ones with all
+	/// the columns written.
+	long getCompleteTiles();
+
+	/// Compress the complete tiles, or all the rows if last is true (values
+	/// never written are 0).
+	/// \param[out] tiles The compressed cells, tiles[tile][column].
+	void compress(bool last, std::vector< std::vector< std::vector<unsigned char> > >& tiles);
+
+private:
+
+	struct Column {
+		fieldType type;
+		int vsize;
+		int bytepix;
+		TileCompressor::Algorithm algorithm;
+		/// Values of the buffered rows, in the column type.
+		std::vector<char> data;
+		/// Number of buffered rows with values.
+		long rows;
+	};
+
+	std::vector<Column> columns;
+	long tileRows;
+	int nthreads;
+
+	/// The table row of the first buffered row.
+	long baseRow;
+
+	char* prepare(int ncol, long frow, long nelem);
+};
+
+template<class T>
+void TableCompressor::write(int ncol, const T* values, long frow, long nelem) {
+	char* dst = prepare(ncol, frow, nelem);
+	storeAs(columns[ncol].type, dst, values, nelem);
+}
+
+}
+
+#endif
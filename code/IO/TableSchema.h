@@ -0,0 +1,281 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_TABLESCHEMA_H
+#define QL_IO_TABLESCHEMA_H
+
+#include <string>
+#include <tuple>
+#include <vector>
+#include "FitsTraits.h"
+#include "StringColumn.h"
+#include "VarColumn.h"
+#include "InputFileFITS.h"
+#include "OutputFileFITS.h"
+
+namespace qlbase {
+
+/// A numeric column of a schema, vsize values of type T in each row. The
+/// rows are stored in one std::vector, row after row.
+template<class T, int VSIZE = 1>
+struct Field {
+	static_assert(VSIZE > 0, "the vsize of a field must be positive");
+
+	typedef T type;
+	typedef std::vector<T> storage;
+	static const int vsize = VSIZE;
+	static constexpr fieldType fitsType = FitsTraits<T>::type;
+
+	static const char* unit() { return ""; }
+
+	static long rows(const storage& s) { return s.size() / VSIZE; }
+	static void resize(storage& s, long nrows) { s.resize(nrows * VSIZE); }
+
+	static void read(InputFileFITS& file, int ncol, long frow, long lrow, storage& s) {
+		resize(s, lrow - frow + 1);
+		file.read(ncol, frow, lrow, s.data(), VSIZE);
+	}
+
+	static void write(OutputFileFITS& file, int ncol, const storage& s, long frow) {
+		long n = rows(s);
+		if(n > 0)
+			file.write(ncol, s.data(), frow, frow + n - 1, VSIZE);
+	}
+};
+
+template<class T, int VSIZE>
+const int Field<T, VSIZE>::vsize;
+
+/// A string column of a schema, up to WIDTH characters in each row.
+template<int WIDTH>
+struct StringField {
+	static_assert(WIDTH > 0, "the width of a string field must be positive");
+
+	typedef StringColumn storage;
+	static const int vsize = WIDTH;
+	static constexpr fieldType fitsType = STRING;
+
+	static const char* unit() { return ""; }
+
+	static long rows(const storage& s) { return s.size(); }
+	static void resize(storage& s, long nrows) { s.resize(nrows, WIDTH); }
+
+	static void read(InputFileFITS& file, int ncol, long frow, long lrow, storage& s) {
+		file.readString(ncol, frow, lrow, s);
+	}
+
+	static void write(OutputFileFITS& file, int ncol, const storage& s, long frow) {
+		if(s.size() > 0)
+			file.writeString(ncol, s, frow);
+	}
+};
+
+template<int WIDTH>
+const int StringField<WIDTH>::vsize;
+
+/// A variable length array column of a schema (fits type 1P).
+template<class T>
+struct VarField {
+	typedef T type;
+	typedef VarColumn<T> storage;
+	static const int vsize = 0;
+	static constexpr fieldType fitsType = FitsTraits<T>::type;
+
+	static const char* unit() { return ""; }
+
+	static long rows(const storage& s) { return s.size(); }
+	static void resize(storage& s, long nrows) { s.resize(nrows); }
+
+	static void read(InputFileFITS& file, int ncol, long frow, long lrow, storage& s) {
+		file.readVar(ncol, frow, lrow, s);
+	}
+
+	static void write(OutputFileFITS& file, int ncol, const storage& s, long frow) {
+		if(s.size() > 0)
+			file.writeVar(ncol, s, frow);
+	}
+};
+
+template<class T>
+const int VarField<T>::vsize;
+
+/// Declare a field named label, e.g. QL_FIELD(Energy, "ENERGY", float, 1).
+#define QL_FIELD(Name, label, T, vsize) \
+	struct Name : public qlbase::Field<T, vsize> { \
+		static const char* name() { return label; } \
+	}
+
+/// Declare a string field named label, e.g. QL_STRING_FIELD(Source, "SOURCE", 16).
+#define QL_STRING_FIELD(Name, label, width) \
+	struct Name : public qlbase::StringField<width> { \
+		static const char* name() { return label; } \
+	}
+
+/// Declare a variable length array field named label, e.g.
+/// QL_VAR_FIELD(Waveform, "WAVEFORM", int16_t).
+#define QL_VAR_FIELD(Name, label, T) \
+	struct Name : public qlbase::VarField<T> { \
+		static const char* name() { return label; } \
+	}
+
+namespace schema_detail {
+
+template<class F, class... Fields>
+struct IndexOf;
+
+// no specialization for an empty list, so a field not in the schema
+// doesn't compile
+template<class F, class... Fields>
+struct IndexOf<F, F, Fields...> {
+	static constexpr int value = 0;
+};
+
+template<class F, class G, class... Fields>
+struct IndexOf<F, G, Fields...> {
+	static constexpr int value = 1 + IndexOf<F, Fields...>::value;
+};
+
+template<class... Fields>
+struct First;
+
+template<class F, class... Fields>
+struct First<F, Fields...> {
+	typedef F type;
+};
+
+}
+
+/// A table layout known at compile time. The table is a struct of arrays,
+/// one storage for each field, and reads and writes go to the templated
+/// InputFileFITS::read() and OutputFileFITS::write() with the cfitsio type
+/// of each column resolved by FitsTraits, so there is no virtual call and
+/// no type switch for each column.
+///
+/// \code
+/// QL_FIELD(Time, "TIME", double, 1);
+/// QL_FIELD(Counts, "COUNTS", int32_t, 16);
+/// typedef Schema<Time, Counts> Events;
+///
+/// Events::Table events;
+/// Events::read(file, 0, 999, events);
+/// std::vector<double>& time = events.column<Time>();
+/// \endcode
+///
+/// Reads find the columns by name, so the file may have other columns or a
+/// different order, but a column with a type or vsize other than the
+/// field one raises a qlbase::IOException before any read. Writes use the
+/// order of the schema.
+template<class... Fields>
+class Schema {
+
+	static_assert(sizeof...(Fields) > 0, "a schema needs at least one field");
+
+public:
+
+	static const int ncols = sizeof...(Fields);
+
+	/// Get the position of a field in the schema.
+	template<class F>
+	static constexpr int index() {
+		return schema_detail::IndexOf<F, Fields...>::value;
+	}
+
+	/// Get the fields for OutputFile::createTable().
+	static std::vector<field> fields() {
+		field list[] = { makeField<Fields>()... };
+		return std::vector<field>(list, list + ncols);
+	}
+
+	class Table {
+
+	public:
+
+		template<class F>
+		typename F::storage& column() {
+			return std::get<index<F>()>(columns);
+		}
+
+		template<class F>
+		const typename F::storage& column() const {
+			return std::get<index<F>()>(columns);
+		}
+
+		/// Set the number of rows of all the columns.
+		void resize(long nrows) {
+			int expand[] = { (Fields::resize(column<Fields>(), nrows), 0)... };
+			(void) expand;
+		}
+
+		/// Get the number of rows of the first column.
+		long size() const {
+			typedef typename schema_detail::First<Fields...>::type F;
+			return F::rows(column<F>());
+		}
+
+	private:
+
+		std::tuple<typename Fields::storage...> columns;
+	};
+
+	static void createTable(OutputFileFITS& file, const std::string& name) {
+		file.createTable(name, fields());
+	}
+
+	/// Read rows frow to lrow of the current table.
+	static void read(InputFileFITS& file, long frow, long lrow, Table& table) {
+		if(lrow < frow)
+			throw IOException("Error in Schema::read() invalid rows", 0);
+
+		// all the columns are checked before reading any
+		int ncols[] = { check<Fields>(file)... };
+		int i = 0;
+		int expand[] = { (Fields::read(file, ncols[i++], frow, lrow, table.template column<Fields>()), 0)... };
+		(void) expand;
+	}
+
+	/// Write all the rows of the table starting from frow.
+	static void write(OutputFileFITS& file, const Table& table, long frow) {
+		int expand[] = { (Fields::write(file, index<Fields>(), table.template column<Fields>(), frow), 0)... };
+		(void) expand;
+	}
+
+private:
+
+	/// Get the column of a field, checking its type and vsize.
+	template<class F>
+	static int check(InputFileFITS& file) {
+		int ncol = file.getColNum(F::name());
+		field f = file.getField(ncol);
+		if(f.type != F::fitsType || f.vsize != F::vsize)
+			throw IOException(std::string("Error in Schema::read() column ") + F::name() + " has a different type or vsize in the file", 0);
+		return ncol;
+	}
+
+	template<class F>
+	static field makeField() {
+		field f;
+		f.name = F::name();
+		f.type = F::fitsType;
+		f.vsize = F::vsize;
+		f.unit = F::unit();
+		return f;
+	}
+};
+
+template<class... Fields>
+const int Schema<Fields...>::ncols;
+
+}
+
+#endif
@@ -0,0 +1,198 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "TextIndex.h"
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace qlbase {
+
+#define SIDECAR_MAGIC "QLTXIDX"
+#define SIDECAR_VERSION 1
+#define SIDECAR_MAXSEP 32
+
+/// Sidecar layout: this header, ncols int32 types padded to 8 bytes and
+/// nrows uint64 offsets. Native byte order, the order mark rejects a
+/// sidecar written by a different architecture.
+struct SidecarHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t ncols;
+	uint64_t fileSize;
+	int64_t fileMTime;
+	uint64_t nrows;
+	uint64_t scanEnd;
+	uint32_t openLine;
+	uint32_t separatorSize;
+	char separator[SIDECAR_MAXSEP];
+	uint64_t order;
+};
+
+static const uint64_t BYTE_ORDER_MARK = 0x0102030405060708ULL;
+
+static size_t typesSize(uint32_t ncols) {
+	return (ncols * sizeof(int32_t) + 7) & ~((size_t) 7);
+}
+
+TextIndex::TextIndex() : scanEnd(0), openLine(false), ncols(0), offsets(0), nrows(0), map(0), mapSize(0) {
+}
+
+TextIndex::~TextIndex() {
+	unmap();
+}
+
+void TextIndex::push_back(uint64_t offset) {
+	// a mapped index becomes private on the first change
+	if(map) {
+		owned.assign(offsets, offsets + nrows);
+		unmap();
+	}
+
+	owned.resize(nrows);
+	owned.push_back(offset);
+	offsets = &owned[0];
+	nrows++;
+}
+
+void TextIndex::clear() {
+	unmap();
+	owned.clear();
+	offsets = 0;
+	nrows = 0;
+	scanEnd = 0;
+	openLine = false;
+	ncols = 0;
+	types.clear();
+}
+
+void TextIndex::unmap() {
+	if(map)
+		munmap(map, mapSize);
+	map = 0;
+	mapSize = 0;
+}
+
+std::string TextIndex::getSidecarName(const std::string& filename) {
+	return filename + ".qlidx";
+}
+
+bool TextIndex::stat(const std::string& filename, uint64_t& size, int64_t& mtime) {
+	struct stat st;
+	if(::stat(filename.c_str(), &st) != 0)
+		return false;
+
+	size = st.st_size;
+#ifdef __MACH__
+	mtime = (int64_t) st.st_mtimespec.tv_sec * 1000000000LL + st.st_mtimespec.tv_nsec;
+#else
+	mtime = (int64_t) st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+#endif
+	return true;
+}
+
+bool TextIndex::load(const std::string& filename, const std::string& separator) {
+	uint64_t fileSize;
+	int64_t fileMTime;
+	if(!stat(filename, fileSize, fileMTime) || separator.size() > SIDECAR_MAXSEP)
+		return false;
+
+	int fd = open(getSidecarName(filename).c_str(), O_RDONLY);
+	if(fd < 0)
+		return false;
+
+	struct stat st;
+	void* base = MAP_FAILED;
+	if(fstat(fd, &st) == 0 && (size_t) st.st_size >= sizeof(SidecarHeader))
+		base = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(base == MAP_FAILED)
+		return false;
+
+	const SidecarHeader* header = (const SidecarHeader*) base;
+	size_t start = sizeof(SidecarHeader) + typesSize(header->ncols);
+	bool valid = memcmp(header->magic, SIDECAR_MAGIC, sizeof(SIDECAR_MAGIC)) == 0
+	          && header->version == SIDECAR_VERSION
+	          && header->order == BYTE_ORDER_MARK
+	          && header->fileSize == fileSize
+	          && header->fileMTime == fileMTime
+	          && header->separatorSize == separator.size()
+	          && memcmp(header->separator, separator.c_str(), separator.size()) == 0
+	          && (uint64_t) st.st_size == start + header->nrows * sizeof(uint64_t);
+	if(!valid) {
+		munmap(base, st.st_size);
+		return false;
+	}
+
+	clear();
+	map = base;
+	mapSize = st.st_size;
+	offsets = (const uint64_t*) ((const char*) base + start);
+	nrows = header->nrows;
+	scanEnd = header->scanEnd;
+	openLine = header->openLine != 0;
+	ncols = header->ncols;
+
+	const int32_t* t = (const int32_t*) (header + 1);
+	types.resize(ncols);
+	for(int i=0; i<ncols; i++)
+		types[i] = (fieldType) t[i];
+
+	return true;
+}
+
+void TextIndex::save(const std::string& filename, const std::string& separator, uint64_t fileSize, int64_t fileMTime) {
+	if(separator.size() > SIDECAR_MAXSEP)
+		return;
+
+	SidecarHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, SIDECAR_MAGIC, sizeof(SIDECAR_MAGIC));
+	header.version = SIDECAR_VERSION;
+	header.ncols = ncols;
+	header.fileSize = fileSize;
+	header.fileMTime = fileMTime;
+	header.nrows = nrows;
+	header.scanEnd = scanEnd;
+	header.openLine = openLine;
+	header.separatorSize = separator.size();
+	memcpy(header.separator, separator.c_str(), separator.size());
+	header.order = BYTE_ORDER_MARK;
+
+	std::vector<int32_t> t(typesSize(ncols) / sizeof(int32_t), 0);
+	for(int i=0; i<ncols && i<(int)types.size(); i++)
+		t[i] = types[i];
+
+	// write a temporary file and rename it, readers never see a partial index
+	std::string sidecar = getSidecarName(filename);
+	std::ostringstream tmp;
+	tmp << sidecar << "." << getpid();
+	FILE* out = fopen(tmp.str().c_str(), "wb");
+	if(!out)
+		return;
+
+	bool ok = fwrite(&header, sizeof(header), 1, out) == 1
+	       && (t.empty() || fwrite(&t[0], sizeof(int32_t), t.size(), out) == t.size())
+	       && (nrows == 0 || fwrite(offsets, sizeof(uint64_t), nrows, out) == nrows);
+	ok = (fclose(out) == 0) && ok;
+
+	if(!ok || rename(tmp.str().c_str(), sidecar.c_str()) != 0)
+		unlink(tmp.str().c_str());
+}
+
+}
@@ -0,0 +1,87 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_TEXTINDEX_H
+#define QL_IO_TEXTINDEX_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "OutputFile.h"
+
+namespace qlbase {
+
+/// The row offsets of a text file, with the number of columns and their
+/// inferred types. The index can be saved into a sidecar file and mapped
+/// back in memory on the next open, avoiding the scan of the text file.
+/// A sidecar is valid only for the same file size, modification time and
+/// field separator.
+class TextIndex {
+
+public:
+
+	TextIndex();
+	~TextIndex();
+
+	/// Get the number of rows.
+	uint64_t size() const { return nrows; }
+
+	/// Get the offset of a row inside the text file.
+	uint64_t operator[](uint64_t row) const { return offsets[row]; }
+
+	void push_back(uint64_t offset);
+	void pop_back() { nrows--; }
+	void clear();
+
+	/// Map the sidecar index of a text file.
+	/// \return false if the sidecar is missing or doesn't match the text file.
+	bool load(const std::string& filename, const std::string& separator);
+
+	/// Save the index into the sidecar file of a text file. Errors (e.g. a
+	/// read-only directory) are ignored, the index is rebuilt on the next open.
+	/// \param[in] fileSize, fileMTime The text file status before the scan.
+	void save(const std::string& filename, const std::string& separator, uint64_t fileSize, int64_t fileMTime);
+
+	/// Get the sidecar file name of a text file.
+	static std::string getSidecarName(const std::string& filename);
+
+	/// Get the size and the modification time (ns) of a file.
+	static bool stat(const std::string& filename, uint64_t& size, int64_t& mtime);
+
+	/// Offset after the last terminated line and if the last row has no terminator.
+	uint64_t scanEnd;
+	bool openLine;
+
+	/// Number of columns and their inferred types (INT64, DOUBLE or STRING).
+	int ncols;
+	std::vector<fieldType> types;
+
+private:
+
+	TextIndex(const TextIndex&);
+	TextIndex& operator=(const TextIndex&);
+
+	void unmap();
+
+	std::vector<uint64_t> owned;
+	const uint64_t* offsets;
+	uint64_t nrows;
+
+	void* map;
+	size_t mapSize;
+};
+
+}
+
+#endif
@@ -0,0 +1,204 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <cstring>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <string>
+#include <stdexcept>
+#include <fitsio.h>
+#include <zlib.h>
+#include "TileCompressor.h"
+
+namespace qlbase {
+
+/// The Rice block size (ZVAL1 of BLOCKSIZE).
+#define RICE_BLOCKSIZE 32
+
+TileCompressor::TileCompressor(int bitpix, const std::vector<long>& sizes, const std::vector<long>& tiles,
+                               Algorithm algorithm, int nthreads)
+	: bitpix(bitpix), sizes(sizes), tiles(tiles), algorithm(algorithm), nthreads(nthreads) {
+
+	if(sizes.empty() || !supports(algorithm, bitpix))
+		throw IOException("Error in TileCompressor::TileCompressor() ", 0);
+
+	bytepix = (bitpix < 0 ? -bitpix : bitpix) / 8;
+
+	// row by row tiles by default, like cfitsio
+	if(this->tiles.empty()) {
+		this->tiles.assign(sizes.size(), 1);
+		this->tiles[0] = sizes[0];
+	}
+	if(this->tiles.size() != sizes.size())
+		throw IOException("Error in TileCompressor::TileCompressor() wrong tile dimensions", 0);
+
+	ntiles = 1;
+	grid.resize(sizes.size());
+	for(unsigned int d=0; d<sizes.size(); d++) {
+		if(this->tiles[d] < 1 || sizes[d] < 1)
+			throw IOException("Error in TileCompressor::TileCompressor() ", 0);
+		this->tiles[d] = std::min(this->tiles[d], sizes[d]);
+		grid[d] = (sizes[d] + this->tiles[d] - 1) / this->tiles[d];
+		ntiles *= grid[d];
+	}
+
+	if(this->nthreads <= 0)
+		this->nthreads = std::max(1u, std::thread::hardware_concurrency());
+}
+
+bool TileCompressor::supports(Algorithm algorithm, int bitpix) {
+	if(algorithm == RICE)
+		return bitpix == BYTE_IMG || bitpix == SHORT_IMG || bitpix == LONG_IMG;
+
+	return bitpix == BYTE_IMG || bitpix == SHORT_IMG || bitpix == LONG_IMG || bitpix == LONGLONG_IMG
+	    || bitpix == FLOAT_IMG || bitpix == DOUBLE_IMG;
+}
+
+void TileCompressor::compress(const void* image, std::vector< std::vector<unsigned char> >& compressed) {
+	compressed.resize(ntiles);
+
+	forEach(nthreads, ntiles, [this, image, &compressed](long tile) {
+		std::vector<char> pixels;
+		extract((const char*) image, tile, pixels);
+		compressBuffer(algorithm, bytepix, pixels, compressed[tile]);
+	});
+}
+
+void TileCompressor::forEach(int nthreads, long njobs, const std::function<void(long)>& job) {
+	nthreads = std::max(1L, std::min((long) nthreads, njobs));
+
+	// the threads take the next job until all are done
+	std::atomic<long> next(0);
+	std::vector<std::string> errors(nthreads);
+	std::vector<std::thread> threads;
+	for(int t=0; t<nthreads; t++) {
+		threads.push_back(std::thread([&job, &next, &errors, njobs, t]() {
+			try {
+				long n;
+				while((n = next++) < njobs)
+					job(n);
+			}
+			catch(std::exception& e) {
+				errors[t] = e.what();
+			}
+		}));
+	}
+	for(unsigned int t=0; t<threads.size(); t++)
+		threads[t].join();
+
+	for(int t=0; t<nthreads; t++)
+		if(!errors[t].empty())
+			throw IOException(errors[t], 0);
+}
+
+void TileCompressor::extract(const char* image, long tile, std::vector<char>& pixels) {
+	int naxis = sizes.size();
+
+	// tile origin and extent
+	std::vector<long> origin(naxis), extent(naxis);
+	long npix = 1;
+	for(int d=0; d<naxis; d++) {
+		origin[d] = (tile % grid[d]) * tiles[d];
+		tile /= grid[d];
+		extent[d] = std::min(tiles[d], sizes[d] - origin[d]);
+		npix *= extent[d];
+	}
+	pixels.resize(npix * bytepix);
+
+	// copy the tile rows (first axis), the other indexes run like an odometer
+	std::vector<long> index(naxis, 0);
+	size_t rowSize = extent[0] * bytepix;
+	char* out = &pixels[0];
+	while(true) {
+		long offset = 0;
+		long stride = 1;
+		for(int d=0; d<naxis; d++) {
+			offset += (origin[d] + index[d]) * stride;
+			stride *= sizes[d];
+		}
+		memcpy(out, image + offset * bytepix, rowSize);
+		out += rowSize;
+
+		int d = 1;
+		while(d < naxis && ++index[d] == extent[d])
+			index[d++] = 0;
+		if(d == naxis)
+			break;
+	}
+}
+
+void TileCompressor::compressBuffer(Algorithm algorithm, int bytepix, std::vector<char>& pixels,
+                                    std::vector<unsigned char>& out) {
+	long npix = pixels.size() / bytepix;
+
+	if(algorithm == RICE) {
+		// the Rice output is at most a bit more than the input
+		out.resize(pixels.size() + pixels.size() / 8 + 64);
+		int size;
+		switch(bytepix) {
+			case 1:
+				size = fits_rcomp_byte((signed char*) &pixels[0], npix, &out[0], out.size(), RICE_BLOCKSIZE);
+				break;
+			case 2:
+				size = fits_rcomp_short((short*) &pixels[0], npix, &out[0], out.size(), RICE_BLOCKSIZE);
+				break;
+			case 4:
+				size = fits_rcomp((int*) &pixels[0], npix, &out[0], out.size(), RICE_BLOCKSIZE);
+				break;
+			default:
+				size = -1;
+				break;
+		}
+		if(size < 0)
+			throw IOException("Error in TileCompressor::compressBuffer() rice compression", 0);
+		out.resize(size);
+		return;
+	}
+
+	// GZIP_1 compresses the big endian pixels, in gzip format
+	const uint16_t one = 1;
+	if(*(const char*) &one == 1 && bytepix > 1) {
+		for(long i=0; i<npix; i++)
+			std::reverse(&pixels[i * bytepix], &pixels[(i+1) * bytepix]);
+	}
+
+	// GZIP_2 first puts the first byte of all the pixels, then the second ones...
+	if(algorithm == GZIP2 && bytepix > 1) {
+		std::vector<char> shuffled(pixels.size());
+		for(long i=0; i<npix; i++)
+			for(int b=0; b<bytepix; b++)
+				shuffled[b * npix + i] = pixels[i * bytepix + b];
+		pixels.swap(shuffled);
+	}
+
+	z_stream strm;
+	memset(&strm, 0, sizeof(strm));
+	if(deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		throw IOException("Error in TileCompressor::compressBuffer() gzip compression", 0);
+
+	out.resize(deflateBound(&strm, pixels.size()) + 32);
+	strm.next_in = (Bytef*) &pixels[0];
+	strm.avail_in = pixels.size();
+	strm.next_out = &out[0];
+	strm.avail_out = out.size();
+	int ret = deflate(&strm, Z_FINISH);
+	out.resize(strm.total_out);
+	deflateEnd(&strm);
+
+	if(ret != Z_STREAM_END)
+		throw IOException("Error in TileCompressor::compressBuffer() gzip compression", 0);
+}
+
+}
@@ -0,0 +1,90 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_TILECOMPRESSOR_H
+#define QL_IO_TILECOMPRESSOR_H
+
+#include <stdint.h>
+#include <vector>
+#include <functional>
+#include "File.h"
+
+namespace qlbase {
+
+/// Compress the tiles of an image with the FITS tiled image compression
+/// algorithms (RICE_1, GZIP_1 and GZIP_2), using several threads. The
+/// compressed tiles are the COMPRESSED_DATA cells of a tile-compressed
+/// image HDU.
+class TileCompressor {
+
+public:
+
+	enum Algorithm {
+		RICE = 0,
+		GZIP,
+		/// GZIP of the shuffled bytes (the most significant ones first).
+		GZIP2
+	};
+
+	/// \param[in] bitpix The image BITPIX.
+	/// \param[in] sizes The image sizes (NAXISn).
+	/// \param[in] tiles The tile sizes (ZTILEn), the image rows if empty.
+	/// \param[in] algorithm RICE (integer images up to 32 bit), GZIP or GZIP2.
+	/// \param[in] nthreads Number of threads, 0 for the available cores.
+	TileCompressor(int bitpix, const std::vector<long>& sizes, const std::vector<long>& tiles,
+	               Algorithm algorithm, int nthreads = 0);
+
+	/// True if the algorithm can compress images of this BITPIX.
+	static bool supports(Algorithm algorithm, int bitpix);
+
+	/// Get the tile sizes.
+	const std::vector<long>& getTileSizes() { return tiles; }
+
+	/// Get the number of tiles.
+	long getTilesNum() { return ntiles; }
+
+	/// Compress an image.
+	/// \param[in] image The pixels in FITS order, with the BITPIX type.
+	/// \param[out] compressed The compressed tiles, in FITS order.
+	void compress(const void* image, std::vector< std::vector<unsigned char> >& compressed);
+
+	/// Compress a buffer of values with the FITS tile compression rules.
+	/// \param[in] algorithm The algorithm.
+	/// \param[in] bytepix The size of a value, RICE needs 1, 2 or 4.
+	/// \param[in,out] values The values in native byte order, overwritten.
+	/// \param[out] out The compressed buffer.
+	static void compressBuffer(Algorithm algorithm, int bytepix, std::vector<char>& values,
+	                           std::vector<unsigned char>& out);
+
+	/// Call job(0), ..., job(njobs-1) from nthreads threads. The first
+	/// error is thrown after all the threads ended.
+	static void forEach(int nthreads, long njobs, const std::function<void(long)>& job);
+
+private:
+
+	int bitpix;
+	int bytepix;
+	std::vector<long> sizes;
+	std::vector<long> tiles;
+	std::vector<long> grid;
+	long ntiles;
+	Algorithm algorithm;
+	int nthreads;
+
+	void extract(const char* image, long tile, std::vector<char>& pixels);
+};
+
+}
+
+#endif
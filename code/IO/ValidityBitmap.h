@@ -0,0 +1,113 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_VALIDITYBITMAP_H
+#define QL_IO_VALIDITYBITMAP_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace qlbase {
+
+/// One bit for each value of a column or image, 1 if the value is defined
+/// and 0 if it is undefined (TNULL, or NaN for floats). The bits are packed
+/// in 64 bit words, value i is bit i % 64 of word i / 64.
+///
+/// \code
+/// ValidityBitmap validity;
+/// std::vector<int32_t> counts = file.read32i(0, frow, lrow, validity);
+/// for(long i=0; i<validity.size(); i++)
+///     if(validity.isValid(i))
+///         sum += counts[i];
+/// \endcode
+class ValidityBitmap {
+
+public:
+
+	ValidityBitmap() : nbits(0) {}
+
+	explicit ValidityBitmap(long size, bool valid = true) : nbits(0) {
+		resize(size, valid);
+	}
+
+	/// Set the number of values, all defined or undefined.
+	void resize(long size, bool valid = true) {
+		nbits = size;
+		words.assign((size + 63) / 64, valid ? ~(uint64_t) 0 : 0);
+		clearTail();
+	}
+
+	/// Get the number of values.
+	long size() const { return nbits; }
+
+	bool isValid(long i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+
+	void set(long i, bool valid) {
+		if(valid)
+			words[i >> 6] |= (uint64_t) 1 << (i & 63);
+		else
+			words[i >> 6] &= ~((uint64_t) 1 << (i & 63));
+	}
+
+	/// Set the values from the cfitsio null flags (1 for undefined values).
+	void setNulls(const char* nulls, long size) {
+		nbits = size;
+		words.resize((size + 63) / 64);
+		for(unsigned long w=0; w<words.size(); w++) {
+			long first = w * 64;
+			long n = size - first < 64 ? size - first : 64;
+			uint64_t word = 0;
+			for(long b=0; b<n; b++)
+				word |= (uint64_t) (nulls[first + b] == 0) << b;
+			words[w] = word;
+		}
+	}
+
+	/// Get the number of undefined values.
+	long countNulls() const {
+		long valid = 0;
+		for(unsigned long w=0; w<words.size(); w++)
+			valid += __builtin_popcountll(words[w]);
+		return nbits - valid;
+	}
+
+	bool hasNulls() const {
+		for(unsigned long w=0; w<words.size(); w++) {
+			long n = nbits - (long) w * 64 < 64 ? nbits - w * 64 : 64;
+			uint64_t all = n == 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << n) - 1;
+			if(words[w] != all)
+				return true;
+		}
+		return false;
+	}
+
+	/// Get the words, (size() + 63) / 64 of them. The bits after size()
+	/// are 0.
+	const uint64_t* data() const { return words.empty() ? 0 : &words[0]; }
+	uint64_t* data() { return words.empty() ? 0 : &words[0]; }
+
+private:
+
+	std::vector<uint64_t> words;
+	long nbits;
+
+	void clearTail() {
+		if(nbits % 64)
+			words.back() &= ((uint64_t) 1 << (nbits % 64)) - 1;
+	}
+};
+
+}
+
+#endif
@@ -0,0 +1,87 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QL_IO_VARCOLUMN_H
+#define QL_IO_VARCOLUMN_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace qlbase {
+
+/// The rows of a variable length array column (fits type for es. 1PJ or
+/// 1QJ) in compressed sparse row layout: the values of all the rows one
+/// after the other, and the offset of each row in the values. Row i is
+/// values[offsets[i]] to values[offsets[i+1]-1].
+///
+/// \code
+/// VarColumn<float> waveforms;
+/// file.readVar(3, frow, lrow, waveforms);
+/// for(long i=0; i<waveforms.size(); i++)
+///     process(waveforms[i], waveforms.length(i));
+/// \endcode
+template<class T>
+class VarColumn {
+
+public:
+
+	VarColumn() : offsets(1, 0) {}
+
+	/// Get the number of rows.
+	long size() const { return offsets.size() - 1; }
+
+	/// Get the number of values of a row.
+	long length(long row) const { return offsets[row + 1] - offsets[row]; }
+
+	/// Get the values of a row.
+	const T* operator[](long row) const { return values.empty() ? 0 : &values[offsets[row]]; }
+	T* operator[](long row) { return values.empty() ? 0 : &values[offsets[row]]; }
+
+	/// Remove all the rows, keeping the buffers.
+	void clear() {
+		values.clear();
+		offsets.assign(1, 0);
+	}
+
+	/// Set nrows empty rows.
+	void resize(long nrows) {
+		values.clear();
+		offsets.assign(nrows + 1, 0);
+	}
+
+	/// Add a row of n values.
+	void append(const T* row, long n) {
+		values.insert(values.end(), row, row + n);
+		offsets.push_back(values.size());
+	}
+
+	void append(const std::vector<T>& row) { append(row.empty() ? 0 : &row[0], row.size()); }
+
+	/// Get the values of all the rows.
+	std::vector<T>& getValues() { return values; }
+	const std::vector<T>& getValues() const { return values; }
+
+	/// Get the offsets, size() + 1 of them.
+	std::vector<int64_t>& getOffsets() { return offsets; }
+	const std::vector<int64_t>& getOffsets() const { return offsets; }
+
+private:
+
+	std::vector<T> values;
+	std::vector<int64_t> offsets;
+};
+
+}
+
+#endif
@@ -0,0 +1,299 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+/**
+ * Convert a FITS binary table to csv.
+ * The first line contains the column names. Without a header number
+ * the first binary table is converted. Scaled columns are written as
+ * their physical values, bits and logicals as 0 and 1. Variable length
+ * array columns are skipped.
+ */
+
+#include<iostream>
+#include<string>
+#include<sstream>
+#include<cstdlib>
+#include "InputFileFITS.h"
+#include "OutputFileText.h"
+
+using namespace qlbase;
+using namespace std;
+
+#define BLOCKROWS 65536
+
+string trim(const string& s, const string& delimiter)
+{
+	string ret(s);
+
+	size_t p = ret.find_first_not_of(delimiter);
+	ret.erase(0, p);
+
+	p = ret.find_last_not_of(delimiter);
+	if (string::npos != p)
+		ret.erase(p+1);
+
+	return ret;
+}
+
+std::string getValue(InputFileFITS& infile, const std::string name)
+{
+	for(int i=0; i<infile.getKeywordNum(); i++)
+	{
+		string keyword = infile.getKeyword(i);
+		string::size_type delim1 = keyword.find('=');
+		if(delim1 == string::npos || trim(keyword.substr(0, delim1), " \t").compare(name) != 0)
+			continue;
+		string::size_type delim2 = keyword.find("/", delim1);
+		return trim(keyword.substr(delim1+1, delim2-delim1-1), " \t\'");
+	}
+
+	return "";
+}
+
+// How a column is exported: read as the type of its physical values (with
+// TSCALn and TZEROn), written as a csv type that holds them.
+enum Conversion { PLAIN, UNSIGNED16, UNSIGNED32, UNSIGNED64, SCALED, FLAGS };
+
+struct Column
+{
+	int ncol;
+	field in;
+	field out;
+	Conversion conversion;
+};
+
+void writeValues(OutputFileText& f, int ncol, const uint8_t* b, long frow, long lrow, int vsize) { f.writeu8iv(ncol, b, frow, lrow, vsize); }
+void writeValues(OutputFileText& f, int ncol, const int16_t* b, long frow, long lrow, int vsize) { f.write16iv(ncol, b, frow, lrow, vsize); }
+void writeValues(OutputFileText& f, int ncol, const int32_t* b, long frow, long lrow, int vsize) { f.write32iv(ncol, b, frow, lrow, vsize); }
+void writeValues(OutputFileText& f, int ncol, const int64_t* b, long frow, long lrow, int vsize) { f.write64iv(ncol, b, frow, lrow, vsize); }
+void writeValues(OutputFileText& f, int ncol, const float* b, long frow, long lrow, int vsize) { f.write32fv(ncol, b, frow, lrow, vsize); }
+void writeValues(OutputFileText& f, int ncol, const double* b, long frow, long lrow, int vsize) { f.write64fv(ncol, b, frow, lrow, vsize); }
+
+// Read the values as T and write them as S.
+template<class T, class S>
+void copyValues(InputFileFITS& infile, OutputFileText& outfile, int ncol, int outcol, long frow, long lrow, int vsize)
+{
+	vector<T> values((lrow - frow + 1) * vsize);
+	infile.read(ncol, frow, lrow, &values[0], vsize);
+	vector<S> converted(values.begin(), values.end());
+	writeValues(outfile, outcol, &converted[0], frow, lrow, vsize);
+}
+
+// The csv writer has no unsigned 64 bit type, the values are written as text.
+void copyUnsigned64(InputFileFITS& infile, OutputFileText& outfile, int ncol, int outcol, long frow, long lrow)
+{
+	vector<uint64_t> values(lrow - frow + 1);
+	infile.read(ncol, frow, lrow, &values[0]);
+	vector< vector<char> > buff(values.size());
+	for(unsigned long i=0; i<values.size(); i++)
+	{
+		stringstream ss;
+		ss << values[i];
+		string s = ss.str();
+		buff[i].assign(s.begin(), s.end());
+	}
+	outfile.writeString(outcol, buff, frow, lrow);
+}
+
+// Bits and logicals are written as 0 and 1 bytes.
+void copyFlags(InputFileFITS& infile, OutputFileText& outfile, const Column& c, int outcol, long frow, long lrow)
+{
+	BitColumn bits;
+	if(c.in.type == BIT)
+		infile.readBits(c.ncol, frow, lrow, bits);
+	else
+		infile.readLogical(c.ncol, frow, lrow, bits);
+
+	int vsize = c.in.vsize;
+	vector<uint8_t> flags(bits.size() * vsize);
+	for(long row=0; row<bits.size(); row++)
+		for(int b=0; b<vsize; b++)
+			flags[row*vsize+b] = bits.test(row, b);
+	outfile.writeu8iv(outcol, &flags[0], frow, lrow, vsize);
+}
+
+void copyColumn(InputFileFITS& infile, OutputFileText& outfile, const Column& c, int outcol, long frow, long lrow)
+{
+	int ncol = c.ncol;
+	int vsize = c.in.vsize;
+	switch(c.conversion)
+	{
+		case UNSIGNED16: copyValues<uint16_t, int32_t>(infile, outfile, ncol, outcol, frow, lrow, vsize); return;
+		case UNSIGNED32: copyValues<uint32_t, int64_t>(infile, outfile, ncol, outcol, frow, lrow, vsize); return;
+		case UNSIGNED64: copyUnsigned64(infile, outfile, ncol, outcol, frow, lrow); return;
+		case SCALED: copyValues<double, double>(infile, outfile, ncol, outcol, frow, lrow, vsize); return;
+		case FLAGS: copyFlags(infile, outfile, c, outcol, frow, lrow); return;
+		default: break;
+	}
+
+	switch(c.in.type)
+	{
+		case UNSIGNED_INT8: copyValues<uint8_t, uint8_t>(infile, outfile, ncol, outcol, frow, lrow, vsize); break;
+		case INT16: copyValues<int16_t, int16_t>(infile, outfile, ncol, outcol, frow, lrow, vsize); break;
+		case INT32: copyValues<int32_t, int32_t>(infile, outfile, ncol, outcol, frow, lrow, vsize); break;
+		case INT64: copyValues<int64_t, int64_t>(infile, outfile, ncol, outcol, frow, lrow, vsize); break;
+		case FLOAT: copyValues<float, float>(infile, outfile, ncol, outcol, frow, lrow, vsize); break;
+		case DOUBLE: copyValues<double, double>(infile, outfile, ncol, outcol, frow, lrow, vsize); break;
+		case STRING:
+		{
+			// cfitsio writes the string terminator too
+			vector< vector<char> > buff = infile.readString(ncol, frow, lrow, vsize+1);
+			outfile.writeString(outcol, buff, frow, lrow);
+			break;
+		}
+		default: break;
+	}
+}
+
+// Choose how to export a column, false if it can't be.
+bool exportColumn(InputFileFITS& infile, Column& c)
+{
+	c.out = c.in;
+	c.conversion = PLAIN;
+	if(c.in.vsize == 0)
+		return false;
+
+	if(c.in.type == BIT || c.in.type == LOGICAL)
+	{
+		c.out.type = UNSIGNED_INT8;
+		c.conversion = FLAGS;
+		return true;
+	}
+
+	if(c.in.type == STRING || c.in.type == FLOAT || c.in.type == DOUBLE)
+		return true;
+
+	// the unsigned integers as written by OutputFileFITS::setUnsigned()
+	double scale, zero;
+	infile.getScaling(c.ncol, scale, zero);
+	if(scale == 1 && zero == 0)
+		return true;
+	if(scale == 1 && c.in.type == INT16 && zero == 32768.)
+	{
+		c.out.type = INT32;
+		c.conversion = UNSIGNED16;
+	}
+	else if(scale == 1 && c.in.type == INT32 && zero == 2147483648.)
+	{
+		c.out.type = INT64;
+		c.conversion = UNSIGNED32;
+	}
+	else if(scale == 1 && c.in.type == INT64 && zero == 9223372036854775808.)
+	{
+		if(c.in.vsize != 1)
+			return false;
+		c.out.type = STRING;
+		c.out.vsize = 20;
+		c.conversion = UNSIGNED64;
+	}
+	else
+	{
+		c.out.type = DOUBLE;
+		c.conversion = SCALED;
+	}
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc <= 2)
+	{
+		cout << "\nUsage: ./fits2csv fitsfile csvfile [header number]\n";
+		return 0;
+	}
+
+	try
+	{
+		InputFileFITS infile;
+		infile.open(argv[1]);
+
+		// find the table
+		int hdunum = -1;
+		if(argc > 3)
+			hdunum = atoi(argv[3]);
+		else
+		{
+			for(int i=0; i<infile.getHeadersNum() && hdunum < 0; i++)
+			{
+				infile.moveToHeader(i);
+				if(getValue(infile, "XTENSION").compare("BINTABLE") == 0)
+					hdunum = i;
+			}
+		}
+		if(hdunum < 0)
+		{
+			cerr << "No binary table in " << argv[1] << endl;
+			return 1;
+		}
+		infile.moveToHeader(hdunum);
+		if(getValue(infile, "XTENSION").compare("BINTABLE") != 0)
+		{
+			cerr << "Header " << hdunum << " is not a binary table" << endl;
+			return 1;
+		}
+
+		// the columns that can't be exported are skipped
+		vector<Column> columns;
+		vector<field> fields;
+		for(int i=0; i<infile.getNCols(); i++)
+		{
+			Column c;
+			c.ncol = i;
+			try
+			{
+				c.in = infile.getField(i);
+			}
+			catch(IOException& e)
+			{
+				cerr << "Skipping column " << i+1 << ", unsupported type" << endl;
+				continue;
+			}
+			if(!exportColumn(infile, c))
+			{
+				cerr << "Skipping column " << c.in.name << ", unsupported type" << endl;
+				continue;
+			}
+			columns.push_back(c);
+			fields.push_back(c.out);
+		}
+		if(columns.empty())
+		{
+			cerr << "No column to convert in " << argv[1] << endl;
+			return 1;
+		}
+
+		OutputFileText outfile(",");
+		outfile.writeColumnNames();
+		outfile.create(argv[2]);
+		outfile.createTable(getValue(infile, "EXTNAME"), fields);
+
+		long nrows = infile.getNRows();
+		for(long frow=0; frow<nrows; frow+=BLOCKROWS)
+		{
+			long lrow = frow + BLOCKROWS - 1 < nrows ? frow + BLOCKROWS - 1 : nrows - 1;
+			for(unsigned int i=0; i<columns.size(); i++)
+				copyColumn(infile, outfile, columns[i], i, frow, lrow);
+		}
+
+		outfile.close();
+		infile.close();
+	}
+	catch(IOException& e)
+	{
+		cerr << e.what() << endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,169 @@
+/***************************************************************************
+    begin                : Oct 19 2026
+    copyright            : (C) 2026 libQLBase developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software for non commercial purpose              *
+ *   and for public research institutes; you can redistribute it and/or    *
+ *   modify it under the terms of the GNU General Public License.          *
+ *   For commercial purpose see appropriate license terms                  *
+ *                                                                         *
+ ***************************************************************************/
+
+/**
+ * Benchmark the tile-compressed tables against the uncompressed ones.
+ * A telemetry-like table is written and read back, printing the MB/s of
+ * the uncompressed data and the compression ratio.
+ *
+ * Usage: tablebench [rows] [tile rows] [threads]
+ */
+
+#include<iostream>
+#include<iomanip>
+#include<string>
+#include<cstdlib>
+#include<cmath>
+#include<sys/stat.h>
+#include<unistd.h>
+#include "OutputFileFITS.h"
+#include "InputFileFITS.h"
+#include "mac_clock_gettime.h"
+
+using namespace qlbase;
+using namespace std;
+
+#define BLOCKROWS 65536
+
+struct Telemetry
+{
+	vector<double> time;
+	vector<int32_t> counts;
+	vector<int16_t> status;
+	vector<float> energy;
+	vector<uint8_t> flags;
+};
+
+vector<field> getFields()
+{
+	vector<field> fields(5);
+	fields[0].name = "TIME"; fields[0].type = DOUBLE; fields[0].vsize = 1; fields[0].unit = "s";
+	fields[1].name = "COUNTS"; fields[1].type = INT32; fields[1].vsize = 1;
+	fields[2].name = "STATUS"; fields[2].type = INT16; fields[2].vsize = 1;
+	fields[3].name = "ENERGY"; fields[3].type = FLOAT; fields[3].vsize = 1; fields[3].unit = "keV";
+	fields[4].name = "FLAGS"; fields[4].type = UNSIGNED_INT8; fields[4].vsize = 1;
+	return fields;
+}
+
+void fill(Telemetry& t, long frow, long nrows)
+{
+	t.time.resize(nrows);
+	t.counts.resize(nrows);
+	t.status.resize(nrows);
+	t.energy.resize(nrows);
+	t.flags.resize(nrows);
+	for(long i=0; i<nrows; i++)
+	{
+		long row = frow + i;
+		t.time[i] = 1.0e8 + row * 0.001;
+		t.counts[i] = 1000 + (int32_t) (50 * sin(row * 0.01)) + row % 7;
+		t.status[i] = (row / 1000) % 4;
+		t.energy[i] = 10.0f + (row % 97) * 0.25f;
+		t.flags[i] = row % 500 == 0;
+	}
+}
+
+long fileSize(const string& filename)
+{
+	struct stat st;
+	if(stat(filename.c_str(), &st) != 0)
+		return 0;
+	return st.st_size;
+}
+
+double write(const string& filename, long rows, long tileRows, int threads)
+{
+	OutputFileFITS file;
+	file.create(filename);
+	if(tileRows > 0)
+		file.setTableCompression(tileRows, threads);
+	file.createTable("EVENTS", getFields());
+
+	long start = gettimensec();
+	Telemetry t;
+	for(long frow=0; frow<rows; frow+=BLOCKROWS)
+	{
+		long lrow = min(frow + BLOCKROWS, rows) - 1;
+		fill(t, frow, lrow - frow + 1);
+		file.write64f(0, &t.time[0], frow, lrow);
+		file.write32i(1, &t.counts[0], frow, lrow);
+		file.write16i(2, &t.status[0], frow, lrow);
+		file.write32f(3, &t.energy[0], frow, lrow);
+		file.writeu8i(4, &t.flags[0], frow, lrow);
+	}
+	file.close();
+
+	return (gettimensec() - start) * 1e-9;
+}
+
+double read(const string& filename, long rows)
+{
+	long start = gettimensec();
+	InputFileFITS file;
+	file.open(filename);
+	file.moveToHeader(1);
+	for(long frow=0; frow<rows; frow+=BLOCKROWS)
+	{
+		long lrow = min(frow + BLOCKROWS, rows) - 1;
+		file.read64f(0, frow, lrow);
+		file.read32i(1, frow, lrow);
+		file.read16i(2, frow, lrow);
+		file.read32f(3, frow, lrow);
+		file.readu8i(4, frow, lrow);
+	}
+	file.close();
+
+	return (gettimensec() - start) * 1e-9;
+}
+
+int main(int argc, char** argv)
+{
+	long rows = argc > 1 ? atol(argv[1]) : 4000000;
+	long tileRows = argc > 2 ? atol(argv[2]) : 100000;
+	int threads = argc > 3 ? atoi(argv[3]) : 0;
+
+	// TIME, COUNTS, STATUS, ENERGY, FLAGS
+	double mbytes = rows * (8 + 4 + 2 + 4 + 1) / 1e6;
+
+	try
+	{
+		string plain("tablebench_plain.fits");
+		string tiled("tablebench_tiled.fits");
+		unlink(plain.c_str());
+		unlink(tiled.c_str());
+
+		double plainWrite = write(plain, rows, 0, threads);
+		double tiledWrite = write(tiled, rows, tileRows, threads);
+		double plainRead = read(plain, rows);
+		double tiledRead = read(tiled, rows);
+
+		cout << fixed << setprecision(1);
+		cout << rows << " rows, " << mbytes << " MB of data, " << tileRows << " rows per tile" << endl;
+		cout << "uncompressed: write " << mbytes / plainWrite << " MB/s, read " << mbytes / plainRead
+		     << " MB/s, " << fileSize(plain) / 1e6 << " MB" << endl;
+		cout << "compressed:   write " << mbytes / tiledWrite << " MB/s, read " << mbytes / tiledRead
+		     << " MB/s, " << fileSize(tiled) / 1e6 << " MB" << endl;
+		cout << setprecision(2) << "compression ratio: " << (double) fileSize(plain) / fileSize(tiled) << endl;
+
+		unlink(plain.c_str());
+		unlink(tiled.c_str());
+	}
+	catch(IOException& e)
+	{
+		cerr << e.what() << endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -15,14 +15,28 @@
 
 #include<IO/InputFileFITS.h>
 #include<IO/OutputFileFITS.h>
+#include<IO/InputFileText.h>
+#include<IO/TableAppender.h>
+#include<IO/RollingWriter.h>
+#include<IO/OutputFileSHM.h>
+#include<IO/InputFileSHM.h>
+#include<IO/FileFollower.h>
+#include<IO/TableSchema.h>
+#include<IO/PacketDecoder.h>
+#include<IO/BitColumn.h>
 #include<sstream>
 #include<fstream>
 #include<iomanip>
+#include<algorithm>
+#include<cstring>
+#include<cstdlib>
 #include<iostream>
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE MyTest
 #include <boost/test/unit_test.hpp>
 #include<unistd.h>
+#include<sys/stat.h>
+#include<sys/wait.h>
 
 static const std::string keywords[] = {
 "XTENSION= 'BINTABLE'           / binary table extension",
@@ -281,12 +295,32 @@ BOOST_AUTO_TEST_CASE(output_file_fits)
 	}
 	BOOST_CHECK_NO_THROW(ofile.write32fv(10, vectors, 0, NROW-1));
 
+	// missing or short rows should raise an exception
+	BOOST_CHECK_THROW(ofile.write32fv(10, vectors, 0, NROW), qlbase::IOException);
+	std::vector< std::vector<float> > ragged(vectors);
+	ragged[3].resize(6);
+	BOOST_CHECK_THROW(ofile.write32fv(10, ragged, 0, NROW-1), qlbase::IOException);
+	std::vector<int32_t> noValues;
+	BOOST_CHECK_THROW(ofile.write32i(0, noValues, 0, NROW-1), qlbase::IOException);
+	BOOST_CHECK_THROW(ofile.write32i(0, colsi[0], 0, NROW), qlbase::IOException);
+
+	// writing from flat caller memory shouldn't raise an exception
+	std::vector<float> flat(5*12);
+	for(unsigned int i=0; i<flat.size(); i++)
+		flat[i] = i;
+	const float* flatptr = &flat[0];
+	BOOST_CHECK_NO_THROW(ofile.write32fv(10, flatptr, 5, 9, 12));
+	const int32_t ids[] = { -1, -2, -3 };
+	BOOST_CHECK_NO_THROW(ofile.write32i(0, ids, 7, 9));
+
 	std::vector< std::vector<char> > vectorStr;
 	for(unsigned int row=0; row<NROW; row++)
 	{
 		std::vector<char> v(20, 'a'+row);
 		vectorStr.push_back(v);
 	}
+	// a short first row shouldn't truncate the next ones
+	vectorStr[0].assign(1, 'a');
 	BOOST_CHECK_NO_THROW(ofile.close());
 	BOOST_CHECK_NO_THROW(ofile.open("testing.fits"));
 	BOOST_CHECK_NO_THROW(ofile.writeString(11, vectorStr, 0, NROW-1));
@@ -301,5 +335,1246 @@ BOOST_AUTO_TEST_CASE(output_file_fits)
 	// closing the file shouldn't raise an exception
 	BOOST_CHECK_NO_THROW(ofile.close());
 
+	// the flat writes should be read back row after row
+	qlbase::InputFileFITS ifile;
+	BOOST_CHECK_NO_THROW(ifile.open("testing.fits"));
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(1));
+	std::vector< std::vector<float> > readVectors;
+	BOOST_CHECK_NO_THROW(readVectors = ifile.read32fv(10, 0, NROW-1, 12));
+	for(unsigned int row=0; row<NROW; row++)
+		for(unsigned int i=0; i<12; i++)
+			BOOST_CHECK_EQUAL(readVectors[row][i], row < 5 ? (float)row : flat[(row-5)*12+i]);
+	std::vector<int32_t> readIds;
+	BOOST_CHECK_NO_THROW(readIds = ifile.read32i(0, 6, 9));
+	BOOST_CHECK_EQUAL(readIds[0], 6);
+	BOOST_CHECK_EQUAL(readIds[1], -1);
+	BOOST_CHECK_EQUAL(readIds[3], -3);
+	std::vector< std::vector<char> > readStrings;
+	BOOST_CHECK_NO_THROW(readStrings = ifile.readString(11, 0, 1, 20));
+	BOOST_CHECK_EQUAL(std::string(readStrings[0].data()), "a");
+	BOOST_CHECK_EQUAL(std::string(readStrings[1].begin(), readStrings[1].end()), std::string(20, 'b'));
+	BOOST_CHECK_NO_THROW(ifile.close());
+
 	unlink("testing.fits");
 }
+
+BOOST_AUTO_TEST_CASE(input_file_fits_follow)
+{
+	std::vector<qlbase::field> fields(1);
+	fields[0].name = "counter";
+	fields[0].type = qlbase::INT32;
+	fields[0].vsize = 1;
+	fields[0].unit = "";
+
+	std::vector<int32_t> counters(5);
+	for(unsigned int i=0; i<counters.size(); i++)
+		counters[i] = i;
+
+	qlbase::OutputFileFITS ofile;
+	BOOST_CHECK_NO_THROW(ofile.create("follow.fits"));
+	BOOST_CHECK_NO_THROW(ofile.createTable("follow", fields));
+	BOOST_CHECK_NO_THROW(ofile.write32i(0, counters, 0, 2));
+	BOOST_CHECK_NO_THROW(ofile.close());
+
+	qlbase::InputFileFITS file;
+	BOOST_CHECK_NO_THROW(file.open("follow.fits"));
+	BOOST_CHECK_NO_THROW(file.moveToHeader(1));
+	BOOST_CHECK_EQUAL(file.getNRows(), 3);
+
+	// the file didn't change
+	BOOST_CHECK_EQUAL(file.refresh(), 0);
+
+	// append two rows
+	std::vector<int32_t> appended(counters.begin()+3, counters.end());
+	BOOST_CHECK_NO_THROW(ofile.open("follow.fits"));
+	BOOST_CHECK_NO_THROW(ofile.moveToHeader(1));
+	BOOST_CHECK_NO_THROW(ofile.write32i(0, appended, 3, 4));
+	BOOST_CHECK_NO_THROW(ofile.close());
+
+	// the new rows should be visible without reopening the input file
+	BOOST_CHECK_EQUAL(file.refresh(), 2);
+	BOOST_CHECK_EQUAL(file.getNRows(), 5);
+	std::vector<int32_t> rows;
+	BOOST_CHECK_NO_THROW(rows = file.read32i(0, 3, 4));
+	BOOST_CHECK_EQUAL_COLLECTIONS(rows.begin(), rows.end(), appended.begin(), appended.end());
+
+	BOOST_CHECK_NO_THROW(file.close());
+	unlink("follow.fits");
+}
+
+BOOST_AUTO_TEST_CASE(input_file_text_image_like_fits)
+{
+	qlbase::InputFileFITS fits;
+	BOOST_CHECK_NO_THROW(fits.open("sample.fits"));
+	BOOST_CHECK_NO_THROW(fits.moveToHeader(2));
+	qlbase::Image<float> expected;
+	BOOST_CHECK_NO_THROW(expected = fits.readImage32f());
+	BOOST_CHECK_NO_THROW(fits.close());
+
+	// the text image should have the same layout of the FITS one, img.csv
+	// stores the values with 5 decimals.
+	qlbase::InputFileText text;
+	BOOST_CHECK_NO_THROW(text.open("img.csv"));
+	qlbase::Image<float> img;
+	BOOST_CHECK_NO_THROW(img = text.readImage32f());
+	BOOST_CHECK_NO_THROW(text.close());
+
+	BOOST_CHECK_EQUAL(img.dim, expected.dim);
+	BOOST_CHECK_EQUAL_COLLECTIONS(img.sizes.begin(), img.sizes.end(), expected.sizes.begin(), expected.sizes.end());
+	BOOST_REQUIRE_EQUAL(img.data.size(), expected.data.size());
+	for(unsigned int i=0; i<img.data.size(); i++)
+		BOOST_CHECK_SMALL(img.data[i] - expected.data[i], 1e-5f);
+}
+
+BOOST_AUTO_TEST_CASE(table_appender)
+{
+	qlbase::OutputFileFITS ofile;
+	BOOST_CHECK_NO_THROW(ofile.create("appender.fits"));
+
+	std::vector<qlbase::field> fields(3);
+	fields[0].name = "time";   fields[0].type = qlbase::DOUBLE; fields[0].vsize = 1;
+	fields[1].name = "counts"; fields[1].type = qlbase::INT16;  fields[1].vsize = 4;
+	fields[2].name = "label";  fields[2].type = qlbase::STRING; fields[2].vsize = 8;
+	BOOST_CHECK_NO_THROW(ofile.createTable("PACKETS", fields));
+	BOOST_CHECK_NO_THROW(ofile.moveToHeader(1));
+
+	const long NROWS = 1000;
+	{
+		qlbase::TableAppender appender(ofile, fields, 64);
+		BOOST_CHECK_EQUAL(appender.getBlockRows(), 64);
+
+		// setting a value of a wrong column should raise an exception
+		BOOST_CHECK_THROW(appender.set(3, 1.0), qlbase::IOException);
+
+		// single rows
+		for(long row=0; row<NROWS/2; row++)
+		{
+			int32_t counts[4] = { (int32_t) row, 1, 2, 3 };
+			appender.set(0, row * 0.5);
+			appender.set(1, counts);
+			appender.set(2, "packet");
+			appender.endRows();
+		}
+
+		// a batch larger than the block
+		std::vector<double> times(NROWS/2);
+		std::vector<int16_t> counts(NROWS/2*4);
+		for(long row=0; row<NROWS/2; row++)
+		{
+			times[row] = (row + NROWS/2) * 0.5;
+			counts[row*4] = row + NROWS/2;
+			counts[row*4+1] = 1; counts[row*4+2] = 2; counts[row*4+3] = 3;
+		}
+		BOOST_CHECK_NO_THROW(appender.setRows(0, &times[0], NROWS/2));
+		BOOST_CHECK_NO_THROW(appender.setRows(1, &counts[0], NROWS/2));
+		BOOST_CHECK_NO_THROW(appender.endRows(NROWS/2));
+		BOOST_CHECK_EQUAL(appender.getNRows(), NROWS);
+		BOOST_CHECK_NO_THROW(appender.flush());
+		BOOST_CHECK_EQUAL(ofile.getNRows(), NROWS);
+	}
+	BOOST_CHECK_NO_THROW(ofile.close());
+
+	qlbase::InputFileFITS ifile;
+	BOOST_CHECK_NO_THROW(ifile.open("appender.fits"));
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(1));
+	BOOST_CHECK_EQUAL(ifile.getNRows(), NROWS);
+	std::vector<double> times;
+	BOOST_CHECK_NO_THROW(times = ifile.read64f(0, 0, NROWS-1));
+	std::vector< std::vector<int16_t> > counts;
+	BOOST_CHECK_NO_THROW(counts = ifile.read16iv(1, 0, NROWS-1, 4));
+	for(long row=0; row<NROWS; row++)
+	{
+		BOOST_CHECK_EQUAL(times[row], row * 0.5);
+		BOOST_CHECK_EQUAL(counts[row][0], row);
+		BOOST_CHECK_EQUAL(counts[row][3], 3);
+	}
+	std::vector< std::vector<char> > labels;
+	BOOST_CHECK_NO_THROW(labels = ifile.readString(2, 0, 1, 9));
+	BOOST_CHECK_EQUAL(std::string(&labels[0][0]), "packet");
+	BOOST_CHECK_NO_THROW(ifile.close());
+
+	unlink("appender.fits");
+}
+
+BOOST_AUTO_TEST_CASE(table_appender_async)
+{
+	qlbase::OutputFileFITS ofile;
+	BOOST_CHECK_NO_THROW(ofile.create("appender.fits"));
+
+	std::vector<qlbase::field> fields(2);
+	fields[0].name = "time";   fields[0].type = qlbase::DOUBLE; fields[0].vsize = 1;
+	fields[1].name = "counts"; fields[1].type = qlbase::INT32;  fields[1].vsize = 1;
+	BOOST_CHECK_NO_THROW(ofile.createTable("PACKETS", fields));
+
+	const long NROWS = 10000;
+	{
+		qlbase::TableAppender appender(ofile, fields, 100);
+		BOOST_CHECK_NO_THROW(appender.startAsync(2, qlbase::TableAppender::BLOCK));
+
+		// starting twice should raise an exception
+		BOOST_CHECK_THROW(appender.startAsync(), qlbase::IOException);
+
+		for(long row=0; row<NROWS; row++)
+		{
+			appender.set(0, row * 0.5);
+			appender.set(1, row);
+			appender.endRows();
+		}
+		BOOST_CHECK_NO_THROW(appender.stopAsync());
+
+		// with blocking backpressure no rows should be dropped
+		qlbase::TableAppender::Stats stats = appender.getStats();
+		BOOST_CHECK_EQUAL(stats.writtenRows, NROWS);
+		BOOST_CHECK_EQUAL(stats.droppedRows, 0);
+		BOOST_CHECK(stats.queueDepthMax <= 2);
+		BOOST_CHECK_EQUAL(stats.queueDepth, 0);
+	}
+	BOOST_CHECK_NO_THROW(ofile.close());
+
+	qlbase::InputFileFITS ifile;
+	BOOST_CHECK_NO_THROW(ifile.open("appender.fits"));
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(1));
+	BOOST_CHECK_EQUAL(ifile.getNRows(), NROWS);
+	std::vector<int32_t> counts;
+	BOOST_CHECK_NO_THROW(counts = ifile.read32i(1, 0, NROWS-1));
+	for(long row=0; row<NROWS; row++)
+		BOOST_CHECK_EQUAL(counts[row], row);
+	BOOST_CHECK_NO_THROW(ifile.close());
+
+	unlink("appender.fits");
+}
+
+BOOST_AUTO_TEST_CASE(output_file_fits_reserve)
+{
+	qlbase::OutputFileFITS ofile;
+	BOOST_CHECK_NO_THROW(ofile.create("reserve.fits"));
+
+	std::vector<qlbase::field> fields(1);
+	fields[0].name = "counts"; fields[0].type = qlbase::INT32; fields[0].vsize = 1;
+	BOOST_CHECK_NO_THROW(ofile.createTable("COUNTS", fields));
+
+	// preallocated rows shouldn't be counted
+	BOOST_CHECK_NO_THROW(ofile.setGrowthStep(1000));
+	BOOST_CHECK_NO_THROW(ofile.reserveRows(5000));
+	BOOST_CHECK_EQUAL(ofile.getNRows(), 0);
+
+	std::vector<int32_t> counts(10);
+	for(long frow=0; frow<6000; frow+=10)
+	{
+		for(int i=0; i<10; i++)
+			counts[i] = frow + i;
+		BOOST_CHECK_NO_THROW(ofile.write32i(0, counts, frow, frow+9));
+	}
+	BOOST_CHECK_EQUAL(ofile.getNRows(), 6000);
+	BOOST_CHECK_NO_THROW(ofile.reserveRows(10000));
+	BOOST_CHECK_NO_THROW(ofile.close());
+
+	// closing should remove the rows not written
+	qlbase::InputFileFITS ifile;
+	BOOST_CHECK_NO_THROW(ifile.open("reserve.fits"));
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(1));
+	BOOST_CHECK_EQUAL(ifile.getNRows(), 6000);
+	std::vector<int32_t> readCounts;
+	BOOST_CHECK_NO_THROW(readCounts = ifile.read32i(0, 5990, 5999));
+	BOOST_CHECK_EQUAL(readCounts[9], 5999);
+	BOOST_CHECK_NO_THROW(ifile.close());
+
+	unlink("reserve.fits");
+}
+
+BOOST_AUTO_TEST_CASE(output_file_fits_image)
+{
+	qlbase::InputFileFITS sample;
+	BOOST_CHECK_NO_THROW(sample.open("sample.fits"));
+	BOOST_CHECK_NO_THROW(sample.moveToHeader(2));
+	qlbase::Image<float> img;
+	BOOST_CHECK_NO_THROW(img = sample.readImage32f());
+	BOOST_CHECK_NO_THROW(sample.close());
+
+	qlbase::Image<int16_t> counts;
+	counts.dim = 2;
+	counts.sizes.push_back(300);
+	counts.sizes.push_back(200);
+	for(int i=0; i<300*200; i++)
+		counts.data.push_back(i % 1000 - 500);
+
+	qlbase::OutputFileFITS ofile;
+	BOOST_CHECK_NO_THROW(ofile.create("image.fits"));
+	BOOST_CHECK_NO_THROW(ofile.createImage(qlbase::FLOAT, img.sizes));
+	BOOST_CHECK_NO_THROW(ofile.writeImage32f(img));
+
+	// the second row of the region should be written after the first one
+	qlbase::Image<int16_t> region;
+	region.dim = 2;
+	region.sizes.push_back(2);
+	region.sizes.push_back(2);
+	region.data.push_back(1); region.data.push_back(2);
+	region.data.push_back(3); region.data.push_back(4);
+	std::vector<int64_t> first(2);
+	first[0] = 1; first[1] = 2;
+	BOOST_CHECK_NO_THROW(ofile.createImage(qlbase::INT16, counts.sizes));
+	BOOST_CHECK_NO_THROW(ofile.writeImage16i(counts));
+	BOOST_CHECK_NO_THROW(ofile.writeImage16i(region, first));
+
+	// tiles compressed in parallel
+	std::vector<long> tiles(2);
+	tiles[0] = 100; tiles[1] = 16;
+	BOOST_CHECK_NO_THROW(ofile.setImageCompression(qlbase::OutputFileFITS::GZIP, tiles, 4));
+	BOOST_CHECK_NO_THROW(ofile.createImage(qlbase::FLOAT, img.sizes));
+	BOOST_CHECK_NO_THROW(ofile.writeImage32f(img));
+	BOOST_CHECK_NO_THROW(ofile.setImageCompression(qlbase::OutputFileFITS::RICE, tiles, 4));
+	BOOST_CHECK_NO_THROW(ofile.createImage(qlbase::INT16, counts.sizes));
+	BOOST_CHECK_THROW(ofile.writeImage16i(region, first), qlbase::IOException);
+	BOOST_CHECK_NO_THROW(ofile.writeImage16i(counts));
+
+	// RICE of floating point images is lossy, and not defined for 64 bit ones
+	BOOST_CHECK_THROW(ofile.createImage(qlbase::FLOAT, img.sizes), qlbase::IOException);
+	BOOST_CHECK_THROW(ofile.createImage(qlbase::INT64, counts.sizes), qlbase::IOException);
+	BOOST_CHECK_NO_THROW(ofile.close());
+
+	qlbase::InputFileFITS ifile;
+	BOOST_CHECK_NO_THROW(ifile.open("image.fits"));
+	qlbase::Image<float> readImg;
+	qlbase::Image<int16_t> readCounts;
+
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(0));
+	BOOST_CHECK_NO_THROW(readImg = ifile.readImage32f());
+	BOOST_CHECK_EQUAL_COLLECTIONS(readImg.data.begin(), readImg.data.end(), img.data.begin(), img.data.end());
+
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(1));
+	BOOST_CHECK_NO_THROW(readCounts = ifile.readImage16i());
+	BOOST_CHECK_EQUAL(readCounts.data[2*300+1], 1);
+	BOOST_CHECK_EQUAL(readCounts.data[2*300+2], 2);
+	BOOST_CHECK_EQUAL(readCounts.data[3*300+1], 3);
+	BOOST_CHECK_EQUAL(readCounts.data[3*300+2], 4);
+	BOOST_CHECK_EQUAL(readCounts.data[3*300+3], counts.data[3*300+3]);
+
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(2));
+	BOOST_CHECK_NO_THROW(readImg = ifile.readImage32f());
+	BOOST_CHECK_EQUAL_COLLECTIONS(readImg.data.begin(), readImg.data.end(), img.data.begin(), img.data.end());
+
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(3));
+	BOOST_CHECK_NO_THROW(readCounts = ifile.readImage16i());
+	BOOST_CHECK_EQUAL_COLLECTIONS(readCounts.sizes.begin(), readCounts.sizes.end(), counts.sizes.begin(), counts.sizes.end());
+	BOOST_CHECK_EQUAL_COLLECTIONS(readCounts.data.begin(), readCounts.data.end(), counts.data.begin(), counts.data.end());
+	BOOST_CHECK_NO_THROW(ifile.close());
+
+	unlink("image.fits");
+}
+
+BOOST_AUTO_TEST_CASE(output_file_fits_compressed_table)
+{
+	std::vector<qlbase::field> fields(3);
+	fields[0].name = "counts"; fields[0].type = qlbase::INT32; fields[0].vsize = 1;
+	fields[1].name = "energy"; fields[1].type = qlbase::DOUBLE; fields[1].vsize = 2;
+	fields[2].name = "label"; fields[2].type = qlbase::STRING; fields[2].vsize = 8;
+
+	qlbase::OutputFileFITS ofile;
+	BOOST_CHECK_NO_THROW(ofile.create("tiled.fits"));
+	BOOST_CHECK_NO_THROW(ofile.setTableCompression(100, 4));
+	BOOST_CHECK_THROW(ofile.setColumnCompression(qlbase::DOUBLE, qlbase::OutputFileFITS::RICE), qlbase::IOException);
+	BOOST_CHECK_NO_THROW(ofile.createTable("TILED", fields));
+
+	// 10 full tiles and a shorter one
+	const long nrows = 1050;
+	std::vector<int32_t> counts(nrows);
+	std::vector<double> energy(nrows*2);
+	std::vector< std::vector<char> > labels(nrows, std::vector<char>(8, 'x'));
+	for(long row=0; row<nrows; row++)
+	{
+		counts[row] = row % 13;
+		energy[row*2] = row * 0.5;
+		energy[row*2+1] = -row;
+		labels[row][0] = 'a' + row % 26;
+	}
+	BOOST_CHECK_NO_THROW(ofile.write32i(0, &counts[0], 0, 499));
+	BOOST_CHECK_NO_THROW(ofile.write32i(0, &counts[500], 500, nrows-1));
+	BOOST_CHECK_NO_THROW(ofile.write64fv(1, &energy[0], 0, nrows-1, 2));
+	BOOST_CHECK_NO_THROW(ofile.writeString(2, labels, 0, nrows-1));
+	BOOST_CHECK_EQUAL(ofile.getNRows(), nrows);
+
+	// the complete tiles are already compressed
+	BOOST_CHECK_THROW(ofile.write32i(0, &counts[0], 0, 0), qlbase::IOException);
+	BOOST_CHECK_NO_THROW(ofile.close());
+
+	qlbase::InputFileFITS ifile;
+	BOOST_CHECK_NO_THROW(ifile.open("tiled.fits"));
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(1));
+	BOOST_CHECK_EQUAL(ifile.getNRows(), nrows);
+	std::vector<int32_t> readCounts;
+	BOOST_CHECK_NO_THROW(readCounts = ifile.read32i(0, 0, nrows-1));
+	BOOST_CHECK_EQUAL_COLLECTIONS(readCounts.begin(), readCounts.end(), counts.begin(), counts.end());
+	std::vector< std::vector<double> > readEnergy;
+	BOOST_CHECK_NO_THROW(readEnergy = ifile.read64fv(1, 1040, 1049, 2));
+	BOOST_CHECK_EQUAL(readEnergy[9][0], 1049 * 0.5);
+	BOOST_CHECK_EQUAL(readEnergy[9][1], -1049);
+	std::vector< std::vector<char> > readLabels;
+	BOOST_CHECK_NO_THROW(readLabels = ifile.readString(2, 27, 27, 9));
+	BOOST_CHECK_EQUAL(std::string(&readLabels[0][0]), "bxxxxxxx");
+	BOOST_CHECK_NO_THROW(ifile.close());
+
+	// the uncompressed copy is charged to the reader budget, 28 bytes rows
+	qlbase::MemoryBudget tables("tables");
+	ifile.setMemoryBudget(&tables);
+	BOOST_CHECK_NO_THROW(ifile.open("tiled.fits"));
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(1));
+	BOOST_CHECK_EQUAL(tables.getUsed(), nrows * 28);
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(0));
+	BOOST_CHECK_EQUAL(tables.getUsed(), 0);
+	tables.setLimit(16 << 10);
+	BOOST_CHECK_THROW(ifile.moveToHeader(1), qlbase::IOException);
+	BOOST_CHECK_EQUAL(tables.getUsed(), 0);
+	BOOST_CHECK_NO_THROW(ifile.close());
+
+	unlink("tiled.fits");
+}
+
+BOOST_AUTO_TEST_CASE(output_file_fits_keywords)
+{
+	std::vector<qlbase::field> fields(1);
+	fields[0].name = "counts"; fields[0].type = qlbase::INT32; fields[0].vsize = 1;
+
+	qlbase::OutputFileFITS ofile;
+	BOOST_CHECK_NO_THROW(ofile.create("keywords.fits"));
+	BOOST_CHECK_NO_THROW(ofile.createTable("COUNTS", fields));
+
+	qlbase::KeywordBatch keywords;
+	BOOST_CHECK_NO_THROW(keywords.addString("telescop", "AGILE", "telescope name"));
+	BOOST_CHECK_NO_THROW(keywords.addDouble("TSTART", 1.5e8, "start time"));
+	BOOST_CHECK_NO_THROW(keywords.addInt("NEVENTS", 1000));
+	BOOST_CHECK_NO_THROW(keywords.addBool("CALIB", true));
+	BOOST_CHECK_NO_THROW(keywords.addHistory("written by the keywords test"));
+	BOOST_CHECK_THROW(keywords.addInt("TOO_LONG_NAME", 1), qlbase::IOException);
+	BOOST_CHECK_NO_THROW(ofile.writeKeywords(keywords));
+
+	// existing keywords are updated
+	keywords.clear();
+	BOOST_CHECK_NO_THROW(keywords.addInt("NEVENTS", 2000, "events"));
+	BOOST_CHECK_NO_THROW(ofile.writeKeywords(keywords));
+
+	// long strings and HIERARCH keywords are updated too, not duplicated
+	keywords.clear();
+	BOOST_CHECK_NO_THROW(keywords.addCard("LONGSTRN= 'OGIP 1.0'"));
+	BOOST_CHECK_NO_THROW(keywords.addCard("OBJECT  = 'first&'"));
+	BOOST_CHECK_NO_THROW(keywords.addCard("CONTINUE  'second&'"));
+	BOOST_CHECK_NO_THROW(keywords.addCard("CONTINUE  'third'"));
+	BOOST_CHECK_NO_THROW(keywords.addCard("HIERARCH ESO DET CHIP = 'CCD1'"));
+	BOOST_CHECK_NO_THROW(ofile.writeKeywords(keywords));
+	keywords.clear();
+	BOOST_CHECK_NO_THROW(keywords.addCard("OBJECT  = 'one&'"));
+	BOOST_CHECK_NO_THROW(keywords.addCard("CONTINUE  'two&'"));
+	BOOST_CHECK_NO_THROW(keywords.addCard("CONTINUE  'three'"));
+	BOOST_CHECK_NO_THROW(keywords.addCard("HIERARCH ESO DET CHIP = 'CCD2'"));
+	BOOST_CHECK_NO_THROW(ofile.writeKeywords(keywords));
+
+	// nothing is written when the batch has a protected keyword
+	keywords.clear();
+	BOOST_CHECK_NO_THROW(keywords.addInt("OBS_ID", 10));
+	BOOST_CHECK_NO_THROW(keywords.addInt("NAXIS2", 10));
+	BOOST_CHECK_THROW(ofile.writeKeywords(keywords), qlbase::IOException);
+	BOOST_CHECK_NO_THROW(ofile.close());
+
+	// copy the keywords to another file, without the table ones
+	qlbase::InputFileFITS ifile;
+	BOOST_CHECK_NO_THROW(ifile.open("keywords.fits"));
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(1));
+	BOOST_CHECK_NO_THROW(ofile.create("keywords_copy.fits"));
+	fields[0].name = "other"; fields[0].type = qlbase::DOUBLE;
+	BOOST_CHECK_NO_THROW(ofile.createTable("OTHER", fields));
+	BOOST_CHECK_NO_THROW(ofile.copyKeywords(ifile));
+	BOOST_CHECK_NO_THROW(ofile.close());
+	BOOST_CHECK_NO_THROW(ifile.close());
+
+	BOOST_CHECK_NO_THROW(ifile.open("keywords_copy.fits"));
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(1));
+	std::vector<std::string> cards;
+	for(int i=0; i<ifile.getKeywordNum(); i++)
+		cards.push_back(ifile.getKeyword(i));
+	BOOST_CHECK(std::find(cards.begin(), cards.end(), "TELESCOP= 'AGILE   '           / telescope name") != cards.end());
+	BOOST_CHECK(std::find(cards.begin(), cards.end(), "TSTART  =          150000000. / start time") != cards.end());
+	BOOST_CHECK(std::find(cards.begin(), cards.end(), "NEVENTS =                 2000 / events") != cards.end());
+	BOOST_CHECK(std::find(cards.begin(), cards.end(), "CALIB   =                    T") != cards.end());
+	BOOST_CHECK(std::find(cards.begin(), cards.end(), "HISTORY written by the keywords test") != cards.end());
+	BOOST_CHECK(std::find(cards.begin(), cards.end(), "EXTNAME = 'OTHER   '           / name of this binary table extension") != cards.end());
+	BOOST_CHECK(std::find(cards.begin(), cards.end(), "EXTNAME = 'COUNTS  '           / name of this binary table extension") == cards.end());
+	std::vector<std::string>::iterator object = std::find(cards.begin(), cards.end(), "OBJECT  = 'one&'");
+	BOOST_REQUIRE(object != cards.end() && cards.end() - object > 2);
+	BOOST_CHECK_EQUAL(object[1], "CONTINUE  'two&'");
+	BOOST_CHECK_EQUAL(object[2], "CONTINUE  'three'");
+	BOOST_CHECK_EQUAL(std::count(cards.begin(), cards.end(), "CONTINUE  'second&'"), 0);
+	BOOST_CHECK_EQUAL(std::count(cards.begin(), cards.end(), "CONTINUE  'third'"), 0);
+	BOOST_CHECK_EQUAL(std::count(cards.begin(), cards.end(), "HIERARCH ESO DET CHIP = 'CCD2'"), 1);
+	BOOST_CHECK_EQUAL(std::count(cards.begin(), cards.end(), "HIERARCH ESO DET CHIP = 'CCD1'"), 0);
+	BOOST_CHECK(std::find(cards.begin(), cards.end(), "TTYPE1  = 'counts  '           / label for field   1") == cards.end());
+	BOOST_CHECK(std::find(cards.begin(), cards.end(), "OBS_ID  =                   10") == cards.end());
+	BOOST_CHECK_NO_THROW(ifile.close());
+
+	unlink("keywords.fits");
+	unlink("keywords_copy.fits");
+}
+
+BOOST_AUTO_TEST_CASE(rolling_writer)
+{
+	std::vector<qlbase::field> fields(2);
+	fields[0].name = "counts"; fields[0].type = qlbase::INT32; fields[0].vsize = 1;
+	fields[1].name = "energy"; fields[1].type = qlbase::FLOAT; fields[1].vsize = 2;
+
+	unlink("rolling.manifest");
+	qlbase::RollingWriter writer("rolling", "EVENTS", fields);
+	writer.setMaxRows(100);
+	BOOST_CHECK_NO_THROW(writer.open());
+	BOOST_CHECK_EQUAL(writer.getFileName(), "rolling_000000.fits");
+
+	// 5 blocks of 50 rows: 100, 100 and 50 rows
+	std::vector<int32_t> counts(50);
+	std::vector<float> energy(100);
+	for(int block=0; block<5; block++)
+	{
+		for(int i=0; i<50; i++)
+		{
+			counts[i] = block * 50 + i;
+			energy[i*2] = energy[i*2+1] = counts[i] * 0.5f;
+		}
+		BOOST_CHECK_NO_THROW(writer.write(0, &counts[0], 50));
+		BOOST_CHECK_NO_THROW(writer.write(1, &energy[0], 50, 2));
+		BOOST_CHECK_NO_THROW(writer.endRows(50));
+	}
+	BOOST_CHECK_EQUAL(writer.getFileNum(), 2);
+	BOOST_CHECK_EQUAL(writer.getFileRows(), 50);
+	BOOST_CHECK_NO_THROW(writer.close());
+
+	// the next file created in advance should be removed
+	BOOST_CHECK(access("rolling_000003.fits", F_OK) != 0);
+
+	std::ifstream manifest("rolling.manifest");
+	std::vector<std::string> lines;
+	std::string line;
+	while(std::getline(manifest, line))
+		lines.push_back(line);
+	BOOST_REQUIRE_EQUAL(lines.size(), 4);
+	BOOST_CHECK_EQUAL(lines[0], "file,rows,bytes,start,end");
+	BOOST_CHECK_EQUAL(lines[2].substr(0, lines[2].find(",", lines[2].find(",")+1)), "rolling_000001.fits,100");
+	BOOST_CHECK_EQUAL(lines[3].substr(0, lines[3].find(",", lines[3].find(",")+1)), "rolling_000002.fits,50");
+
+	// the preallocated rows should be removed on close
+	qlbase::InputFileFITS ifile;
+	BOOST_CHECK_NO_THROW(ifile.open("rolling_000001.fits"));
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(1));
+	BOOST_CHECK_EQUAL(ifile.getNRows(), 100);
+	std::vector<int32_t> readCounts;
+	BOOST_CHECK_NO_THROW(readCounts = ifile.read32i(0, 0, 99));
+	BOOST_CHECK_EQUAL(readCounts[0], 100);
+	BOOST_CHECK_EQUAL(readCounts[99], 199);
+	BOOST_CHECK_NO_THROW(ifile.close());
+
+	for(int i=0; i<3; i++)
+	{
+		std::ostringstream name;
+		name << "rolling_00000" << i << ".fits";
+		unlink(name.str().c_str());
+	}
+	unlink("rolling.manifest");
+
+	// a failed background creation should keep the writer on its file until
+	// the next one can be created (a directory takes the name of file 2)
+	unlink("rollfail.manifest");
+	mkdir("rollfail_000002.fits", 0700);
+	qlbase::RollingWriter failing("rollfail", "EVENTS", fields);
+	failing.setMaxRows(10);
+	BOOST_CHECK_NO_THROW(failing.open());
+	for(int block=0; block<4; block++)
+	{
+		BOOST_CHECK_NO_THROW(failing.write(0, &counts[0], 10));
+		BOOST_CHECK_NO_THROW(failing.write(1, &energy[0], 10, 2));
+		if(block == 0)
+			BOOST_CHECK_NO_THROW(failing.endRows(10));
+		else
+			BOOST_CHECK_THROW(failing.endRows(10), qlbase::IOException);
+		BOOST_CHECK_EQUAL(failing.getFileNum(), 1);
+	}
+	rmdir("rollfail_000002.fits");
+	BOOST_CHECK_NO_THROW(failing.write(0, &counts[0], 10));
+	BOOST_CHECK_NO_THROW(failing.write(1, &energy[0], 10, 2));
+	BOOST_CHECK_NO_THROW(failing.endRows(10));
+	BOOST_CHECK_EQUAL(failing.getFileNum(), 2);
+	BOOST_CHECK_NO_THROW(failing.close());
+
+	BOOST_CHECK_NO_THROW(ifile.open("rollfail_000001.fits"));
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(1));
+	BOOST_CHECK_EQUAL(ifile.getNRows(), 50);
+	BOOST_CHECK_NO_THROW(ifile.close());
+
+	for(int i=0; i<3; i++)
+	{
+		std::ostringstream name;
+		name << "rollfail_00000" << i << ".fits";
+		unlink(name.str().c_str());
+	}
+	unlink("rollfail.manifest");
+}
+
+BOOST_AUTO_TEST_CASE(memory_file_fits)
+{
+	std::vector<qlbase::field> fields(1);
+	fields[0].name = "counts"; fields[0].type = qlbase::INT32; fields[0].vsize = 1;
+
+	std::vector<int32_t> counts(1000);
+	for(unsigned int i=0; i<counts.size(); i++)
+		counts[i] = i * 3;
+
+	// a small initial buffer, grown while writing
+	qlbase::OutputFileFITS ofile;
+	BOOST_CHECK_NO_THROW(ofile.createMemory(2880));
+	BOOST_CHECK_NO_THROW(ofile.createTable("COUNTS", fields));
+	BOOST_CHECK_NO_THROW(ofile.write32i(0, &counts[0], 0, counts.size()-1));
+	size_t size;
+	BOOST_CHECK_THROW(ofile.getBuffer(size), qlbase::IOException);
+	BOOST_CHECK_NO_THROW(ofile.close());
+
+	const void* buffer = 0;
+	BOOST_CHECK_NO_THROW(buffer = ofile.getBuffer(size));
+	BOOST_CHECK(size > 0 && size % 2880 == 0);
+	BOOST_CHECK(memcmp(buffer, "SIMPLE  =", 9) == 0);
+
+	// read in place from the borrowed buffer
+	qlbase::InputFileFITS ifile;
+	BOOST_CHECK_NO_THROW(ifile.openMemory(buffer, size));
+	BOOST_CHECK_EQUAL(ifile.getHeadersNum(), 2);
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(1));
+	BOOST_CHECK_EQUAL(ifile.getNRows(), 1000);
+	std::vector<int32_t> readCounts;
+	BOOST_CHECK_NO_THROW(readCounts = ifile.read32i(0, 0, 999));
+	BOOST_CHECK(readCounts == counts);
+	BOOST_CHECK_EQUAL(ifile.refresh(), 0);
+	BOOST_CHECK_NO_THROW(ifile.close());
+
+	// take the buffer, the file doesn't own it anymore
+	void* owned = 0;
+	size_t ownedSize;
+	BOOST_CHECK_NO_THROW(owned = ofile.releaseBuffer(ownedSize));
+	BOOST_CHECK(owned == buffer);
+	BOOST_CHECK_EQUAL(ownedSize, size);
+	BOOST_CHECK_THROW(ofile.getBuffer(size), qlbase::IOException);
+	free(owned);
+}
+
+BOOST_AUTO_TEST_CASE(shared_memory_table)
+{
+	std::vector<qlbase::field> fields(2);
+	fields[0].name = "counts"; fields[0].type = qlbase::INT32; fields[0].vsize = 1;
+	fields[1].name = "energy"; fields[1].type = qlbase::FLOAT; fields[1].vsize = 2;
+
+	// the rows older than the capacity are overwritten
+	qlbase::OutputFileSHM ofile(100);
+	BOOST_CHECK_NO_THROW(ofile.create("qlbase_test_ring"));
+	BOOST_CHECK_NO_THROW(ofile.createTable("EVENTS", fields));
+	std::vector<int32_t> counts(60);
+	std::vector<float> energy(120);
+	for(int block=0; block<3; block++)
+	{
+		for(int i=0; i<60; i++)
+		{
+			counts[i] = block * 60 + i;
+			energy[i*2] = energy[i*2+1] = counts[i] * 0.5f;
+		}
+		BOOST_CHECK_NO_THROW(ofile.write32i(0, &counts[0], block * 60, block * 60 + 59));
+		BOOST_CHECK_NO_THROW(ofile.write32fv(1, &energy[0], block * 60, block * 60 + 59, 2));
+		BOOST_CHECK_NO_THROW(ofile.endRows(60));
+	}
+	BOOST_CHECK_THROW(ofile.write32i(0, &counts[0], 100, 159), qlbase::IOException);
+	BOOST_CHECK_THROW(ofile.endRows(1), qlbase::IOException);
+
+	qlbase::InputFileSHM ifile;
+	BOOST_CHECK_NO_THROW(ifile.open("qlbase_test_ring"));
+	BOOST_CHECK_EQUAL(ifile.getNRows(), 180);
+	BOOST_CHECK_EQUAL(ifile.getFirstRow(), 80);
+	BOOST_CHECK_EQUAL(ifile.getColNum("ENERGY"), 1);
+	BOOST_CHECK_THROW(ifile.read32i(0, 79, 100), qlbase::IOException);
+	std::vector<double> readCounts;
+	BOOST_CHECK_NO_THROW(readCounts = ifile.read64f(0, 80, 179));
+	BOOST_CHECK_EQUAL(readCounts.size(), 100);
+	BOOST_CHECK_EQUAL(readCounts[0], 80.0);
+	BOOST_CHECK_EQUAL(readCounts[99], 179.0);
+	std::vector< std::vector<float> > readEnergy;
+	BOOST_CHECK_NO_THROW(readEnergy = ifile.read32fv(1, 170, 179, 2));
+	BOOST_CHECK_EQUAL(readEnergy[9][1], 89.5f);
+
+	// in place, up to the end of the ring
+	long nrows;
+	const int32_t* data = (const int32_t*) ifile.getData(0, 90, 179, nrows);
+	BOOST_CHECK_EQUAL(nrows, 10);
+	BOOST_CHECK_EQUAL(data[0], 90);
+	BOOST_CHECK(ifile.isAvailable(90));
+	BOOST_CHECK_NO_THROW(ofile.close());
+	BOOST_CHECK(ifile.isWriterClosed());
+	BOOST_CHECK_NO_THROW(ifile.close());
+
+	// a writer process and a reader process
+	int ready[2], attached[2];
+	BOOST_REQUIRE(pipe(ready) == 0 && pipe(attached) == 0);
+	pid_t pid = fork();
+	BOOST_REQUIRE(pid >= 0);
+	if(pid == 0)
+	{
+		char c;
+		int status = 1;
+		try
+		{
+			qlbase::OutputFileSHM writer(10000);
+			writer.create("qlbase_test_ring");
+			writer.createTable("EVENTS", fields);
+			if(write(ready[1], "r", 1) == 1 && read(attached[0], &c, 1) == 1)
+			{
+				for(int row=0; row<5000; row++)
+				{
+					int32_t value = row;
+					float values[2] = {row * 0.5f, row * 0.5f};
+					writer.write32i(0, &value, row, row);
+					writer.write32fv(1, values, row, row, 2);
+					writer.endRows(1);
+				}
+				writer.close();
+				status = 0;
+			}
+		}
+		catch(qlbase::IOException& e)
+		{
+		}
+		_exit(status);
+	}
+
+	char c;
+	BOOST_REQUIRE(read(ready[0], &c, 1) == 1);
+	BOOST_REQUIRE_NO_THROW(ifile.open("qlbase_test_ring"));
+	BOOST_REQUIRE(write(attached[1], "a", 1) == 1);
+
+	qlbase::FileFollower follower(ifile, 1);
+	long frow, lrow, total = 0;
+	bool sequence = true;
+	while(total < 5000 && follower.wait(frow, lrow, 10000))
+	{
+		std::vector<int32_t> values = ifile.read32i(0, frow, lrow);
+		for(long i=0; i<(long) values.size(); i++)
+			sequence = sequence && values[i] == frow + i;
+		total += values.size();
+	}
+	BOOST_CHECK_EQUAL(total, 5000);
+	BOOST_CHECK(sequence);
+
+	int status;
+	waitpid(pid, &status, 0);
+	BOOST_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	BOOST_CHECK(ifile.isWriterClosed());
+	BOOST_CHECK_NO_THROW(ifile.close());
+	for(int i=0; i<2; i++)
+	{
+		close(ready[i]);
+		close(attached[i]);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(string_column)
+{
+	std::vector<qlbase::field> fields(1);
+	fields[0].name = "label"; fields[0].type = qlbase::STRING; fields[0].vsize = 8;
+
+	qlbase::StringColumn labels(5, 8);
+	BOOST_CHECK_EQUAL(labels.size(), 5);
+	for(long row=0; row<5; row++)
+	{
+		std::ostringstream label;
+		label << "label" << row;
+		labels.set(row, label.str());
+	}
+	labels.set(4, "truncated label");
+	BOOST_CHECK_EQUAL(std::string(labels[4]), "truncate");
+	BOOST_CHECK_EQUAL(labels.length(0), 6);
+
+	qlbase::OutputFileFITS ofile;
+	BOOST_CHECK_NO_THROW(ofile.create("strings.fits"));
+	BOOST_CHECK_NO_THROW(ofile.createTable("LABELS", fields));
+	BOOST_CHECK_NO_THROW(ofile.writeString(0, labels, 0));
+	BOOST_CHECK_NO_THROW(ofile.writeString(0, labels, 5));
+	BOOST_CHECK_NO_THROW(ofile.close());
+
+	qlbase::InputFileFITS ifile;
+	BOOST_CHECK_NO_THROW(ifile.open("strings.fits"));
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(1));
+	qlbase::StringColumn readLabels;
+	BOOST_CHECK_NO_THROW(ifile.readString(0, 4, 9, readLabels));
+	BOOST_CHECK_EQUAL(readLabels.size(), 6);
+	BOOST_CHECK_EQUAL(readLabels.getWidth(), 8);
+	BOOST_CHECK_EQUAL(std::string(readLabels[0]), "truncate");
+	BOOST_CHECK_EQUAL(std::string(readLabels[1]), "label0");
+	BOOST_CHECK_EQUAL(std::string(readLabels[4]), "label3");
+
+	// the buffer is reused
+	BOOST_CHECK_NO_THROW(ifile.readString(0, 0, 1, readLabels));
+	BOOST_CHECK_EQUAL(readLabels.size(), 2);
+	BOOST_CHECK_EQUAL(std::string(readLabels[1]), "label1");
+
+	std::vector< std::vector<char> > rows;
+	BOOST_CHECK_NO_THROW(rows = ifile.readString(0, 6, 6, 9));
+	BOOST_CHECK_EQUAL(std::string(&rows[0][0]), "label1");
+	BOOST_CHECK_NO_THROW(ifile.close());
+
+	unlink("strings.fits");
+}
+
+BOOST_AUTO_TEST_CASE(validity_bitmap)
+{
+	qlbase::ValidityBitmap bitmap(130);
+	BOOST_CHECK(!bitmap.hasNulls());
+	bitmap.set(3, false);
+	bitmap.set(129, false);
+	BOOST_CHECK_EQUAL(bitmap.countNulls(), 2);
+	BOOST_CHECK(!bitmap.isValid(129));
+
+	std::vector<qlbase::field> fields(2);
+	fields[0].name = "counts"; fields[0].type = qlbase::INT32; fields[0].vsize = 1;
+	fields[1].name = "energy"; fields[1].type = qlbase::FLOAT; fields[1].vsize = 2;
+
+	std::vector<int32_t> counts(100);
+	std::vector<float> energy(200);
+	qlbase::ValidityBitmap countsValidity(100);
+	qlbase::ValidityBitmap energyValidity(200);
+	for(int i=0; i<100; i++)
+	{
+		counts[i] = i;
+		energy[i*2] = energy[i*2+1] = i * 0.5f;
+		countsValidity.set(i, i % 10 != 0);
+	}
+	energyValidity.set(23, false);
+
+	qlbase::OutputFileFITS ofile;
+	BOOST_CHECK_NO_THROW(ofile.create("nulls.fits"));
+	BOOST_CHECK_NO_THROW(ofile.createTable("EVENTS", fields));
+
+	// integer columns need a TNULL value
+	BOOST_CHECK_THROW(ofile.write32i(0, &counts[0], 0, 99, countsValidity), qlbase::IOException);
+	BOOST_CHECK_NO_THROW(ofile.setNullValue(0, -1));
+	BOOST_CHECK_NO_THROW(ofile.write32i(0, &counts[0], 0, 99, countsValidity));
+	BOOST_CHECK_NO_THROW(ofile.write32fv(1, &energy[0], 0, 99, 2, energyValidity));
+	BOOST_CHECK_NO_THROW(ofile.close());
+
+	qlbase::InputFileFITS ifile;
+	BOOST_CHECK_NO_THROW(ifile.open("nulls.fits"));
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(1));
+	qlbase::ValidityBitmap validity;
+	std::vector<int32_t> readCounts;
+	BOOST_CHECK_NO_THROW(readCounts = ifile.read32i(0, 5, 24, validity));
+	BOOST_CHECK_EQUAL(validity.size(), 20);
+	BOOST_CHECK_EQUAL(validity.countNulls(), 2);
+	BOOST_CHECK(!validity.isValid(5));
+	BOOST_CHECK(validity.isValid(6));
+	BOOST_CHECK_EQUAL(readCounts[5], 0);
+	BOOST_CHECK_EQUAL(readCounts[6], 11);
+
+	std::vector< std::vector<float> > readEnergy;
+	BOOST_CHECK_NO_THROW(readEnergy = ifile.read32fv(1, 10, 11, 2, validity));
+	BOOST_CHECK_EQUAL(validity.size(), 4);
+	BOOST_CHECK(validity.isValid(2));
+	BOOST_CHECK(!validity.isValid(3));
+	BOOST_CHECK_EQUAL(readEnergy[0][0], 5.0f);
+
+	// without nulls all the values are valid
+	BOOST_CHECK_NO_THROW(ifile.read32fv(1, 20, 29, 2, validity));
+	BOOST_CHECK(!validity.hasNulls());
+	BOOST_CHECK_NO_THROW(ifile.close());
+
+	unlink("nulls.fits");
+}
+
+QL_FIELD(EvtTime, "TIME", double, 1);
+QL_FIELD(EvtCounts, "COUNTS", int32_t, 4);
+QL_FIELD(EvtFlag, "FLAG", uint8_t, 1);
+QL_STRING_FIELD(EvtSource, "SOURCE", 12);
+typedef qlbase::Schema<EvtTime, EvtCounts, EvtFlag, EvtSource> Events;
+typedef qlbase::Schema<EvtFlag, EvtTime> EventTimes;
+QL_FIELD(EvtCounts8, "COUNTS", int32_t, 8);
+QL_FIELD(EvtFloatTime, "TIME", float, 1);
+typedef qlbase::Schema<EvtTime, EvtCounts8> WrongCounts;
+typedef qlbase::Schema<EvtFloatTime> WrongTime;
+
+BOOST_AUTO_TEST_CASE(table_schema)
+{
+	BOOST_CHECK_EQUAL(Events::ncols, 4);
+	BOOST_CHECK_EQUAL(Events::index<EvtFlag>(), 2);
+	std::vector<qlbase::field> fields = Events::fields();
+	BOOST_CHECK_EQUAL(fields[1].name, "COUNTS");
+	BOOST_CHECK_EQUAL(fields[1].type, qlbase::INT32);
+	BOOST_CHECK_EQUAL(fields[1].vsize, 4);
+	BOOST_CHECK_EQUAL(fields[3].type, qlbase::STRING);
+
+	Events::Table events;
+	events.resize(50);
+	BOOST_CHECK_EQUAL(events.size(), 50);
+	for(long row=0; row<50; row++)
+	{
+		events.column<EvtTime>()[row] = row * 0.5;
+		for(int i=0; i<4; i++)
+			events.column<EvtCounts>()[row * 4 + i] = row + i;
+		events.column<EvtFlag>()[row] = row % 2;
+		events.column<EvtSource>().set(row, row < 25 ? "CRAB" : "VELA");
+	}
+
+	qlbase::OutputFileFITS ofile;
+	BOOST_CHECK_NO_THROW(ofile.create("schema.fits"));
+	BOOST_CHECK_NO_THROW(Events::createTable(ofile, "EVENTS"));
+	BOOST_CHECK_NO_THROW(Events::write(ofile, events, 0));
+	BOOST_CHECK_NO_THROW(ofile.close());
+
+	qlbase::InputFileFITS ifile;
+	BOOST_CHECK_NO_THROW(ifile.open("schema.fits"));
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(1));
+	Events::Table readEvents;
+	BOOST_CHECK_NO_THROW(Events::read(ifile, 10, 29, readEvents));
+	BOOST_CHECK_EQUAL(readEvents.size(), 20);
+	BOOST_CHECK_EQUAL(readEvents.column<EvtTime>()[0], 5.0);
+	BOOST_CHECK_EQUAL(readEvents.column<EvtCounts>()[4 * 19 + 3], 32);
+	BOOST_CHECK_EQUAL(readEvents.column<EvtFlag>()[1], 1);
+	BOOST_CHECK_EQUAL(std::string(readEvents.column<EvtSource>()[15]), "VELA");
+
+	// a subset of the columns, found by name
+	EventTimes::Table times;
+	BOOST_CHECK_NO_THROW(EventTimes::read(ifile, 0, 49, times));
+	BOOST_CHECK_EQUAL(times.column<EvtTime>()[49], 24.5);
+	BOOST_CHECK_EQUAL(times.column<EvtFlag>()[48], 0);
+
+	// columns of a different vsize or type should raise an exception
+	qlbase::field counts = ifile.getField(1);
+	BOOST_CHECK_EQUAL(counts.name, "COUNTS");
+	BOOST_CHECK_EQUAL(counts.type, qlbase::INT32);
+	BOOST_CHECK_EQUAL(counts.vsize, 4);
+	WrongCounts::Table wrongCounts;
+	BOOST_CHECK_THROW(WrongCounts::read(ifile, 0, 49, wrongCounts), qlbase::IOException);
+	WrongTime::Table wrongTime;
+	BOOST_CHECK_THROW(WrongTime::read(ifile, 0, 49, wrongTime), qlbase::IOException);
+	BOOST_CHECK_NO_THROW(ifile.close());
+
+	unlink("schema.fits");
+}
+
+BOOST_AUTO_TEST_CASE(packet_decoder)
+{
+	std::string ddl =
+		"<ddl>\n"
+		"  <type name=\"HK\">\n"
+		"    <data><binaryTable>\n"
+		"        <column name=\"TEMP\" type=\"float32\" />\n"
+		"    </binaryTable></data>\n"
+		"  </type>\n"
+		"  <type name=\"EVENTS\">\n"
+		"    <data>\n"
+		"      <binaryTable>\n"
+		"        <column name=\"FLAG\" type=\"byte\" />\n"
+		"        <column name=\"TIME\" type=\"float64\" unit=\"s\" />\n"
+		"        <column name=\"COUNTS\" type=\"int16\" arraysize=\"3\" />\n"
+		"        <column name=\"ID\" type=\"int32\" />\n"
+		"      </binaryTable>\n"
+		"    </data>\n"
+		"  </type>\n"
+		"</ddl>\n";
+
+	qlbase::PacketDecoder decoder;
+	BOOST_CHECK_THROW(decoder.loadString(ddl, "MISSING"), qlbase::IOException);
+	BOOST_CHECK_NO_THROW(decoder.loadString(ddl, "EVENTS"));
+	BOOST_CHECK_EQUAL(decoder.getFields().size(), 4);
+	BOOST_CHECK_EQUAL(decoder.getFields()[1].unit, "s");
+	BOOST_CHECK_EQUAL(decoder.getFields()[2].vsize, 3);
+	BOOST_CHECK_EQUAL(decoder.getPacketSize(), 1 + 8 + 6 + 4);
+
+	// big endian packets after a 2 bytes header
+	decoder.setHeaderSize(2);
+	const long npackets = 100;
+	const size_t size = decoder.getPacketSize();
+	BOOST_CHECK_EQUAL(size, 21);
+	std::vector<unsigned char> packets(npackets * size);
+	for(long i=0; i<npackets; i++)
+	{
+		unsigned char* p = &packets[i * size];
+		p[0] = 0xAB; p[1] = 0xCD;
+		p[2] = i % 2;
+		double time = i * 0.25;
+		uint64_t bits;
+		memcpy(&bits, &time, 8);
+		for(int b=0; b<8; b++)
+			p[3 + b] = bits >> (56 - 8 * b);
+		for(int j=0; j<3; j++)
+		{
+			int16_t count = i * 3 + j - 10;
+			p[11 + 2 * j] = (uint16_t) count >> 8;
+			p[12 + 2 * j] = count & 0xFF;
+		}
+		int32_t id = i * 1000;
+		for(int b=0; b<4; b++)
+			p[17 + b] = (uint32_t) id >> (24 - 8 * b);
+	}
+
+	std::vector<uint8_t> flags(npackets);
+	std::vector<double> times(npackets);
+	std::vector<int16_t> counts(npackets * 3);
+	std::vector<int32_t> ids(npackets);
+	void* buffers[] = { &flags[0], &times[0], &counts[0], &ids[0] };
+	BOOST_CHECK_NO_THROW(decoder.decode(&packets[0], npackets, buffers));
+	BOOST_CHECK_EQUAL(flags[3], 1);
+	BOOST_CHECK_EQUAL(times[99], 24.75);
+	BOOST_CHECK_EQUAL(counts[0], -10);
+	BOOST_CHECK_EQUAL(counts[3 * 50 + 2], 142);
+	BOOST_CHECK_EQUAL(ids[42], 42000);
+
+	// straight to a table
+	qlbase::OutputFileFITS ofile;
+	BOOST_CHECK_NO_THROW(ofile.create("packets.fits"));
+	BOOST_CHECK_NO_THROW(ofile.createTable("EVENTS", decoder.getFields()));
+	{
+		qlbase::TableAppender appender(ofile, decoder.getFields(), 64);
+		BOOST_CHECK_NO_THROW(decoder.decode(&packets[0], 60, appender));
+		BOOST_CHECK_NO_THROW(decoder.decode(&packets[60 * size], 40, appender));
+		BOOST_CHECK_EQUAL(appender.getNRows(), 100);
+		BOOST_CHECK_NO_THROW(appender.flush());
+	}
+	BOOST_CHECK_NO_THROW(ofile.close());
+
+	qlbase::InputFileFITS ifile;
+	BOOST_CHECK_NO_THROW(ifile.open("packets.fits"));
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(1));
+	std::vector<double> readTimes = ifile.read64f(1, 0, 99);
+	BOOST_CHECK(readTimes == times);
+	std::vector< std::vector<int16_t> > readCounts = ifile.read16iv(2, 70, 70, 3);
+	BOOST_CHECK_EQUAL(readCounts[0][1], 201);
+	BOOST_CHECK_NO_THROW(ifile.close());
+
+	unlink("packets.fits");
+}
+
+QL_FIELD(WfTime, "TIME", double, 1);
+QL_VAR_FIELD(WfSamples, "SAMPLES", int16_t);
+typedef qlbase::Schema<WfTime, WfSamples> Waveforms;
+
+BOOST_AUTO_TEST_CASE(variable_length_columns)
+{
+	std::vector<qlbase::field> fields(2);
+	fields[0].name = "samples"; fields[0].type = qlbase::INT16; fields[0].vsize = 0;
+	fields[1].name = "energy"; fields[1].type = qlbase::DOUBLE; fields[1].vsize = 0;
+
+	// row i has i % 7 values, row 3 is empty
+	qlbase::VarColumn<int16_t> samples;
+	qlbase::VarColumn<double> energy;
+	for(long row=0; row<50; row++)
+	{
+		std::vector<int16_t> s;
+		for(long j=0; j<row % 7; j++)
+			s.push_back(row * 10 + j);
+		if(row == 3)
+			s.clear();
+		samples.append(s);
+		double e[] = { row * 0.5, row * 1.5 };
+		energy.append(e, 2);
+	}
+	BOOST_CHECK_EQUAL(samples.size(), 50);
+	BOOST_CHECK_EQUAL(samples.length(6), 6);
+	BOOST_CHECK_EQUAL(samples.getOffsets().back(), (long) samples.getValues().size());
+
+	qlbase::OutputFileFITS ofile;
+	BOOST_CHECK_NO_THROW(ofile.create("vla.fits"));
+	BOOST_CHECK_NO_THROW(ofile.createTable("WAVEFORMS", fields));
+	BOOST_CHECK_NO_THROW(ofile.writeVar(0, samples, 0));
+	BOOST_CHECK_NO_THROW(ofile.writeVar(1, energy, 0));
+	BOOST_CHECK_NO_THROW(ofile.close());
+
+	qlbase::InputFileFITS ifile;
+	BOOST_CHECK_NO_THROW(ifile.open("vla.fits"));
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(1));
+	BOOST_CHECK_EQUAL(ifile.getNRows(), 50);
+
+	// the heap read, the column has the same type
+	qlbase::VarColumn<int16_t> readSamples;
+	BOOST_CHECK_NO_THROW(ifile.readVar(0, 2, 13, readSamples));
+	BOOST_CHECK_EQUAL(readSamples.size(), 12);
+	BOOST_CHECK_EQUAL(readSamples.length(0), 2);
+	BOOST_CHECK_EQUAL(readSamples.length(1), 0);
+	BOOST_CHECK_EQUAL(readSamples.length(4), 6);
+	BOOST_CHECK_EQUAL(readSamples[4][5], 65);
+	BOOST_CHECK_EQUAL(readSamples[11][4], 134);
+
+	// converted row by row
+	qlbase::VarColumn<int32_t> readWide;
+	BOOST_CHECK_NO_THROW(ifile.readVar(0, 2, 13, readWide));
+	BOOST_CHECK(readWide.getOffsets() == readSamples.getOffsets());
+	BOOST_CHECK_EQUAL(readWide[11][4], 134);
+
+	qlbase::VarColumn<double> readEnergy;
+	BOOST_CHECK_NO_THROW(ifile.readVar(1, 40, 49, readEnergy));
+	BOOST_CHECK_EQUAL(readEnergy.getValues().size(), 20);
+	BOOST_CHECK_EQUAL(readEnergy[9][1], 49 * 1.5);
+
+	BOOST_CHECK_NO_THROW(ifile.close());
+
+	// through a schema
+	BOOST_CHECK_NO_THROW(ofile.create("vla.fits"));
+	BOOST_CHECK_NO_THROW(Waveforms::createTable(ofile, "WAVEFORMS"));
+	Waveforms::Table waveforms;
+	for(long row=0; row<10; row++)
+	{
+		waveforms.column<WfTime>().push_back(row);
+		int16_t s[] = { (int16_t) row, (int16_t) -row, 7 };
+		waveforms.column<WfSamples>().append(s, row % 3 + 1);
+	}
+	BOOST_CHECK_NO_THROW(Waveforms::write(ofile, waveforms, 0));
+	BOOST_CHECK_NO_THROW(ofile.close());
+
+	BOOST_CHECK_NO_THROW(ifile.open("vla.fits"));
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(1));
+	Waveforms::Table readWaveforms;
+	BOOST_CHECK_NO_THROW(Waveforms::read(ifile, 0, 9, readWaveforms));
+	BOOST_CHECK_EQUAL(readWaveforms.column<WfSamples>().length(5), 3);
+	BOOST_CHECK_EQUAL(readWaveforms.column<WfSamples>()[5][1], -5);
+	// TIME is not a variable length column
+	BOOST_CHECK_THROW(ifile.readVar(0, 0, 9, readWide), qlbase::IOException);
+	BOOST_CHECK_NO_THROW(ifile.close());
+
+	unlink("vla.fits");
+}
+
+BOOST_AUTO_TEST_CASE(bit_columns)
+{
+	std::vector<qlbase::field> fields(2);
+	fields[0].name = "flags"; fields[0].type = qlbase::BIT; fields[0].vsize = 12;
+	fields[1].name = "good"; fields[1].type = qlbase::LOGICAL; fields[1].vsize = 1;
+
+	// bit 0 in the even rows, bit 11 in the rows multiple of 3
+	qlbase::BitColumn flags(30, 12);
+	qlbase::BitColumn good(30, 1);
+	BOOST_CHECK_EQUAL(flags.getWords(), 1);
+	for(long row=0; row<30; row++)
+	{
+		flags.set(row, 0, row % 2 == 0);
+		flags.set(row, 11, row % 3 == 0);
+		good.set(row, 0, row < 10);
+	}
+	BOOST_CHECK_EQUAL(flags.count(), 15 + 10);
+	BOOST_CHECK_EQUAL(flags.count(11), 10);
+	std::vector<long> rows;
+	BOOST_CHECK_EQUAL(flags.select(1 | 1 << 11, rows), 5);
+	BOOST_CHECK_EQUAL(rows[1], 6);
+	rows.clear();
+	BOOST_CHECK_EQUAL(flags.select(1 | 1 << 11, rows, false), 20);
+
+	// the first bit is the most significant one of the first byte
+	std::vector<uint8_t> bytes(30 * 2);
+	flags.getFitsBytes(&bytes[0]);
+	BOOST_CHECK_EQUAL(bytes[0], 0x80);
+	BOOST_CHECK_EQUAL(bytes[1], 0x10);
+	BOOST_CHECK_EQUAL(bytes[2], 0x00);
+
+	qlbase::OutputFileFITS ofile;
+	BOOST_CHECK_NO_THROW(ofile.create("bits.fits"));
+	BOOST_CHECK_NO_THROW(ofile.createTable("FLAGS", fields));
+	BOOST_CHECK_NO_THROW(ofile.writeBits(0, flags, 0));
+	BOOST_CHECK_NO_THROW(ofile.writeLogical(1, good, 0));
+	BOOST_CHECK_NO_THROW(ofile.close());
+
+	qlbase::InputFileFITS ifile;
+	BOOST_CHECK_NO_THROW(ifile.open("bits.fits"));
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(1));
+	qlbase::BitColumn readFlags;
+	BOOST_CHECK_NO_THROW(ifile.readBits(0, 3, 8, readFlags));
+	BOOST_CHECK_EQUAL(readFlags.size(), 6);
+	BOOST_CHECK_EQUAL(readFlags.getBits(), 12);
+	BOOST_CHECK_EQUAL(readFlags.word(0), (uint64_t) 1 << 11);
+	BOOST_CHECK_EQUAL(readFlags.word(3), (uint64_t) (1 | 1 << 11));
+	BOOST_CHECK(!readFlags.test(4, 11));
+
+	qlbase::BitColumn readGood;
+	BOOST_CHECK_NO_THROW(ifile.readLogical(1, 0, 29, readGood));
+	BOOST_CHECK_EQUAL(readGood.count(), 10);
+	BOOST_CHECK(readGood.test(9, 0));
+	BOOST_CHECK(!readGood.test(10, 0));
+
+	BOOST_CHECK_THROW(ifile.readBits(1, 0, 29, readFlags), qlbase::IOException);
+	BOOST_CHECK_THROW(ifile.readLogical(0, 0, 29, readGood), qlbase::IOException);
+	BOOST_CHECK_NO_THROW(ifile.close());
+
+	unlink("bits.fits");
+}
+
+BOOST_AUTO_TEST_CASE(scaled_columns)
+{
+	std::vector<qlbase::field> fields(4);
+	fields[0].name = "adc"; fields[0].type = qlbase::INT16; fields[0].vsize = 1;
+	fields[1].name = "counter"; fields[1].type = qlbase::INT32; fields[1].vsize = 1;
+	fields[2].name = "id"; fields[2].type = qlbase::INT64; fields[2].vsize = 1;
+	fields[3].name = "temp"; fields[3].type = qlbase::INT32; fields[3].vsize = 2;
+
+	std::vector<int16_t> adc(100);
+	std::vector<uint32_t> counter(100);
+	std::vector<uint64_t> id(100);
+	std::vector<double> temp(200);
+	for(long row=0; row<100; row++)
+	{
+		adc[row] = row - 50;
+		counter[row] = 4000000000u + row;
+		id[row] = 18000000000000000000ull + row;
+		temp[2 * row] = 20. + row * 0.25;
+		temp[2 * row + 1] = -10. - row * 0.5;
+	}
+
+	qlbase::OutputFileFITS ofile;
+	BOOST_CHECK_NO_THROW(ofile.create("scaled.fits"));
+	BOOST_CHECK_NO_THROW(ofile.createTable("SCALED", fields));
+	BOOST_CHECK_NO_THROW(ofile.setScaling(0, 0.5, 100.));
+	BOOST_CHECK_NO_THROW(ofile.setUnsigned(1));
+	BOOST_CHECK_NO_THROW(ofile.setUnsigned(2));
+	BOOST_CHECK_NO_THROW(ofile.setScaling(3, 0.25, 0.));
+	BOOST_CHECK_THROW(ofile.setUnsigned(0), qlbase::IOException);
+
+	// adc are stored values, the others physical ones
+	BOOST_CHECK_NO_THROW(ofile.writeRaw(0, &adc[0], 0, 99));
+	BOOST_CHECK_NO_THROW(ofile.write32u(1, &counter[0], 0, 99));
+	BOOST_CHECK_NO_THROW(ofile.write64u(2, &id[0], 0, 99));
+	BOOST_CHECK_NO_THROW(ofile.write(3, &temp[0], 0, 99, 2));
+	BOOST_CHECK_NO_THROW(ofile.close());
+
+	qlbase::InputFileFITS ifile;
+	BOOST_CHECK_NO_THROW(ifile.open("scaled.fits"));
+	BOOST_CHECK_NO_THROW(ifile.moveToHeader(1));
+
+	double scale, zero;
+	BOOST_CHECK_NO_THROW(ifile.getScaling(0, scale, zero));
+	BOOST_CHECK_EQUAL(scale, 0.5);
+	BOOST_CHECK_EQUAL(zero, 100.);
+	BOOST_CHECK_NO_THROW(ifile.getScaling(1, scale, zero));
+	BOOST_CHECK_EQUAL(zero, 2147483648.);
+
+	std::vector<int16_t> rawAdc(100);
+	BOOST_CHECK_NO_THROW(ifile.readRaw(0, 0, 99, &rawAdc[0]));
+	BOOST_CHECK(rawAdc == adc);
+
+	std::vector<float> physical(100);
+	BOOST_CHECK_NO_THROW(ifile.readScaled(0, 0, 99, &physical[0]));
+	BOOST_CHECK_EQUAL(physical[0], 75.f);
+	BOOST_CHECK_EQUAL(physical[99], 124.5f);
+
+	// the stored values are unchanged by the raw read
+	std::vector<double> cfitsio = ifile.read64f(0, 10, 10);
+	BOOST_CHECK_EQUAL(cfitsio[0], 80.);
+
+	std::vector<uint32_t> readCounter;
+	BOOST_CHECK_NO_THROW(readCounter = ifile.read32u(1, 0, 99));
+	BOOST_CHECK(readCounter == counter);
+	std::vector<uint64_t> readId;
+	BOOST_CHECK_NO_THROW(readId = ifile.read64u(2, 0, 99));
+	BOOST_CHECK(readId == id);
+
+	std::vector<int32_t> rawCounter(100);
+	BOOST_CHECK_NO_THROW(ifile.readRaw(1, 0, 99, &rawCounter[0]));
+	BOOST_CHECK_EQUAL(rawCounter[0], (int32_t) (4000000000u - 2147483648u));
+
+	std::vector<double> readTemp(200);
+	BOOST_CHECK_NO_THROW(ifile.readScaled(3, 0, 99, &readTemp[0], 2));
+	BOOST_CHECK(readTemp == temp);
+	BOOST_CHECK_NO_THROW(ifile.close());
+
+	unlink("scaled.fits");
+}
@@ -14,6 +14,12 @@
  ***************************************************************************/
 
 #include<IO/InputFileText.h>
+#include<IO/OutputFileText.h>
+#include<IO/FileFollower.h>
+#include<IO/CompressedStreamBuf.h>
+#include<IO/BufferPool.h>
+#include<IO/ChunkStore.h>
+#include<zlib.h>
 #include<sstream>
 #include<fstream>
 #include<iomanip>
@@ -21,6 +27,7 @@
 #define BOOST_TEST_MODULE MyTest
 #include <boost/test/unit_test.hpp>
 #include<unistd.h>
+#include<thread>
 
 BOOST_AUTO_TEST_CASE(input_file_text)
 {
@@ -81,3 +88,629 @@ BOOST_AUTO_TEST_CASE(input_file_text)
 	// reading the first 4 rows from column 0 on a closed file should raise an exception
 	BOOST_CHECK_THROW(rowsT1 = file.read32i(0, 0, 3), qlbase::IOException);
 }
+
+BOOST_AUTO_TEST_CASE(input_file_text_follow)
+{
+	std::ofstream out("follow.txt");
+	out << "0,10\n1,11\n2,12\n";
+	out.flush();
+
+	qlbase::InputFileText file(",");
+	BOOST_CHECK_NO_THROW(file.open("follow.txt"));
+	BOOST_CHECK_EQUAL(file.getNRows(), 3);
+
+	// reading rows not starting from 0 should return the right values
+	std::vector<int32_t> rows;
+	BOOST_CHECK_NO_THROW(rows = file.read32i(1, 1, 2));
+	BOOST_CHECK_EQUAL(rows[0], 11);
+	BOOST_CHECK_EQUAL(rows[1], 12);
+
+	qlbase::FileFollower follower(file, 10);
+	long frow, lrow;
+
+	// nothing appended, nothing to deliver
+	BOOST_CHECK_EQUAL(follower.poll(frow, lrow), false);
+
+	// the appended rows should be delivered
+	out << "3,13\n\n4,14\n";
+	out.flush();
+	BOOST_CHECK_EQUAL(follower.wait(frow, lrow, 1000), true);
+	BOOST_CHECK_EQUAL(frow, 3);
+	BOOST_CHECK_EQUAL(lrow, 4);
+	BOOST_CHECK_EQUAL(file.getNRows(), 5);
+	BOOST_CHECK_NO_THROW(rows = file.read32i(1, frow, lrow));
+	BOOST_CHECK_EQUAL(rows[0], 13);
+	BOOST_CHECK_EQUAL(rows[1], 14);
+
+	// a line in the middle of its writing is delivered once terminated
+	out << "5,1";
+	out.flush();
+	BOOST_CHECK_EQUAL(follower.poll(frow, lrow), false);
+	BOOST_CHECK_EQUAL(file.getNRows(), 5);
+	out << "5\n";
+	out.flush();
+	BOOST_CHECK_EQUAL(follower.poll(frow, lrow), true);
+	BOOST_CHECK_EQUAL(frow, 5);
+	BOOST_CHECK_EQUAL(lrow, 5);
+	BOOST_CHECK_NO_THROW(rows = file.read32i(1, 5, 5));
+	BOOST_CHECK_EQUAL(rows[0], 15);
+
+	// timeout without new data
+	BOOST_CHECK_EQUAL(follower.wait(frow, lrow, 20), false);
+
+	BOOST_CHECK_NO_THROW(file.close());
+	out.close();
+
+	// an unterminated last line found by open() is a row, completing it
+	// doesn't add another one
+	out.open("follow.txt");
+	out << "0,10\n1,1";
+	out.flush();
+	BOOST_CHECK_NO_THROW(file.open("follow.txt"));
+	BOOST_CHECK_EQUAL(file.getNRows(), 2);
+	out << "1\n";
+	out.flush();
+	BOOST_CHECK_EQUAL(file.refresh(), 0);
+	BOOST_CHECK_NO_THROW(rows = file.read32i(1, 1, 1));
+	BOOST_CHECK_EQUAL(rows[0], 11);
+	BOOST_CHECK_NO_THROW(file.close());
+	out.close();
+	unlink("follow.txt");
+}
+
+BOOST_AUTO_TEST_CASE(input_file_text_gzip)
+{
+	qlbase::InputFileText plain(",");
+	qlbase::InputFileText compressed(",");
+
+	// a gzipped file should be read like the plain one
+	BOOST_CHECK_NO_THROW(plain.open("sample.txt"));
+	BOOST_CHECK_NO_THROW(compressed.open("sample.txt.gz"));
+	BOOST_CHECK_EQUAL(compressed.getNRows(), plain.getNRows());
+	BOOST_CHECK_EQUAL(compressed.getNCols(), plain.getNCols());
+
+	std::vector<int32_t> rowsP, rowsC;
+	BOOST_CHECK_NO_THROW(rowsP = plain.read32i(9, 3, 8));
+	BOOST_CHECK_NO_THROW(rowsC = compressed.read32i(9, 3, 8));
+	BOOST_CHECK_EQUAL_COLLECTIONS(rowsC.begin(), rowsC.end(), rowsP.begin(), rowsP.end());
+
+	// reading backwards restarts the decompression
+	BOOST_CHECK_NO_THROW(rowsC = compressed.read32i(0, 0, 1));
+	BOOST_CHECK_EQUAL(rowsC[0], 0);
+	BOOST_CHECK_EQUAL(rowsC[1], 1);
+
+	BOOST_CHECK_NO_THROW(plain.close());
+	BOOST_CHECK_NO_THROW(compressed.close());
+}
+
+BOOST_AUTO_TEST_CASE(compressed_stream_checkpoints)
+{
+	// about 600K of text in two gzip members
+	const int NROWS = 60000;
+	gzFile gz = gzopen("big.txt.gz", "wb");
+	for(int i=0; i<NROWS; i++)
+	{
+		if(i == NROWS/2)
+		{
+			gzclose(gz);
+			gz = gzopen("big.txt.gz", "ab");
+		}
+		gzprintf(gz, "%d %d\n", i, (i*7919) % 10007);
+	}
+	gzclose(gz);
+
+	BOOST_CHECK_EQUAL(qlbase::CompressedStreamBuf::detect("big.txt.gz"), qlbase::CompressedStreamBuf::GZIP);
+	BOOST_CHECK_EQUAL(qlbase::CompressedStreamBuf::detect("sample.txt"), qlbase::CompressedStreamBuf::PLAIN);
+
+	// small blocks and checkpoints every 64K
+	qlbase::CompressedStreamBuf buff("big.txt.gz", qlbase::CompressedStreamBuf::GZIP, 4096, 2, 65536);
+	std::istream in(&buff);
+
+	std::vector<std::streamoff> offsets;
+	std::string line;
+	offsets.push_back(0);
+	while(std::getline(in, line))
+		offsets.push_back(offsets.back() + line.size() + 1);
+	offsets.pop_back();
+	BOOST_CHECK_EQUAL(offsets.size(), NROWS);
+	BOOST_CHECK(buff.getCheckpointNum() > 4);
+
+	// random access from the checkpoints
+	const int rows[] = { NROWS-1, 17, NROWS/2, NROWS/2-1, 40123, 0, 31 };
+	for(unsigned int i=0; i<sizeof(rows)/sizeof(rows[0]); i++)
+	{
+		in.clear();
+		in.seekg(offsets[rows[i]]);
+		BOOST_CHECK_EQUAL((long) in.tellg(), (long) offsets[rows[i]]);
+		int row, value;
+		in >> row >> value;
+		BOOST_CHECK_EQUAL(row, rows[i]);
+		BOOST_CHECK_EQUAL(value, (rows[i]*7919) % 10007);
+	}
+
+	unlink("big.txt.gz");
+}
+
+BOOST_AUTO_TEST_CASE(input_file_text_sidecar)
+{
+	std::ofstream out("indexed.txt");
+	out << "1, 2.5, abc\n2, 3, def\n3, 1e3, 4\n";
+	out.close();
+	unlink("indexed.txt.qlidx");
+
+	qlbase::InputFileText file(",");
+	file.useSidecarIndex();
+
+	// the first open should write the sidecar
+	BOOST_CHECK_NO_THROW(file.open("indexed.txt"));
+	BOOST_CHECK_EQUAL(access("indexed.txt.qlidx", R_OK), 0);
+	BOOST_CHECK_EQUAL(file.getNRows(), 3);
+	BOOST_CHECK_EQUAL(file.getColType(0), qlbase::INT64);
+	BOOST_CHECK_EQUAL(file.getColType(1), qlbase::DOUBLE);
+	BOOST_CHECK_EQUAL(file.getColType(2), qlbase::STRING);
+	BOOST_CHECK_NO_THROW(file.close());
+
+	// the next open should use it, giving the same result
+	BOOST_CHECK_NO_THROW(file.open("indexed.txt"));
+	BOOST_CHECK_EQUAL(file.getNRows(), 3);
+	BOOST_CHECK_EQUAL(file.getNCols(), 3);
+	BOOST_CHECK_EQUAL(file.getColType(1), qlbase::DOUBLE);
+	std::vector<double> values;
+	BOOST_CHECK_NO_THROW(values = file.read64f(1, 1, 2));
+	BOOST_CHECK_CLOSE(values[0], 3.0, 0.001);
+	BOOST_CHECK_CLOSE(values[1], 1000.0, 0.001);
+	BOOST_CHECK_NO_THROW(file.close());
+
+	// a changed file should rebuild the sidecar
+	out.open("indexed.txt", std::ios::app);
+	out << "4, 5, ghi\n";
+	out.close();
+	BOOST_CHECK_NO_THROW(file.open("indexed.txt"));
+	BOOST_CHECK_EQUAL(file.getNRows(), 4);
+	std::vector<int64_t> ids;
+	BOOST_CHECK_NO_THROW(ids = file.read64i(0, 3, 3));
+	BOOST_CHECK_EQUAL(ids[0], 4);
+	BOOST_CHECK_NO_THROW(file.close());
+
+	unlink("indexed.txt");
+	unlink("indexed.txt.qlidx");
+}
+
+BOOST_AUTO_TEST_CASE(input_file_text_image)
+{
+	qlbase::InputFileText file;
+	BOOST_CHECK_NO_THROW(file.open("img.csv"));
+
+	// the image should have the img.csv rows and columns
+	qlbase::Image<float> img;
+	BOOST_CHECK_NO_THROW(img = file.readImage32f());
+	BOOST_CHECK_EQUAL(img.dim, 2);
+	BOOST_CHECK_EQUAL(img.sizes[0], 300);
+	BOOST_CHECK_EQUAL(img.sizes[1], 300);
+	BOOST_CHECK_EQUAL(img.data.size(), 90000);
+
+	// image values should be like the ones stored in the img.csv file.
+	std::ifstream imgfile("img.csv");
+	std::string row;
+	for(long i=0; std::getline(imgfile, row); i++)
+	{
+		std::stringstream ss;
+		for(long j=0; j<img.sizes[0]; j++)
+			ss << (j ? " " : "") << std::fixed << std::setprecision(5) << img.data[i*img.sizes[0]+j];
+		BOOST_CHECK_EQUAL(ss.str(), row);
+	}
+	BOOST_CHECK_NO_THROW(file.close());
+
+	// empty lines should split the image in planes
+	std::ofstream out("cube.txt");
+	out << "1 2 3\n4 5 6\n\n7 8 9\n10 11 12\n\n13 14 15\n16 17 1.8e1\n";
+	out.close();
+	BOOST_CHECK_NO_THROW(file.open("cube.txt"));
+	qlbase::Image<int16_t> cube;
+	BOOST_CHECK_NO_THROW(cube = file.readImage16i());
+	BOOST_CHECK_EQUAL(cube.dim, 3);
+	BOOST_CHECK_EQUAL(cube.sizes[0], 3);
+	BOOST_CHECK_EQUAL(cube.sizes[1], 2);
+	BOOST_CHECK_EQUAL(cube.sizes[2], 3);
+	for(int i=0; i<18; i++)
+		BOOST_CHECK_EQUAL(cube.data[i], i+1);
+	BOOST_CHECK_NO_THROW(file.close());
+
+	// planes with different sizes or rows with missing values should raise an exception
+	out.open("cube.txt");
+	out << "1 2 3\n4 5 6\n\n7 8 9\n";
+	out.close();
+	BOOST_CHECK_NO_THROW(file.open("cube.txt"));
+	BOOST_CHECK_THROW(cube = file.readImage16i(), qlbase::IOException);
+	BOOST_CHECK_NO_THROW(file.close());
+
+	out.open("cube.txt");
+	out << "1 2 3\n4 5\n";
+	out.close();
+	BOOST_CHECK_NO_THROW(file.open("cube.txt"));
+	BOOST_CHECK_THROW(cube = file.readImage16i(), qlbase::IOException);
+	BOOST_CHECK_NO_THROW(file.close());
+
+	// values out of the pixel type range should raise an exception, not wrap
+	out.open("cube.txt");
+	out << "1 2 300\n-1 255 2.55e2\n";
+	out.close();
+	BOOST_CHECK_NO_THROW(file.open("cube.txt"));
+	BOOST_CHECK_THROW(file.readImageu8i(), qlbase::IOException);
+	BOOST_CHECK_NO_THROW(cube = file.readImage16i());
+	BOOST_CHECK_EQUAL(cube.data[2], 300);
+	BOOST_CHECK_EQUAL(cube.data[5], 255);
+	BOOST_CHECK_NO_THROW(file.close());
+
+	out.open("cube.txt");
+	out << "1 2 1e40\n";
+	out.close();
+	BOOST_CHECK_NO_THROW(file.open("cube.txt"));
+	BOOST_CHECK_THROW(file.readImage32f(), qlbase::IOException);
+	BOOST_CHECK_THROW(file.readImage64i(), qlbase::IOException);
+	BOOST_CHECK_NO_THROW(file.readImage64f());
+	BOOST_CHECK_NO_THROW(file.close());
+
+	unlink("cube.txt");
+}
+
+BOOST_AUTO_TEST_CASE(output_file_text)
+{
+	qlbase::OutputFileText file(",");
+	file.writeColumnNames();
+
+	// writing on a closed file should raise an exception
+	std::vector<int32_t> ids(3);
+	BOOST_CHECK_THROW(file.write32i(0, ids, 0, 2), qlbase::IOException);
+
+	BOOST_CHECK_NO_THROW(file.create("output.csv"));
+	BOOST_CHECK_EQUAL(file.isOpened(), true);
+
+	std::vector<qlbase::field> fields(4);
+	fields[0].name = "id";    fields[0].type = qlbase::INT32;  fields[0].vsize = 1;
+	fields[1].name = "value"; fields[1].type = qlbase::DOUBLE; fields[1].vsize = 1;
+	fields[2].name = "pos";   fields[2].type = qlbase::FLOAT;  fields[2].vsize = 2;
+	fields[3].name = "label"; fields[3].type = qlbase::STRING; fields[3].vsize = 8;
+	BOOST_CHECK_NO_THROW(file.createTable("TABLE", fields));
+
+	// columns can be written in any order
+	std::vector<double> values(3);
+	values[0] = 0.1; values[1] = -1e-300; values[2] = 1.0/3.0;
+	BOOST_CHECK_NO_THROW(file.write64f(1, values, 0, 2));
+	ids[0] = -7; ids[1] = 0; ids[2] = 2147483647;
+	BOOST_CHECK_NO_THROW(file.write32i(0, ids, 0, 2));
+	std::vector< std::vector<float> > pos(3, std::vector<float>(2));
+	pos[0][0] = 1.5f; pos[0][1] = 0.1f; pos[1][0] = 3e38f; pos[1][1] = -2.f; pos[2][0] = 1.f/3.f; pos[2][1] = 0.f;
+	BOOST_CHECK_NO_THROW(file.write32fv(2, pos, 0, 1));
+	const float lastPos[] = { 1.f/3.f, 0.f };
+	BOOST_CHECK_NO_THROW(file.write32fv(2, lastPos, 2, 2, 2));
+	std::vector< std::vector<char> > labels(3);
+	std::string l0("abc"), l1("a,b"), l2("say \"hi\"");
+	labels[0].assign(l0.begin(), l0.end());
+	labels[1].assign(l1.begin(), l1.end());
+	labels[2].assign(l2.begin(), l2.begin()+8);
+	BOOST_CHECK_NO_THROW(file.writeString(3, labels, 0, 2));
+
+	// wrong vector sizes and types should raise an exception
+	std::vector< std::vector<float> > pos3(3, std::vector<float>(3));
+	BOOST_CHECK_THROW(file.write32fv(2, pos3, 0, 2), qlbase::IOException);
+	BOOST_CHECK_THROW(file.write32i(3, ids, 0, 2), qlbase::IOException);
+
+	// failed writes should not add rows
+	BOOST_CHECK_THROW(file.write32i(3, ids, 3, 5), qlbase::IOException);
+	BOOST_CHECK_THROW(file.writeString(0, labels, 3, 5), qlbase::IOException);
+	std::vector< std::vector<float> > ragged(pos);
+	ragged[2].resize(1);
+	BOOST_CHECK_THROW(file.write32fv(2, ragged, 3, 5), qlbase::IOException);
+	std::vector<int32_t> noIds;
+	BOOST_CHECK_THROW(file.write32i(0, noIds, 3, 5), qlbase::IOException);
+	BOOST_CHECK_THROW(file.write32i(0, ids, 3, 6), qlbase::IOException);
+
+	BOOST_CHECK_NO_THROW(file.close());
+	BOOST_CHECK_EQUAL(file.isOpened(), false);
+
+	std::ifstream in("output.csv");
+	std::string line;
+	std::getline(in, line);
+	BOOST_CHECK_EQUAL(line, "id,value,pos_0,pos_1,label");
+	std::getline(in, line);
+	BOOST_CHECK_EQUAL(line, "-7,0.1,1.5,0.1,abc");
+	std::getline(in, line);
+	BOOST_CHECK_EQUAL(line, "0,-1e-300,3e+38,-2,\"a,b\"");
+	std::getline(in, line);
+	BOOST_CHECK_EQUAL(line, "2147483647,0.3333333333333333,0.33333334,0,\"say \"\"hi\"\"\"");
+	BOOST_CHECK(!std::getline(in, line));
+	in.close();
+
+	// the destructor should write the buffered rows
+	{
+		qlbase::OutputFileText unclosed(",");
+		BOOST_CHECK_NO_THROW(unclosed.create("output.csv"));
+		std::vector<qlbase::field> idField(1, fields[0]);
+		BOOST_CHECK_NO_THROW(unclosed.createTable("TABLE", idField));
+		BOOST_CHECK_NO_THROW(unclosed.write32i(0, ids, 0, 2));
+	}
+	in.open("output.csv");
+	std::getline(in, line);
+	BOOST_CHECK_EQUAL(line, "-7");
+	in.close();
+
+	// many rows should be formatted in blocks and read back the same values
+	const long NROWS = 200000;
+	fields.resize(2);
+	BOOST_CHECK_NO_THROW(file.create("output.csv"));
+	BOOST_CHECK_NO_THROW(file.createTable("TABLE", fields));
+	std::vector<int32_t> manyIds(NROWS);
+	std::vector<double> manyValues(NROWS);
+	for(long i=0; i<NROWS; i++) {
+		manyIds[i] = i;
+		manyValues[i] = i / 7.0;
+	}
+	for(long frow=0; frow<NROWS; frow+=50000) {
+		std::vector<int32_t> blockIds(manyIds.begin()+frow, manyIds.begin()+frow+50000);
+		std::vector<double> blockValues(manyValues.begin()+frow, manyValues.begin()+frow+50000);
+		BOOST_CHECK_NO_THROW(file.write32i(0, blockIds, frow, frow+49999));
+		BOOST_CHECK_NO_THROW(file.write64f(1, blockValues, frow, frow+49999));
+	}
+	// rows already written can't be written again
+	BOOST_CHECK_THROW(file.write32i(0, manyIds, 0, 9), qlbase::IOException);
+	BOOST_CHECK_NO_THROW(file.close());
+
+	file.writeColumnNames(false);
+	BOOST_CHECK_NO_THROW(file.open("output.csv"));
+	fields.resize(1);
+	BOOST_CHECK_NO_THROW(file.createTable("TABLE", fields));
+	BOOST_CHECK_NO_THROW(file.close());
+
+	qlbase::InputFileText input(",");
+	BOOST_CHECK_NO_THROW(input.open("output.csv"));
+	BOOST_CHECK_EQUAL(input.getNRows(), NROWS+1);
+	std::vector<double> readValues;
+	BOOST_CHECK_NO_THROW(readValues = input.read64f(1, 1, NROWS));
+	bool same = true;
+	for(long i=0; i<NROWS && same; i++)
+		same = readValues[i] == manyValues[i];
+	BOOST_CHECK(same);
+	BOOST_CHECK_NO_THROW(input.close());
+
+	unlink("output.csv");
+}
+
+BOOST_AUTO_TEST_CASE(field_types)
+{
+	BOOST_CHECK_EQUAL(qlbase::getTypeSize(qlbase::UNSIGNED_INT8), 1u);
+	BOOST_CHECK_EQUAL(qlbase::getTypeSize(qlbase::INT16), 2u);
+	BOOST_CHECK_EQUAL(qlbase::getTypeSize(qlbase::FLOAT), 4u);
+	BOOST_CHECK_EQUAL(qlbase::getTypeSize(qlbase::INT64), 8u);
+	BOOST_CHECK_EQUAL(qlbase::getTypeSize(qlbase::LOGICAL), 1u);
+	BOOST_CHECK_EQUAL(qlbase::getTypeSize(qlbase::BIT), 1u);
+
+	double values[3] = { 1.75, -2, 300 };
+	char buff[24];
+	double back[3];
+	qlbase::storeAs(qlbase::INT16, buff, values, 3);
+	qlbase::loadAs(qlbase::INT16, back, buff, 3);
+	BOOST_CHECK_EQUAL(back[0], 1);
+	BOOST_CHECK_EQUAL(back[1], -2);
+	BOOST_CHECK_EQUAL(back[2], 300);
+	qlbase::storeAs(qlbase::DOUBLE, buff, values, 3);
+	qlbase::loadAs(qlbase::DOUBLE, back, buff, 3);
+	BOOST_CHECK_EQUAL(back[0], 1.75);
+}
+
+BOOST_AUTO_TEST_CASE(array_view)
+{
+	// a 4x3x2 cube, value x + 4*y + 12*z
+	qlbase::Image<int32_t> cube;
+	std::vector<int64_t> sizes;
+	sizes.push_back(4);
+	sizes.push_back(3);
+	sizes.push_back(2);
+	cube.resize(sizes);
+	for(int i=0; i<24; i++)
+		cube.data[i] = i;
+	BOOST_CHECK_EQUAL(cube.dim, 3);
+	BOOST_CHECK_EQUAL(((uintptr_t) &cube.data[0]) % 64, 0);
+
+	qlbase::ArrayView<int32_t> view = cube.view();
+	BOOST_CHECK(view.isContiguous());
+	BOOST_CHECK_EQUAL(view.count(), 24);
+	BOOST_CHECK_EQUAL(view(3, 2, 1), 23);
+
+	// crops and planes are views of the same values
+	qlbase::ArrayView<int32_t> plane = view.plane(2, 1);
+	BOOST_CHECK_EQUAL(plane.getDim(), 2);
+	BOOST_CHECK_EQUAL(plane(1, 2), 1 + 8 + 12);
+	qlbase::ArrayView<int32_t> box = plane.crop(0, 1, 3, 2).crop(1, 1, 2);
+	BOOST_CHECK(!box.isContiguous());
+	BOOST_CHECK_EQUAL(box.getSize(0), 2);
+	BOOST_CHECK_EQUAL(box.getSize(1), 2);
+	box(0, 0) = -1;
+	BOOST_CHECK_EQUAL(cube.data[1 + 4 + 12], -1);
+	box(0, 0) = 17;
+
+	qlbase::Image<int32_t> copy = qlbase::copyImage(box);
+	int32_t expected[] = { 17, 19, 21, 23 };
+	BOOST_CHECK_EQUAL_COLLECTIONS(copy.data.begin(), copy.data.end(), expected, expected + 4);
+
+	// the rows of the transposed plane z = 0 are the columns of the plane
+	qlbase::Image<int32_t> columns = qlbase::copyImage(view.plane(2, 0).transpose());
+	BOOST_CHECK_EQUAL(columns.sizes[0], 3);
+	BOOST_CHECK_EQUAL(columns.sizes[1], 4);
+	BOOST_CHECK_EQUAL(columns.data[1], 4);
+	BOOST_CHECK_EQUAL(columns.data[3], 1);
+
+	// sum of the planes, and maximum along y
+	qlbase::Image<double> sum = qlbase::reduceSum<double>(view, 2);
+	BOOST_CHECK_EQUAL(sum.dim, 2);
+	BOOST_CHECK_EQUAL(sum.data.size(), 12);
+	for(int i=0; i<12; i++)
+		BOOST_CHECK_EQUAL(sum.data[i], 2*i + 12);
+	qlbase::Image<int32_t> max = qlbase::reduceMax(qlbase::ArrayView<const int32_t>(view), 1);
+	BOOST_CHECK_EQUAL(max.sizes[0], 4);
+	BOOST_CHECK_EQUAL(max.sizes[1], 2);
+	BOOST_CHECK_EQUAL(max.data[0], 8);
+	BOOST_CHECK_EQUAL(max.data[7], 23);
+	qlbase::Image<int32_t> min = qlbase::reduceMin(view, 0);
+	BOOST_CHECK_EQUAL(min.data[5], 20);
+
+	BOOST_CHECK_THROW(view.crop(0, 2, 4), qlbase::IOException);
+	BOOST_CHECK_THROW(view.plane(3, 0), qlbase::IOException);
+	BOOST_CHECK_THROW(qlbase::reduceSum<double>(view, 3), qlbase::IOException);
+}
+
+BOOST_AUTO_TEST_CASE(buffer_pool)
+{
+	qlbase::BufferPool pool;
+	void* a = pool.allocate(1000);
+	BOOST_CHECK_EQUAL(((uintptr_t) a) % 64, 0);
+	qlbase::BufferPool::Stats stats = pool.getStats();
+	BOOST_CHECK_EQUAL(stats.misses, 1);
+	BOOST_CHECK_EQUAL(stats.bytesOutstanding, 1024);
+
+	// the buffers of a size class are reused
+	pool.release(a, 1000);
+	void* b = pool.allocate(600);
+	BOOST_CHECK(a == b);
+	void* c = pool.allocate(600);
+	stats = pool.getStats();
+	BOOST_CHECK_EQUAL(stats.hits, 1);
+	BOOST_CHECK_EQUAL(stats.misses, 2);
+	BOOST_CHECK_EQUAL(stats.highWater, 2048);
+	pool.release(b, 600);
+	pool.release(c, 600);
+	stats = pool.getStats();
+	BOOST_CHECK_EQUAL(stats.bytesOutstanding, 0);
+	BOOST_CHECK_EQUAL(stats.bytesCached, 2048);
+
+	// the buffers of an exited thread are given to the other threads
+	void* d = 0;
+	std::thread worker([&pool, &d]() { d = pool.allocate(100000); pool.release(d, 100000); });
+	worker.join();
+	BOOST_CHECK(pool.allocate(100000) == d);
+	pool.release(d, 100000);
+
+	// buffers bigger than the thread cache are not cached, and the shared
+	// cache is bounded
+	qlbase::BufferPool small(1 << 16, 1 << 17);
+	void* big = small.allocate(100000);
+	BOOST_CHECK_EQUAL(small.getBufferSize(100000), 100000);
+	small.release(big, 100000);
+	BOOST_CHECK_EQUAL(small.getStats().bytesCached, 0);
+	std::vector<void*> buffers;
+	for(int i=0; i<8; i++)
+		buffers.push_back(small.allocate(1 << 15));
+	std::thread releaser([&small, &buffers]() {
+		for(int i=0; i<8; i++)
+			small.release(buffers[i], 1 << 15);
+	});
+	releaser.join();
+	BOOST_CHECK_EQUAL(small.getStats().bytesCached, 1 << 17);
+
+	// the arena gives back all its blocks at once
+	{
+		qlbase::Arena arena(4096, pool);
+		char* s = arena.copy("TIME");
+		BOOST_CHECK_EQUAL(std::string(s), "TIME");
+		double* values = arena.allocate<double>(10000);
+		values[9999] = 1.0;
+		BOOST_CHECK_EQUAL(arena.getBytes(), 4096 + 80000);
+	}
+	BOOST_CHECK_EQUAL(pool.getStats().bytesOutstanding, 0);
+
+	// image pixels come from the default pool and go back to it
+	qlbase::BufferPool images;
+	qlbase::BufferPool::setDefault(&images);
+	{
+		qlbase::Image<float> img;
+		img.data.resize(1000);
+		BOOST_CHECK_EQUAL(images.getStats().bytesOutstanding, 4096);
+	}
+	BOOST_CHECK_EQUAL(images.getStats().bytesOutstanding, 0);
+	qlbase::BufferPool::setDefault(0);
+}
+
+BOOST_AUTO_TEST_CASE(memory_budget)
+{
+	qlbase::MemoryBudget node("node", 1 << 20);
+	qlbase::MemoryBudget reader("reader", 512 << 10, &node);
+	BOOST_CHECK(reader.tryCharge(256 << 10));
+	BOOST_CHECK_EQUAL(node.getUsed(), 256 << 10);
+	BOOST_CHECK_CLOSE(reader.getPressure(), 0.5, 1e-9);
+	BOOST_CHECK_EQUAL(reader.getAvailable(), 256 << 10);
+	BOOST_CHECK(!reader.tryCharge(300 << 10));
+	BOOST_CHECK_THROW(reader.charge(300 << 10), qlbase::IOException);
+	BOOST_CHECK_EQUAL(reader.getStats().refused, 2);
+	reader.release(256 << 10);
+	BOOST_CHECK_EQUAL(node.getUsed(), 0);
+	BOOST_CHECK_EQUAL(node.getStats().peak, 256 << 10);
+
+	// the images read are charged to the reader budget
+	qlbase::InputFileText file;
+	BOOST_CHECK_NO_THROW(file.open("img.csv"));
+	file.setMemoryBudget(&reader);
+	{
+		qlbase::Image<float> img;
+		BOOST_CHECK_NO_THROW(img = file.readImage32f());
+		// the whole 512 KB buffer of the pool is charged
+		BOOST_CHECK_EQUAL(reader.getUsed(), 512 << 10);
+	}
+	BOOST_CHECK_EQUAL(reader.getUsed(), 0);
+	reader.setLimit(100000);
+	BOOST_CHECK_THROW(file.readImage32f(), qlbase::IOException);
+	BOOST_CHECK_NO_THROW(file.close());
+
+	// the cached buffers are charged, and freed to make room
+	qlbase::MemoryBudget tight("tight", 1 << 16);
+	{
+		qlbase::BufferPool cache(4 << 20, 16 << 20, &tight);
+		void* x = cache.allocate(1 << 15);
+		void* y = cache.allocate(1 << 15);
+		void* z = cache.allocate(1 << 15);
+		cache.release(x, 1 << 15);
+		cache.release(y, 1 << 15);
+		cache.release(z, 1 << 15);
+		BOOST_CHECK_EQUAL(cache.getStats().bytesCached, 1 << 16);
+		BOOST_CHECK_EQUAL(tight.getUsed(), 1 << 16);
+
+		qlbase::BufferPool::setDefault(&cache);
+		{
+			qlbase::Image<uint8_t> img(&tight);
+			BOOST_CHECK_NO_THROW(img.data.resize(1 << 15));
+			BOOST_CHECK_EQUAL(tight.getUsed(), 1 << 15);
+			BOOST_CHECK_EQUAL(cache.getStats().bytesCached, 0);
+		}
+		qlbase::BufferPool::setDefault(0);
+	}
+	BOOST_CHECK_EQUAL(tight.getUsed(), 0);
+
+	// without a scratch directory the chunks over the budget are refused
+	qlbase::MemoryBudget tables("tables", 256 << 10);
+	{
+		qlbase::ChunkStore store(tables);
+		BOOST_CHECK_NO_THROW(store.add(200 << 10));
+		BOOST_CHECK_THROW(store.add(100 << 10), qlbase::IOException);
+	}
+	BOOST_CHECK_EQUAL(tables.getUsed(), 0);
+
+	// with one, the least recently used chunks are spilled and stay readable
+	qlbase::ChunkStore store(tables, ".");
+	std::vector<int> chunks;
+	for(int i=0; i<4; i++) {
+		std::vector<int32_t> values(25000, i);
+		chunks.push_back(store.add(&values[0], values.size() * sizeof(int32_t)));
+		store.get(chunks[0]);
+	}
+	BOOST_CHECK(!store.isSpilled(chunks[0]));
+	BOOST_CHECK(store.isSpilled(chunks[1]));
+	BOOST_CHECK(tables.getUsed() <= 256 << 10);
+	BOOST_CHECK_EQUAL(store.getMemoryBytes(), tables.getUsed());
+	for(int i=0; i<4; i++) {
+		int32_t* values = (int32_t*) store.get(chunks[i]);
+		BOOST_CHECK_EQUAL(values[0], i);
+		BOOST_CHECK_EQUAL(values[24999], i);
+	}
+	BOOST_CHECK(store.spill(1) > 0);
+	store.remove(chunks[1]);
+	BOOST_CHECK_THROW(store.get(chunks[1]), qlbase::IOException);
+}